@@ -0,0 +1,103 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_BENCHMARK_H
+#define AUTOPLAY_BENCHMARK_H
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoplay {
+    namespace bench {
+        using Function = std::function<void()>;
+
+        /**
+         * Get all registered benchmarks.
+         * @return A vector of <name, function> pairs, in order of registration.
+         */
+        inline std::vector<std::pair<std::string, Function>>& registry() {
+            static std::vector<std::pair<std::string, Function>> benchmarks;
+            return benchmarks;
+        }
+
+        /**
+         * Get the path the benchmarks have been started with (argv[0]), e.g. to find the config folder next to it.
+         * @return The path; it is set by main().
+         */
+        inline std::string& program() {
+            static std::string path;
+            return path;
+        }
+
+        /**
+         * Register a benchmark. Use the BENCHMARK macro instead.
+         * @param name  The name of the benchmark.
+         * @param f     The benchmark function.
+         * @return true
+         */
+        inline bool add(const std::string& name, const Function& f) {
+            registry().emplace_back(name, f);
+            return true;
+        }
+
+        /**
+         * Time a function.
+         * @param f         The function to time.
+         * @param repeat    The amount of times to run the function. The fastest run is kept.
+         * @return The duration of the fastest run, in seconds.
+         */
+        template <typename F>
+        double measure(F&& f, unsigned int repeat = 3) {
+            double best = -1.0;
+            for(unsigned int r = 0; r < repeat; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                f();
+                std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+                if(best < 0.0 || d.count() < best) {
+                    best = d.count();
+                }
+            }
+            return best;
+        }
+
+        /**
+         * Print a single result line.
+         * @param label     What has been measured.
+         * @param n         The amount of items that were processed.
+         * @param seconds   The time it took to process all items.
+         */
+        inline void report(const std::string& label, std::size_t n, double seconds) {
+            std::printf("  %-40s %10zu items %12.3f ms %12.1f ns/item\n", label.c_str(), n, seconds * 1e3,
+                        n == 0 ? 0.0 : seconds * 1e9 / n);
+        }
+    }
+}
+
+/**
+ * Define and register a benchmark, in the same fashion as a gtest TEST.
+ */
+#define BENCHMARK(group, name)                                                                                        \
+    static void group##_##name##_Benchmark();                                                                        \
+    static bool group##_##name##_registered =                                                                        \
+        autoplay::bench::add(#group "." #name, &group##_##name##_Benchmark);                                         \
+    static void group##_##name##_Benchmark()
+
+#endif // AUTOPLAY_BENCHMARK_H
@@ -0,0 +1,23 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "Benchmark.h"
+
+#include <cstdio>
+
+/**
+ * Run all benchmarks, or only those whose name contains the first argument.
+ */
+int main(int argc, char** argv) {
+    autoplay::bench::program() = argv[0];
+    std::string filter         = argc > 1 ? argv[1] : "";
+    for(const auto& b : autoplay::bench::registry()) {
+        if(b.first.find(filter) == std::string::npos) {
+            continue;
+        }
+        std::printf("[ RUN ] %s\n", b.first.c_str());
+        b.second();
+    }
+    return 0;
+}
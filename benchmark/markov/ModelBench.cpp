@@ -0,0 +1,268 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "../../main/markov/ChainAnalysis.h"
+#include "../../main/markov/ChainBatch.h"
+#include "../../main/markov/MarkovChain.h"
+#include "../Benchmark.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace autoplay;
+
+namespace {
+    volatile std::size_t sink; ///< Keeps the compiler from removing the loads
+
+    /**
+     * Create a transition matrix in which each State can go to about a quarter of all States.
+     * @param n The amount of States.
+     * @return The (unnormalized) matrix.
+     */
+    markov::NamedMatrix model(std::size_t n) {
+        std::vector<std::string> states;
+        for(std::size_t i = 0; i < n; ++i) {
+            states.emplace_back("S" + std::to_string(i));
+        }
+        markov::NamedMatrix m{states, states};
+        for(std::size_t r = 0; r < n; ++r) {
+            for(std::size_t c = r % 4; c < n; c += 4) {
+                m.at(states[r], states[c]) = (double)((r * 31 + c * 17) % 13 + 1);
+            }
+        }
+        return m;
+    }
+}
+
+BENCHMARK(ModelBench, LoadModel) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+
+    for(std::size_t n : {50, 200, 800}) {
+        auto csv    = (dir / ("model" + std::to_string(n) + ".csv")).string();
+        auto binary = (dir / ("model" + std::to_string(n) + ".apm")).string();
+        auto m      = model(n);
+        m.toCSV(csv);
+        m.normalizeRows();
+        markov::TransitionTable{m}.save(binary);
+
+        util::RNEngine gen;
+        gen("lcg64", 1);
+
+        // Parse the CSV file and build the table
+        double text = bench::measure([&]() {
+            markov::MarkovChain chain{csv, gen, "S0"};
+            sink = chain.next();
+        });
+
+        // Map the binary model and use it in place
+        double mapped = bench::measure([&]() {
+            markov::MarkovChain chain{binary, gen, "S0"};
+            sink = chain.next();
+        });
+
+        bench::report(std::to_string(n) + " states (CSV)", n, text);
+        bench::report(std::to_string(n) + " states (binary model)", n, mapped);
+    }
+
+    boost::filesystem::remove_all(dir);
+}
+
+BENCHMARK(ModelBench, ProjectModel) {
+    // Restrict a 500-state pitch model to the range of a stave
+    const std::size_t        n = 500;
+    auto                     m = model(n);
+    std::vector<std::string> keep;
+    std::vector<std::string> erase;
+    for(std::size_t i = 0; i < n; ++i) {
+        (i >= 200 && i < 260 ? keep : erase).emplace_back("S" + std::to_string(i));
+    }
+
+    // Drop each State separately, renumbering the indexes every time
+    double dropped = bench::measure([&]() {
+        auto copy = m;
+        for(const auto& s : erase) {
+            copy.dropColumn(s);
+            copy.dropRow(s);
+        }
+        sink = copy.getRows().size();
+    });
+
+    // Build the reduced matrix in a single pass
+    double projected = bench::measure([&]() { sink = m.project(keep, keep).getRows().size(); });
+
+    bench::report("keep 60 of 500 states (drop one by one)", erase.size(), dropped);
+    bench::report("keep 60 of 500 states (project)", erase.size(), projected);
+}
+
+BENCHMARK(ModelBench, AnalyzeModel) {
+    // About the sizes of the chord, rhythm and pitch models in learning/
+    for(std::size_t n : {31, 80, 180}) {
+        auto m = model(n);
+        m.normalizeRows();
+        markov::TransitionTable table{m};
+
+        double stationary = bench::measure([&]() {
+            markov::ChainAnalysis analysis{table};
+            sink = (std::size_t)(analysis.stationary().front() * 1e6);
+        });
+        double histogram = bench::measure([&]() {
+            markov::ChainAnalysis analysis{table};
+            sink = (std::size_t)analysis.histogram("S0", 100).front();
+        });
+        double power = bench::measure([&]() {
+            markov::ChainAnalysis analysis{table};
+            sink = (std::size_t)(analysis.power(64).front() * 1e6);
+        });
+
+        bench::report(std::to_string(n) + " states (stationary)", n, stationary);
+        bench::report(std::to_string(n) + " states (histogram of 100)", n, histogram);
+        bench::report(std::to_string(n) + " states (64 steps)", n, power);
+    }
+}
+
+BENCHMARK(ModelBench, TrainMidi) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir / "midi");
+    boost::filesystem::create_directories(dir / "xml");
+
+    // The same melody of quarter notes, as a Standard MIDI File and as MusicXML
+    const std::size_t n = 20000;
+    const char*       steps[12] = {"C", "D", "D", "E", "E", "F", "G", "G", "A", "A", "B", "B"};
+    const int         alters[12] = {0, -1, 0, -1, 0, 0, -1, 0, -1, 0, -1, 0};
+
+    std::vector<uint8_t> track;
+    std::string          xml = "<score-partwise><part id=\"P1\">";
+    for(std::size_t i = 0; i < n; ++i) {
+        auto pitch = (uint8_t)(48 + (i * 7 + i / 5) % 30);
+        track.insert(track.end(), {0x00, 0x90, pitch, 0x64, 0x60, 0x80, pitch, 0x40});
+
+        if(i % 4 == 0) {
+            xml += i == 0 ? "<measure><attributes><divisions>64</divisions></attributes>" : "</measure><measure>";
+        }
+        xml += std::string("<note><pitch><step>") + steps[pitch % 12] + "</step><alter>" +
+               std::to_string(alters[pitch % 12]) + "</alter><octave>" + std::to_string(pitch / 12 - 1) +
+               "</octave></pitch><duration>64</duration></note>";
+    }
+    track.insert(track.end(), {0x00, 0xFF, 0x2F, 0x00});
+    xml += "</measure></part></score-partwise>";
+
+    {
+        auto                 size = (uint32_t)track.size();
+        std::vector<uint8_t> data = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96, 'M', 'T', 'r', 'k',
+                                     (uint8_t)(size >> 24), (uint8_t)(size >> 16), (uint8_t)(size >> 8),
+                                     (uint8_t)size};
+        data.insert(data.end(), track.begin(), track.end());
+        std::ofstream midi{(dir / "midi" / "melody.mid").string(), std::ios::binary};
+        midi.write((const char*)data.data(), data.size());
+        std::ofstream score{(dir / "xml" / "melody.xml").string()};
+        score << xml;
+    }
+
+    double from_midi = bench::measure([&]() {
+        sink = markov::MarkovChain::generateMatrices(dir / "midi", true, 2).front().getRows().size();
+    });
+    double from_xml = bench::measure([&]() {
+        sink = markov::MarkovChain::generateMatrices(dir / "xml", true, 2).front().getRows().size();
+    });
+
+    bench::report("20000 notes, order 2 (Standard MIDI File)", n, from_midi);
+    bench::report("20000 notes, order 2 (MusicXML)", n, from_xml);
+
+    boost::filesystem::remove_all(dir);
+}
+
+BENCHMARK(ModelBench, RetrainCached) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir / "scores");
+    auto cache = (dir / "cache").string();
+
+    // A corpus of 100 scores of 500 quarter notes each
+    const std::size_t files = 100;
+    const std::size_t n     = 500;
+    const char*       steps = "CDEFGAB";
+    for(std::size_t f = 0; f < files; ++f) {
+        std::ofstream score{(dir / "scores" / ("score-" + std::to_string(f) + ".xml")).string()};
+        score << "<score-partwise><part id=\"P1\"><measure><attributes><divisions>64</divisions></attributes>";
+        for(std::size_t i = 0; i < n; ++i) {
+            auto p = (i * 5 + f + i / 7) % 21;
+            score << "<note><pitch><step>" << steps[p % 7] << "</step><octave>" << 3 + p / 7
+                  << "</octave></pitch><duration>" << 32 * (1 + (i + f) % 3) << "</duration></note>";
+        }
+        score << "</measure></part></score-partwise>";
+    }
+
+    double uncached = bench::measure([&]() {
+        sink = markov::MarkovChain::generateMatrices(dir / "scores", true, 2).front().getRows().size();
+    });
+    double cold = bench::measure([&]() {
+        boost::filesystem::remove_all(cache);
+        sink = markov::MarkovChain::generateMatrices(dir / "scores", true, 2, 1, cache).front().getRows().size();
+    });
+    double warm = bench::measure([&]() {
+        sink = markov::MarkovChain::generateMatrices(dir / "scores", true, 2, 1, cache).front().getRows().size();
+    });
+
+    bench::report("100 scores, order 2 (no cache)", files, uncached);
+    bench::report("100 scores, order 2 (empty cache)", files, cold);
+    bench::report("100 scores, order 2 (filled cache)", files, warm);
+
+    boost::filesystem::remove_all(dir);
+}
+
+BENCHMARK(ModelBench, BatchSampling) {
+    // A model of the size of the pitch model in learning/, sampled by many chains at once
+    util::RNEngine gen;
+    gen("lcg64", 1);
+    markov::MarkovChain model{::model(180), gen, "S0"};
+    const std::size_t   steps = 256;
+
+    for(std::size_t n : {16, 256, 4096}) {
+        // Each chain is advanced on its own, with its own seed
+        std::vector<markov::MarkovChain> chains;
+        for(std::size_t c = 0; c < n; ++c) {
+            util::RNEngine seeded;
+            seeded("lcg64", c + 1);
+            chains.emplace_back(model, seeded);
+        }
+        double scalar = bench::measure([&]() {
+            for(auto& chain : chains) {
+                chain.reset();
+            }
+            for(std::size_t s = 0; s < steps; ++s) {
+                for(auto& chain : chains) {
+                    sink = chain.next();
+                }
+            }
+        });
+
+        // All chains are advanced in lockstep
+        markov::ChainBatch batch{model, n, gen};
+        double lockstep = bench::measure([&]() {
+            batch.reset();
+            for(std::size_t s = 0; s < steps; ++s) {
+                sink = batch.next().back();
+            }
+        });
+
+        auto samples = n * steps;
+        bench::report(std::to_string(n) + " chains (one by one)", samples, scalar);
+        bench::report(std::to_string(n) + " chains (batch)", samples, lockstep);
+        std::printf("  %-40s %10.2f M samples/s %10.2f M samples/s\n", (std::to_string(n) + " chains").c_str(),
+                    samples / scalar * 1e-6, samples / lockstep * 1e-6);
+    }
+}
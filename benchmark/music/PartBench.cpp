@@ -0,0 +1,108 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/music/Score.h"
+#include "../../main/util/Generator.h"
+#include "../../main/util/RNEngine.h"
+#include "../../main/util/Randomizer.h"
+#include "../Benchmark.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace autoplay;
+
+/**
+ * Builds a Score part by part, in the same way the Generator does: for every new Chord, all Chords that are
+ * playing at that time in the previous Parts are looked up.
+ */
+static std::size_t buildScore(unsigned int parts, unsigned int measures) {
+    util::RNEngine gen;
+    gen("mt19937", 0);
+
+    music::Score score{pt::ptree{}};
+    auto         instrument = std::make_shared<music::Instrument>("", 1, 1, 0);
+    std::size_t  lookups    = 0;
+    for(unsigned int i = 0; i < parts; ++i) {
+        music::Measure measure{music::Clef::Treble(), {4, 4}, 64};
+        auto           mlen = measure.max_length();
+        for(unsigned int j = 0; j < measures * mlen;) {
+            auto conc = score.concurrent(j, i);
+            lookups += i;
+
+            auto duration = (unsigned int)(16 << util::Randomizer::pick_uniform(gen, 0, 4));
+            if(j + duration > measures * mlen) {
+                duration = measures * mlen - j;
+            }
+            uint8_t pitch = conc.empty() ? (uint8_t)60 : conc.back()->bottom()->getPitch();
+            measure.append(music::Note{(uint8_t)(pitch + 1 - i % 2), duration});
+            j += duration;
+        }
+        auto part = std::make_shared<music::Part>(instrument);
+        part->setMeasures(measure);
+        score.addPart(part);
+    }
+    return lookups;
+}
+
+BENCHMARK(PartBench, ConcurrentGeneration) {
+    for(unsigned int measures : {250, 500, 1000, 2000}) {
+        std::size_t lookups = 0;
+        double      t       = bench::measure([&]() { lookups = buildScore(8, measures); });
+        bench::report("8 parts, " + std::to_string(measures) + " measures (per measure)", 8 * measures, t);
+        bench::report("8 parts, " + std::to_string(measures) + " measures (per lookup)", lookups, t);
+    }
+}
+
+BENCHMARK(PartBench, GenerateScore) {
+    // The Config needs the installed config folder, next to the folder of the benchmarks
+    auto program = boost::filesystem::system_complete(bench::program());
+    if(!boost::filesystem::is_directory(program.parent_path() / "../config")) {
+        std::printf("  skipped: no config folder next to '%s'; run the installed benchmarks\n", program.c_str());
+        return;
+    }
+
+    // Eight Parts, of which all but the first accompany the Chords of the previous Parts, on a single thread
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    auto file = (dir / "generate.json").string();
+
+    for(unsigned int measures : {250, 500, 1000, 2000}) {
+        {
+            std::ofstream config{file};
+            config << "{\"engine\": \"lcg64\", \"seed\": 1, \"threads\": 1, \"length\": " << measures << ",\n"
+                   << "\"generation\": {\"pitch\": \"brownian-motion\", \"rhythm\": \"1/f-noise\", "
+                   << "\"chord\": \"weighted\", \"rest-ratio\": 0.01},\n"
+                   << "\"style\": {\"from\": \"C-major\", \"chord-progression\": \"C-F-C-G-F-C\"},\n"
+                   << "\"parts\": [";
+            for(unsigned int p = 0; p < 8; ++p) {
+                config << (p == 0 ? "" : ",\n") << "{\"instrument\": \"Acoustic Grand Piano\", \"clef\": \""
+                       << (p % 2 == 0 ? "Treble" : "Bass") << "\""
+                       << (p == 0 ? "" : ", \"generation\": {\"pitch\": \"accompaniment\"}") << "}";
+            }
+            config << "]}\n";
+        }
+
+        std::vector<std::string> args = {bench::program(), "-c", file};
+        std::vector<char*>       argv;
+        for(auto& arg : args) {
+            argv.emplace_back(&arg[0]);
+        }
+        util::Config    config{(int)argv.size(), argv.data()};
+        util::Generator generator{config, config.getLogger()};
+
+        std::size_t chords = 0;
+        double      t      = bench::measure([&]() {
+            auto score = generator.generate(1, 1);
+            chords     = 0;
+            for(const auto& part : score.getParts()) {
+                chords += part->chordCount();
+            }
+        });
+        bench::report("generate " + std::to_string(measures) + " measures (per measure)", measures, t);
+        bench::report("generate " + std::to_string(measures) + " measures (per chord)", chords, t);
+    }
+
+    boost::filesystem::remove_all(dir);
+}
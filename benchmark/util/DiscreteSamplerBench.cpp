@@ -0,0 +1,66 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "../../main/util/DiscreteSampler.h"
+#include "../../main/util/Randomizer.h"
+#include "../Benchmark.h"
+
+using namespace autoplay;
+
+namespace {
+    const std::size_t DRAWS = 1u << 16;
+
+    volatile std::size_t sink; ///< Keeps the compiler from removing the draws
+}
+
+BENCHMARK(DiscreteSamplerBench, PickWeighted) {
+    for(std::size_t n : {10, 100, 1000, 10000}) {
+        util::RNEngine gen;
+        gen("lcg64", 1);
+
+        std::vector<std::size_t> elements;
+        std::vector<double>      weights;
+        for(std::size_t i = 0; i < n; ++i) {
+            elements.emplace_back(i);
+            weights.emplace_back((double)(i % 7 + 1));
+        }
+        std::function<double(const std::size_t&)> weight = [&weights](const std::size_t& i) { return weights[i]; };
+
+        // Sort and scan the weights on each draw
+        std::size_t draws  = DRAWS / n + 16;
+        double      linear = bench::measure([&]() {
+            std::size_t sum = 0;
+            for(std::size_t i = 0; i < draws; ++i) {
+                sum += util::Randomizer::pick_weighted(gen, elements, weight);
+            }
+            sink = sum;
+        });
+
+        // Build the alias table once, then draw in constant time
+        double alias = bench::measure([&]() {
+            util::DiscreteSampler sampler{weights};
+            std::size_t           sum = 0;
+            for(std::size_t i = 0; i < DRAWS; ++i) {
+                sum += sampler.sample(gen);
+            }
+            sink = sum;
+        });
+
+        bench::report(std::to_string(n) + " outcomes (pick_weighted)", draws, linear);
+        bench::report(std::to_string(n) + " outcomes (alias)", DRAWS, alias);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "../../main/util/Randomizer.h"
+#include "../Benchmark.h"
+
+using namespace autoplay;
+
+namespace {
+    const std::vector<std::string> ENGINES = {"lcg64", "lcg64_shift", "mrg2",  "mrg3",  "mrg4",  "mrg5",  "mrg5s",
+                                              "mt19937", "mt19937_64", "yarn2", "yarn3", "yarn4", "yarn5", "yarn5s"};
+
+    const std::size_t DRAWS = 1u << 20;
+
+    volatile long sink; ///< Keeps the compiler from removing the draws
+}
+
+BENCHMARK(RNEngineBench, UniformDraws) {
+    for(const auto& name : ENGINES) {
+        util::RNEngine gen;
+        gen(name, 1);
+
+        // Resolve the engine type on each draw
+        double dynamic = bench::measure([&]() {
+            long sum = 0;
+            for(std::size_t i = 0; i < DRAWS; ++i) {
+                sum += util::Randomizer::pick_uniform(gen, 0, 128);
+            }
+            sink = sum;
+        });
+
+        // Resolve the engine type once
+        double visited = bench::measure([&]() {
+            sink = gen.visit([](auto& engine) {
+                long sum = 0;
+                for(std::size_t i = 0; i < DRAWS; ++i) {
+                    sum += util::Randomizer::pick_uniform(engine, 0, 128);
+                }
+                return sum;
+            });
+        });
+
+        bench::report(name + " (per draw)", DRAWS, dynamic);
+        bench::report(name + " (visit)", DRAWS, visited);
+    }
+}
+
+BENCHMARK(RNEngineBench, BulkFill) {
+    std::vector<int> buffer(DRAWS);
+    for(const auto& name : {"lcg64", "mrg5", "mt19937", "yarn5s"}) {
+        util::RNEngine gen;
+        gen(name, 1);
+
+        double single = bench::measure([&]() {
+            for(auto& b : buffer) {
+                b = util::Randomizer::pick_uniform(gen, 0, 128);
+            }
+        });
+        double bulk = bench::measure([&]() { gen.fill(buffer.data(), buffer.size(), 0, 128); });
+
+        bench::report(std::string(name) + " (single draws)", DRAWS, single);
+        bench::report(std::string(name) + " (fill)", DRAWS, bulk);
+    }
+}
@@ -15,7 +15,9 @@
  *  Created on 05/10/2018
  */
 
+#include "markov/ChainAnalysis.h"
 #include "markov/MarkovChain.h"
+#include "markov/ModelRegistry.h"
 #include "music/Instrument.h"
 #include "music/MIDIPlayer.h"
 #include "music/Note.h"
@@ -26,7 +28,10 @@
 #include <trng/lcg64.hpp>
 #include <zupply/src/zupply.hpp>
 #include <rtmidi/RtMidi.h>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <map>
 #include <pthread.h>
@@ -41,17 +46,107 @@ int main(int argc, char** argv) {
 
     if(config.isMarkov()) {
         logger->info("Started Markov Chain Learning");
-        auto mv = config.getMarkov();
-        auto m3 = markov::MarkovChain::generateMatrices(mv.at("directory"));
+        auto mv      = config.getMarkov();
+        auto order   = (unsigned int)std::stoul(mv.at("order"));
+        auto threads = (unsigned int)std::stoul(mv.at("threads"));
         try {
-            m3.at(0).toCSV(mv.at("pitch"));
-            m3.at(1).toCSV(mv.at("rhythm"));
-            m3.at(2).toCSV(mv.at("chord"));
+            if(mv.at("manifest").empty()) {
+                auto m3 = markov::MarkovChain::generateMatrices(mv.at("directory"), true, order, threads,
+                                                                mv.at("cache"));
+                m3.at(0).toCSV(mv.at("pitch"));
+                m3.at(1).toCSV(mv.at("rhythm"));
+                m3.at(2).toCSV(mv.at("chord"));
+            } else {
+                auto added = markov::MarkovChain::updateMatrices(
+                    mv.at("directory"), {mv.at("pitch"), mv.at("rhythm"), mv.at("chord")}, mv.at("manifest"), true,
+                    order, threads, mv.at("cache"));
+                logger->info("Added {} new file(s) to the Markov Chains.", added);
+            }
+        } catch(std::logic_error& e) {
+            logger->fatal(e.what());
+            exit(EXIT_FAILURE);
         } catch(std::runtime_error& e) {
             logger->fatal(e.what());
             exit(EXIT_FAILURE);
         }
         logger->info("Finished Markov Chain Learning");
+    } else if(config.isConvert()) {
+        auto files = config.getConvert();
+        try {
+            markov::MarkovChain{files.first, util::RNEngine{}}.save(files.second);
+        } catch(std::runtime_error& e) {
+            logger->fatal(e.what());
+            exit(EXIT_FAILURE);
+        }
+        logger->info("Converted '{}' to the binary model '{}'.", files.first, files.second);
+    } else if(config.isAnalyze()) {
+        auto options = config.getAnalyze();
+        try {
+            auto start    = std::chrono::steady_clock::now();
+            auto model    = markov::ModelRegistry::instance().model(options.first);
+            auto analysis = markov::ChainAnalysis{model->table(), 0};
+            auto pi       = analysis.stationary();
+            auto expected = analysis.histogram(model->getState(), options.second);
+            std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+
+            std::cout << std::left << std::setw(16) << "state" << std::right << std::setw(14) << "stationary"
+                      << std::setw(18) << "expected (" + std::to_string(options.second) + ")" << std::endl;
+            for(std::size_t i = 0; i < analysis.size(); ++i) {
+                std::cout << std::left << std::setw(16) << analysis.states().at(i) << std::right << std::fixed
+                          << std::setprecision(6) << std::setw(14) << pi.at(i) << std::setprecision(3)
+                          << std::setw(18) << expected.at(i) << std::endl;
+            }
+            logger->info("Analyzed {} states of '{}' in {} seconds.", analysis.size(), options.first, d.count());
+        } catch(std::exception& e) {
+            logger->fatal(e.what());
+            exit(EXIT_FAILURE);
+        }
+    } else if(config.isBatch()) {
+        logger->info("Started batch generation");
+
+        util::Generator generator{config, logger};
+
+        auto                       range = config.getBatch();
+        std::vector<unsigned long> seeds;
+        for(auto seed = range.first;; ++seed) {
+            seeds.emplace_back(seed);
+            if(seed == range.second) {
+                break;
+            }
+        }
+
+        auto fname   = config.conf<std::string>("export.filename", "music.xml");
+        auto threads = (unsigned int)std::max(0, config.conf<int>("threads", 0));
+        auto start   = std::chrono::steady_clock::now();
+        auto results = generator.batch(seeds,
+                                       [&fname](unsigned long seed, const music::Score& score) {
+                                           util::FileHandler::writeMusicXML(
+                                               util::FileHandler::suffixed(fname, std::to_string(seed)), score);
+                                       },
+                                       threads);
+        std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+
+        // Summary
+        std::size_t failed = 0;
+        std::size_t chords = 0;
+        for(const auto& result : results) {
+            if(!result.error.empty()) {
+                ++failed;
+                logger->error("Seed {} failed: {}", result.seed, result.error);
+                continue;
+            }
+            chords += result.chords;
+            logger->info("Seed {}: {} chords in {} ms ({} chords/s)", result.seed, result.chords,
+                         (long)(result.seconds * 1000), (long)(result.chords / std::max(result.seconds, 1e-9)));
+        }
+        logger->info("Generated {} scores ({} failed) in {} ms: {} scores/s, {} chords/s", results.size() - failed,
+                     failed, (long)(total.count() * 1000), (results.size() - failed) / std::max(total.count(), 1e-9),
+                     (long)(chords / std::max(total.count(), 1e-9)));
+
+        logger->info("Finished batch generation");
+        if(failed > 0) {
+            exit(EXIT_FAILURE);
+        }
     } else {
         logger->info("Started autoplayer");
 
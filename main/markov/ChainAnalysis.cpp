@@ -0,0 +1,193 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "ChainAnalysis.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace autoplay {
+    namespace markov {
+        ChainAnalysis::ChainAnalysis(const TransitionTable& table, unsigned int threads)
+            : m_table(table), m_states(), m_position(table.size(), table.size()), m_transitions(),
+              m_threads(threads == 0 ? util::ThreadPool::hardware() : threads) {
+            std::vector<TransitionTable::Row> rows;
+            for(TransitionTable::Id c = 0; c < table.columns(); ++c) {
+                auto row = table.row(&c, 1);
+                if(row != TransitionTable::NO_ROW) {
+                    m_position[c] = m_states.size();
+                    m_states.emplace_back(table.name(c));
+                    rows.emplace_back(row);
+                }
+            }
+            // The ids that are no State of the analysis get size() as their index
+            for(auto& p : m_position) {
+                p = std::min(p, m_states.size());
+            }
+
+            m_transitions.reserve(size() * size());
+            for(const auto& row : rows) {
+                auto c = chances(row);
+                m_transitions.insert(m_transitions.end(), c.begin(), c.end());
+            }
+        }
+
+        std::size_t ChainAnalysis::index(const std::string& state) const {
+            auto id = m_table.find(state);
+            if(id == TransitionTable::NONE || m_position[id] == size()) {
+                throw std::out_of_range("The State '" + state + "' is not part of the analysis.");
+            }
+            return m_position[id];
+        }
+
+        ChainAnalysis::Matrix ChainAnalysis::power(unsigned long k) const {
+            const auto n = size();
+            Matrix     res(n * n, 0.0);
+            for(std::size_t i = 0; i < n; ++i) {
+                res[i * n + i] = 1.0;
+            }
+            Matrix square = m_transitions;
+            while(k > 0) {
+                if(k & 1) {
+                    res = multiply(res, square);
+                }
+                k >>= 1;
+                if(k > 0) {
+                    square = multiply(square, square);
+                }
+            }
+            return res;
+        }
+
+        ChainAnalysis::Matrix ChainAnalysis::multiply(const Matrix& a, const Matrix& b) const {
+            const auto n = size();
+            Matrix     c(n * n, 0.0);
+
+            // Each row of c is a sum of rows of b, so the inner loop is contiguous in both b and c
+            auto rows = [&](std::size_t begin, std::size_t end) {
+                for(auto i = begin; i < end; ++i) {
+                    double*       ci = c.data() + i * n;
+                    const double* ai = a.data() + i * n;
+                    for(std::size_t k = 0; k < n; ++k) {
+                        const double aik = ai[k];
+                        if(aik == 0.0) {
+                            continue;
+                        }
+                        const double* bk = b.data() + k * n;
+                        for(std::size_t j = 0; j < n; ++j) {
+                            ci[j] += aik * bk[j];
+                        }
+                    }
+                }
+            };
+
+            auto threads = (std::size_t)std::min<std::size_t>(m_threads, n / 32);
+            if(threads <= 1) {
+                rows(0, n);
+            } else {
+                util::ThreadPool pool{(unsigned int)threads};
+                for(std::size_t t = 0; t < threads; ++t) {
+                    pool.enqueue([&rows, t, threads, n]() { rows(n * t / threads, n * (t + 1) / threads); });
+                }
+                pool.wait();
+            }
+            return c;
+        }
+
+        std::vector<double> ChainAnalysis::initial(const std::string& context) const {
+            auto id  = m_table.find(context);
+            auto row = id == TransitionTable::NONE ? TransitionTable::NO_ROW : m_table.row(&id, 1);
+            if(row == TransitionTable::NO_ROW) {
+                throw std::out_of_range("The Markov Chain has no row for '" + context + "'.");
+            }
+            return chances(row);
+        }
+
+        std::vector<double> ChainAnalysis::step(std::vector<double> distribution, unsigned long k) const {
+            const auto          n = size();
+            std::vector<double> next(n);
+            for(unsigned long s = 0; s < k; ++s) {
+                std::fill(next.begin(), next.end(), 0.0);
+                for(std::size_t i = 0; i < n; ++i) {
+                    const double di = distribution[i];
+                    if(di == 0.0) {
+                        continue;
+                    }
+                    const double* pi = m_transitions.data() + i * n;
+                    for(std::size_t j = 0; j < n; ++j) {
+                        next[j] += di * pi[j];
+                    }
+                }
+                distribution.swap(next);
+            }
+            return distribution;
+        }
+
+        std::vector<double> ChainAnalysis::stationary(double tolerance, unsigned int iterations) const {
+            const auto          n = size();
+            std::vector<double> pi(n, n == 0 ? 0.0 : 1.0 / (double)n);
+            for(unsigned int it = 0; it < iterations; ++it) {
+                auto   next = step(pi);
+                double diff = 0.0;
+                for(std::size_t j = 0; j < n; ++j) {
+                    next[j] = 0.5 * (pi[j] + next[j]);
+                    diff += std::fabs(next[j] - pi[j]);
+                }
+                pi.swap(next);
+                if(diff <= tolerance) {
+                    return pi;
+                }
+            }
+            throw std::runtime_error("The stationary distribution has not converged after " +
+                                     std::to_string(iterations) + " iterations.");
+        }
+
+        std::vector<double> ChainAnalysis::histogram(const std::string& context, unsigned long length) const {
+            std::vector<double> res(size(), 0.0);
+            if(length == 0) {
+                return res;
+            }
+            auto distribution = initial(context);
+            for(unsigned long t = 0; t < length; ++t) {
+                if(t > 0) {
+                    distribution = step(std::move(distribution));
+                }
+                for(std::size_t j = 0; j < res.size(); ++j) {
+                    res[j] += distribution[j];
+                }
+            }
+            return res;
+        }
+
+        std::vector<double> ChainAnalysis::chances(TransitionTable::Row row) const {
+            std::vector<double> res(size(), 0.0);
+            double              sum = 0.0;
+            for(TransitionTable::Id c = 0; c < m_table.columns(); ++c) {
+                if(m_position[c] < size()) {
+                    res[m_position[c]] = m_table.chance(row, c);
+                    sum += res[m_position[c]];
+                }
+            }
+            for(auto& r : res) {
+                r = sum > 0.0 ? r / sum : 1.0 / (double)res.size();
+            }
+            return res;
+        }
+    }
+}
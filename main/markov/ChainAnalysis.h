@@ -0,0 +1,154 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_CHAINANALYSIS_H
+#define AUTOPLAY_CHAINANALYSIS_H
+
+#include "TransitionTable.h"
+
+#include <string>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The ChainAnalysis class computes properties of a (first-order) Markov Chain numerically: the chances to
+         * go from one State to another in k steps, the distribution the chain converges to, and the amount of times
+         * each State is expected to occur in a sequence of a certain length.
+         *
+         * The States of the analysis are the columns of the TransitionTable that have a row of their own (i.e. the
+         * chain can continue from them). Transitions to other States are left out, and each row is renormalized; a
+         * row that has no transitions left goes to each State with the same chance.
+         * Longer contexts of a higher order table are not used.
+         *
+         * The matrices are dense and row-major. Their products are written as contiguous loops that the compiler
+         * can vectorize, and the rows of a product can be split over multiple threads.
+         */
+        class ChainAnalysis
+        {
+        public:
+            /// A dense, row-major square matrix of size() x size() chances
+            using Matrix = std::vector<double>;
+
+            /**
+             * Constructor
+             * @param table     The table of the Markov Chain.
+             * @param threads   The amount of threads to multiply matrices with. When 0, the amount of hardware
+             *                  threads is used.
+             */
+            explicit ChainAnalysis(const TransitionTable& table, unsigned int threads = 1);
+
+            /**
+             * Get the amount of States.
+             * @return The size of the matrices and distributions.
+             */
+            inline std::size_t size() const { return m_states.size(); }
+
+            /**
+             * Get the names of the States, in the order of the matrices and distributions.
+             * @return The States.
+             */
+            inline const std::vector<std::string>& states() const { return m_states; }
+
+            /**
+             * Get the position of a State in the matrices and distributions.
+             * @param state The name of the State.
+             * @return The index of the State.
+             *
+             * @throws std::out_of_range When the State is not part of the analysis.
+             */
+            std::size_t index(const std::string& state) const;
+
+            /**
+             * Get the matrix of the chances to go from one State to another in a single step.
+             * @return The transition matrix.
+             */
+            inline const Matrix& transitions() const { return m_transitions; }
+
+            /**
+             * Get the matrix of the chances to go from one State to another in k steps, by repeated squaring.
+             * @param k The amount of steps.
+             * @return The k-th power of the transition matrix; the identity for k = 0.
+             */
+            Matrix power(unsigned long k) const;
+
+            /**
+             * Multiply two matrices.
+             * @param a The left matrix.
+             * @param b The right matrix.
+             * @return The product a * b.
+             */
+            Matrix multiply(const Matrix& a, const Matrix& b) const;
+
+            /**
+             * Get the distribution of the first State after a context, such as the begin State. This is the
+             * distribution after one step, not a distribution that is only at the context itself.
+             * @param context   The name of the State to start from. It does not have to be part of the analysis.
+             * @return The chance of each State after one step from the context.
+             *
+             * @throws std::out_of_range When the table has no row for the context.
+             */
+            std::vector<double> initial(const std::string& context) const;
+
+            /**
+             * Let a distribution evolve for a number of steps.
+             * @param distribution  The chance of each State.
+             * @param k             The amount of steps.
+             * @return The chance of each State k steps later.
+             */
+            std::vector<double> step(std::vector<double> distribution, unsigned long k = 1) const;
+
+            /**
+             * Compute the stationary distribution by power iteration, starting from the uniform distribution. The
+             * iteration uses the lazy chain (I + P) / 2, which has the same stationary distributions but is never
+             * periodic, so it also converges for chains that alternate between States.
+             * @param tolerance     The iteration stops when no chance changes more than this (in total).
+             * @param iterations    The maximal amount of iterations.
+             * @return The chance of each State in the long run.
+             *
+             * @throws std::runtime_error When the iteration has not converged.
+             */
+            std::vector<double> stationary(double tolerance = 1e-12, unsigned int iterations = 10000) const;
+
+            /**
+             * Compute the amount of times each State is expected to occur in a sequence.
+             * @param context   The name of the State the sequence starts after, such as the begin State.
+             * @param length    The amount of States in the sequence.
+             * @return The expected amount of occurrences of each State; they add up to length.
+             *
+             * @throws std::out_of_range When the table has no row for the context.
+             */
+            std::vector<double> histogram(const std::string& context, unsigned long length) const;
+
+        private:
+            TransitionTable          m_table;       ///< The table of the Markov Chain
+            std::vector<std::string> m_states;      ///< The names of the States
+            std::vector<std::size_t> m_position;    ///< For each id of the table, its index (or size() if none)
+            Matrix                   m_transitions; ///< The one-step transition matrix
+            unsigned int             m_threads;     ///< The amount of threads to multiply matrices with
+
+            /**
+             * Compute the chances of a row of the table, over the States of the analysis.
+             * @param row   The row of the table.
+             * @return The normalized chances.
+             */
+            std::vector<double> chances(TransitionTable::Row row) const;
+        };
+    }
+}
+
+#endif // AUTOPLAY_CHAINANALYSIS_H
@@ -0,0 +1,67 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+#include "ChainBatch.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace autoplay {
+    namespace markov {
+        ChainBatch::ChainBatch(const MarkovChain& model, std::size_t size, const util::RNEngine& engine)
+            : m_table(model.table()), m_engine(engine), m_begin(model.begin()), m_begin_id(m_table.find(m_begin)),
+              m_order(model.order()), m_history(size * m_order, m_begin_id), m_rows(size), m_uniform(size),
+              m_next(size, TransitionTable::NONE) {}
+
+        const std::vector<ChainBatch::Id>& ChainBatch::next() {
+            if(m_next.empty()) {
+                return m_next;
+            }
+            for(std::size_t c = 0; c < m_next.size(); ++c) {
+                m_rows[c] = m_table.row(m_history.data() + c * m_order, m_order);
+                if(m_rows[c] == TransitionTable::NO_ROW) {
+                    throw std::out_of_range("The MarkovChain " + std::to_string(c) + " is in an unknown State.");
+                }
+            }
+            m_engine.fill(m_uniform.data(), m_uniform.size(), 0.0, 1.0);
+            m_table.next(m_rows.data(), m_uniform.data(), m_next.data(), m_next.size());
+
+            for(std::size_t c = 0; c < m_next.size(); ++c) {
+                auto history = m_history.begin() + c * m_order;
+                std::copy(history + 1, history + m_order, history);
+                history[m_order - 1] = m_next[c];
+            }
+            return m_next;
+        }
+
+        void ChainBatch::reset() { std::fill(m_history.begin(), m_history.end(), m_begin_id); }
+
+        void ChainBatch::reset(std::size_t chain) {
+            if(chain >= size()) {
+                throw std::out_of_range("Unknown chain in the ChainBatch.");
+            }
+            std::fill_n(m_history.begin() + chain * m_order, m_order, m_begin_id);
+        }
+
+        ChainBatch::State ChainBatch::getState(std::size_t chain) const {
+            if(chain >= size()) {
+                throw std::out_of_range("Unknown chain in the ChainBatch.");
+            }
+            auto id = m_history.at((chain + 1) * m_order - 1);
+            return id == TransitionTable::NONE ? m_begin : state(id);
+        }
+    }
+}
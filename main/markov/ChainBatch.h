@@ -0,0 +1,114 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+#ifndef AUTOPLAY_CHAINBATCH_H
+#define AUTOPLAY_CHAINBATCH_H
+
+#include "../util/RNEngine.h"
+#include "MarkovChain.h"
+#include "TransitionTable.h"
+
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The ChainBatch class runs many independent MarkovChains of the same model in lockstep, e.g. for the voices
+         * of a part or for a batch of Scores. Each step draws one random number per chain at once and searches the
+         * rows of all chains together (see TransitionTable::next), which is faster than advancing the chains one by
+         * one when there are many of them.
+         *
+         * A batch of a single chain goes to the same States as a MarkovChain with the same engine. With more chains,
+         * step t of chain i uses the (t * size() + i)-th number of the engine.
+         *
+         * The Generator does not use a batch (not even in Generator::batch). The chains of a Part draw from the random
+         * stream of that Part, in between the other algorithms, so a shared engine would change the generated Scores.
+         */
+        class ChainBatch
+        {
+        public:
+            using State = MarkovChain::State;
+            using Id    = MarkovChain::Id;
+
+            /**
+             * Constructor of a batch that starts all chains from the initial State of a model. The model is shared.
+             * @param model     The chain to take the model and the initial State from.
+             * @param size      The amount of chains.
+             * @param engine    The random engine to use.
+             */
+            ChainBatch(const MarkovChain& model, std::size_t size, const util::RNEngine& engine);
+
+            /**
+             * Move all chains to their next State.
+             * @return The ids of the new States, one per chain. The reference is valid until the next call.
+             *
+             * @throws std::out_of_range When a chain is in an unknown State, or its State has no transitions.
+             */
+            const std::vector<Id>& next();
+
+            /**
+             * Resets all chains to the initial State.
+             */
+            void reset();
+
+            /**
+             * Resets a single chain to the initial State, e.g. when its sequence is complete.
+             * @param chain The index of the chain.
+             */
+            void reset(std::size_t chain);
+
+            /**
+             * Gets the current State of a chain.
+             * @param chain The index of the chain.
+             * @return The State of the chain.
+             */
+            State getState(std::size_t chain) const;
+
+            /**
+             * Get the name of a State.
+             * @param id    The id of the State, as returned by next().
+             * @return The State.
+             */
+            inline const State& state(Id id) const { return m_table.name(id); }
+
+            /**
+             * Get the amount of chains in the batch.
+             * @return The amount of chains.
+             */
+            inline std::size_t size() const { return m_next.size(); }
+
+            /**
+             * Get the order of the chains, i.e. the amount of previous States that decide the next one.
+             * @return The order of the chains.
+             */
+            inline std::size_t order() const { return m_order; }
+
+        private:
+            TransitionTable m_table;    ///< The compact form of the model
+            util::RNEngine  m_engine;   ///< The random engine to use
+            State           m_begin;    ///< The begin/start State
+            Id              m_begin_id; ///< The id of the begin/start State
+            std::size_t     m_order;    ///< The length of the history of each chain
+
+            std::vector<Id>                   m_history; ///< The last order() States of each chain, chain by chain
+            std::vector<TransitionTable::Row> m_rows;    ///< The row of the history of each chain
+            std::vector<double>               m_uniform; ///< The random number of each chain for the current step
+            std::vector<Id>                   m_next;    ///< The new State of each chain
+        };
+    }
+}
+
+#endif // AUTOPLAY_CHAINBATCH_H
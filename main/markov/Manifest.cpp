@@ -0,0 +1,118 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "Manifest.h"
+#include "../util/FileHandler.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace autoplay {
+    namespace markov {
+        Manifest Manifest::load(const std::string& filename) {
+            std::ifstream file(filename);
+            if(!file.is_open()) {
+                throw std::runtime_error("Unable to open file with filename '" + filename + "'");
+            }
+
+            auto invalid = [&filename](const std::string& why) {
+                return std::runtime_error("The file '" + filename + "' is not a valid manifest: " + why + ".");
+            };
+
+            std::string line;
+            if(!std::getline(file, line) || (line != "autoplay-manifest 1" && line != "autoplay-manifest 2")) {
+                throw invalid("unknown header");
+            }
+            bool hashed = line.back() == '2';
+
+            std::string  key;
+            unsigned int order = 0;
+            if(!std::getline(file, line) || !(std::istringstream(line) >> key >> order) || key != "order" ||
+               order == 0) {
+                throw invalid("missing order");
+            }
+
+            Manifest manifest{order};
+            if(hashed) {
+                if(!std::getline(file, line)) {
+                    throw invalid("missing tables");
+                }
+                std::istringstream    in(line);
+                std::vector<uint64_t> hashes;
+                uint64_t              h = 0;
+                if(!(in >> key) || key != "tables") {
+                    throw invalid("missing tables");
+                }
+                while(in >> std::hex >> h) {
+                    hashes.emplace_back(h);
+                }
+                if(!in.eof()) {
+                    throw invalid("invalid line '" + line + "'");
+                }
+                manifest.setTables(hashes);
+            }
+            while(std::getline(file, line)) {
+                if(line.empty()) {
+                    continue;
+                }
+                std::istringstream in(line);
+                Entry              entry{};
+                if(!(in >> entry.size >> entry.mtime) || in.get() != ' ') {
+                    throw invalid("invalid line '" + line + "'");
+                }
+                std::string path;
+                std::getline(in, path);
+                if(path.empty()) {
+                    throw invalid("invalid line '" + line + "'");
+                }
+                manifest.add(path, entry);
+            }
+            return manifest;
+        }
+
+        void Manifest::save(const std::string& filename) const {
+            util::FileHandler::writeAtomic(filename, [this](std::ostream& out) {
+                out << "autoplay-manifest 2\n";
+                out << "order " << m_order << "\n";
+                out << "tables";
+                for(const auto& h : m_tables) {
+                    out << " " << std::hex << std::setw(16) << std::setfill('0') << h << std::dec;
+                }
+                out << "\n";
+                for(const auto& kv : m_files) {
+                    out << kv.second.size << " " << kv.second.mtime << " " << kv.first << "\n";
+                }
+            });
+        }
+
+        const Manifest::Entry* Manifest::find(const std::string& file) const {
+            auto it = m_files.find(file);
+            if(it == m_files.end()) {
+                return nullptr;
+            }
+            return &it->second;
+        }
+
+        void Manifest::add(const std::string& file, const Manifest::Entry& entry) { m_files[file] = entry; }
+
+        Manifest::Entry Manifest::stat(const boost::filesystem::path& file) {
+            return {boost::filesystem::file_size(file), boost::filesystem::last_write_time(file)};
+        }
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_MANIFEST_H
+#define AUTOPLAY_MANIFEST_H
+
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The Manifest class remembers which files have been used to train a set of Markov Chain tables, so that a
+         * later training only has to read the files that have been added since.
+         *
+         * It is stored as a text file: a line 'autoplay-manifest 2', a line 'order N', a line 'tables h...' with the
+         * hashes of the tables it belongs to (see util::FileHandler::hash) and a line 'size mtime path' for each
+         * file, where the path is relative to the training directory. The hashes show whether the tables are the
+         * ones the Manifest was written with, so an update that was interrupted between writing the tables and
+         * writing the Manifest is detected. Version 1 has no line with hashes.
+         */
+        class Manifest
+        {
+        public:
+            /**
+             * The state of a file at the time it was used for training.
+             */
+            struct Entry {
+                std::uintmax_t size;  ///< The size of the file in bytes
+                std::time_t    mtime; ///< The last modification time of the file
+
+                inline bool operator==(const Entry& rhs) const { return size == rhs.size && mtime == rhs.mtime; }
+                inline bool operator!=(const Entry& rhs) const { return !(*this == rhs); }
+            };
+
+            /**
+             * Constructor of an empty Manifest
+             * @param order The order of the Markov Chains that are trained.
+             */
+            explicit Manifest(unsigned int order = 1) : m_order(order), m_tables(), m_files() {}
+
+            /**
+             * Read a Manifest from a file.
+             * @param filename  The file to read.
+             * @return The Manifest.
+             *
+             * @throws std::runtime_error When the file cannot be read, or is not a valid Manifest.
+             */
+            static Manifest load(const std::string& filename);
+
+            /**
+             * Write the Manifest to a file. The file is replaced atomically.
+             * @param filename  The file to write.
+             *
+             * @throws std::runtime_error When the file cannot be written.
+             */
+            void save(const std::string& filename) const;
+
+            /**
+             * Find a file in the Manifest.
+             * @param file  The path of the file, relative to the training directory.
+             * @return A pointer to its Entry, or nullptr if the file has not been used for training.
+             */
+            const Entry* find(const std::string& file) const;
+
+            /**
+             * Checks if a file has been used for training.
+             * @param file  The path of the file, relative to the training directory.
+             * @return True if it has.
+             */
+            inline bool contains(const std::string& file) const { return m_files.count(file) == 1; }
+
+            /**
+             * Add (or replace) a file.
+             * @param file  The path of the file, relative to the training directory.
+             * @param entry The state of the file.
+             */
+            void add(const std::string& file, const Entry& entry);
+
+            /**
+             * Set the hashes of the tables that the Manifest belongs to.
+             * @param hashes    The hash of each table (see util::FileHandler::hash), in order.
+             */
+            inline void setTables(std::vector<uint64_t> hashes) { m_tables = std::move(hashes); }
+
+            /**
+             * Get the hashes of the tables that the Manifest belongs to.
+             * @return The hash of each table, or nothing when they are unknown (in a Manifest of version 1).
+             */
+            inline const std::vector<uint64_t>& tables() const { return m_tables; }
+
+            /**
+             * Get the order of the Markov Chains that are trained.
+             * @return The order.
+             */
+            inline unsigned int order() const { return m_order; }
+
+            /**
+             * Get the amount of files in the Manifest.
+             * @return The amount of files.
+             */
+            inline std::size_t size() const { return m_files.size(); }
+
+            /**
+             * Get the current state of a file.
+             * @param file  The file to look at.
+             * @return Its size and last modification time.
+             *
+             * @throws boost::filesystem::filesystem_error When the file cannot be accessed.
+             */
+            static Entry stat(const boost::filesystem::path& file);
+
+        private:
+            unsigned int                 m_order;  ///< The order of the Markov Chains
+            std::vector<uint64_t>        m_tables; ///< The hashes of the tables
+            std::map<std::string, Entry> m_files;  ///< Relative path -> state of the file
+        };
+    }
+}
+
+#endif // AUTOPLAY_MANIFEST_H
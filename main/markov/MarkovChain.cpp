@@ -17,87 +17,288 @@
 
 #include "MarkovChain.h"
 #include "../util/FileHandler.h"
-#include "../util/Randomizer.h"
+#include "../util/ThreadPool.h"
+#include "Manifest.h"
+#include "MidiReader.h"
+#include "ScoreReader.h"
 #include "SpecialQueue.h"
+#include "TrainingCache.h"
 
-#include <boost/property_tree/exceptions.hpp>
-#include <boost/property_tree/xml_parser.hpp>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <set>
 
 namespace autoplay {
     namespace markov {
 
         MarkovChain::MarkovChain(const std::string& filename, const util::RNEngine& engine,
                                  const MarkovChain::State& begin)
-            : m_engine(engine), m_current(begin), m_begin(begin) {
-            m_matrix = NamedMatrix::fromCSV(filename);
-            m_matrix.normalizeRows();
+            : m_matrix(), m_table(), m_engine(engine), m_uniform(), m_history(), m_begin(begin),
+              m_begin_id(TransitionTable::NONE), m_first(), m_reach(), m_weights(), m_steps(0), m_step(0) {
+            if(TransitionTable::isModel(filename)) {
+                rebuild(TransitionTable::load(filename));
+                return;
+            }
+            auto matrix = std::make_shared<NamedMatrix>(NamedMatrix::fromCSV(filename));
+            matrix->normalizeRows();
+            m_matrix = matrix;
+            rebuild(TransitionTable(*m_matrix));
         }
 
         MarkovChain::MarkovChain(const markov::NamedMatrix& namedMatrix, const util::RNEngine& engine,
                                  const MarkovChain::State& begin)
-            : m_matrix(namedMatrix), m_engine(engine), m_current(begin), m_begin(begin) {
-            m_matrix.normalizeRows();
+            : m_matrix(), m_table(), m_engine(engine), m_uniform(), m_history(), m_begin(begin),
+              m_begin_id(TransitionTable::NONE), m_first(), m_reach(), m_weights(), m_steps(0), m_step(0) {
+            auto matrix = std::make_shared<NamedMatrix>(namedMatrix);
+            matrix->normalizeRows();
+            m_matrix = matrix;
+            rebuild(TransitionTable(*m_matrix));
         }
 
+        MarkovChain::MarkovChain(const MarkovChain& model, const util::RNEngine& engine)
+            : m_matrix(model.m_matrix), m_table(model.m_table), m_engine(engine), m_uniform(),
+              m_history(model.m_history.size(), model.m_begin_id), m_begin(model.m_begin),
+              m_begin_id(model.m_begin_id), m_first(model.m_first), m_reach(), m_weights(), m_steps(0), m_step(0) {}
+
         void MarkovChain::erase(const std::vector<autoplay::markov::MarkovChain::State>& erasables) {
+            auto            full = matrix();
+            std::set<State> erased;
             for(const auto& state : erasables) {
-                bool b = m_matrix.dropColumn(state);
-                if(b) {
+                if(full.isColumn(state) && erased.insert(state).second) {
                     std::cout << "Dropped '" << state << "'!" << std::endl;
                 } else {
                     std::cerr << "Could not drop '" << state << "'!" << std::endl;
                 }
             }
+
+            std::vector<State> columns;
+            for(const auto& state : full.getColumns()) {
+                if(erased.count(state) == 0) {
+                    columns.emplace_back(state);
+                }
+            }
+            m_matrix = std::make_shared<NamedMatrix>(full.project(full.getRows(), columns));
+            rebuild(TransitionTable(*m_matrix));
         }
 
         void MarkovChain::keep(const std::vector<autoplay::markov::MarkovChain::State>& non_erasables) {
-            // Columns
-            auto erasables = m_matrix.getColumns();
-            for(const auto& state : non_erasables) {
-                erasables.erase(std::remove(erasables.begin(), erasables.end(), state), erasables.end());
+            // The model stays shared; only a mask is added
+            m_matrix = nullptr;
+            m_table  = m_table.filter(non_erasables);
+            m_first.clear();
+            m_steps = m_step = 0;
+        }
+
+        MarkovChain::Id MarkovChain::next() {
+            if(m_step < m_steps) {
+                return next({});
             }
-            for(const auto& state : erasables) {
-                m_matrix.dropColumn(state);
-                m_matrix.dropRow(state);
+            auto row = m_table.row(m_history.data(), m_history.size());
+            if(row == TransitionTable::NO_ROW) {
+                throw std::out_of_range("The MarkovChain is in an unknown State.");
+            }
+            auto id = m_table.next(row, m_uniform.next(m_engine));
+            std::copy(m_history.begin() + 1, m_history.end(), m_history.begin());
+            m_history.back() = id;
+            return id;
+        }
+
+        MarkovChain::Id MarkovChain::next(const std::vector<Id>& avoid) {
+            auto sum = weigh(avoid);
+            if(sum == 0.0 && !avoid.empty()) {
+                sum = weigh({});
+            }
+            if(sum == 0.0) {
+                throw std::out_of_range("The MarkovChain cannot go to an allowed State.");
+            }
+
+            // Walk the cumulative weights; the last positive column guards against rounding
+            const double u  = m_uniform.next(m_engine) * sum;
+            double       at = 0.0;
+            Id           id = TransitionTable::NONE;
+            for(Id c = 0; c < m_weights.size(); ++c) {
+                if(m_weights[c] > 0.0) {
+                    id = c;
+                    at += m_weights[c];
+                    if(u < at) {
+                        break;
+                    }
+                }
+            }
+
+            std::copy(m_history.begin() + 1, m_history.end(), m_history.begin());
+            m_history.back() = id;
+            if(m_step < m_steps && ++m_step == m_steps) {
+                m_steps = m_step = 0;
             }
+            return id;
         }
 
-        MarkovChain::State MarkovChain::next() {
-            auto poss = fetchPossibilities();
+        void MarkovChain::constrain(const std::vector<std::vector<State>>& allowed) {
+            m_steps = m_step = 0;
+            if(allowed.empty()) {
+                return;
+            }
+
+            const auto n = m_table.columns();
+            if(m_first.empty()) {
+                m_first.assign(n * n, 0.0);
+                for(Id s = 0; s < n; ++s) {
+                    auto row = m_table.row(&s, 1);
+                    if(row != TransitionTable::NO_ROW) {
+                        for(Id c = 0; c < n; ++c) {
+                            m_first[s * n + c] = m_table.chance(row, c);
+                        }
+                    }
+                }
+            }
+
+            // reach(t, s) is the chance that the steps after t meet their constraints when step t goes to s. Each
+            // step is scaled to a maximum of 1, which does not change the chances within a step.
+            const auto        steps = allowed.size();
+            std::vector<char> valid(n);
+            m_reach.assign(steps * n, 0.0);
+            for(auto t = steps; t-- > 0;) {
+                std::fill(valid.begin(), valid.end(), (char)allowed[t].empty());
+                for(const auto& state : allowed[t]) {
+                    auto id = m_table.find(state);
+                    if(id < n) {
+                        valid[id] = 1;
+                    }
+                }
+
+                double* reach = m_reach.data() + t * n;
+                double  max   = 0.0;
+                for(std::size_t s = 0; s < n; ++s) {
+                    if(!valid[s]) {
+                        continue;
+                    }
+                    if(t + 1 == steps) {
+                        reach[s] = 1.0;
+                    } else {
+                        const double* p     = m_first.data() + s * n;
+                        const double* after = reach + n;
+                        for(std::size_t c = 0; c < n; ++c) {
+                            reach[s] += p[c] * after[c];
+                        }
+                    }
+                    max = std::max(max, reach[s]);
+                }
+                if(max == 0.0) {
+                    throw std::invalid_argument("The constraints of the MarkovChain cannot be met.");
+                }
+                for(std::size_t s = 0; s < n; ++s) {
+                    reach[s] /= max;
+                }
+            }
 
-            std::vector<MarkovChain::State> states;
-            for(const auto& p : poss) {
-                states.emplace_back(p.first);
+            m_steps = steps;
+            if(weigh({}) == 0.0) {
+                m_steps = 0;
+                throw std::invalid_argument("The constraints of the MarkovChain cannot be met from its State.");
             }
+        }
+
+        double MarkovChain::weigh(const std::vector<Id>& avoid) {
+            const auto    n     = m_table.columns();
+            const double* reach = m_step < m_steps ? m_reach.data() + m_step * n : nullptr;
+            m_weights.assign(n, 0.0);
+
+            auto last = TransitionTable::NO_ROW;
+            for(std::size_t k = 0; k < m_history.size(); ++k) {
+                auto row = m_table.row(m_history.data() + k, m_history.size() - k);
+                if(row == TransitionTable::NO_ROW) {
+                    break;
+                }
+                if(row == last) {
+                    continue;
+                }
+                last = row;
 
-            std::function<double(const State&)> func = [&poss](const State& state) -> double { return poss.at(state); };
+                double sum = 0.0;
+                for(Id c = 0; c < n; ++c) {
+                    double w = reach ? reach[c] : 1.0;
+                    if(w > 0.0 && std::find(avoid.begin(), avoid.end(), c) == avoid.end()) {
+                        w *= m_table.chance(row, c);
+                    } else {
+                        w = 0.0;
+                    }
+                    m_weights[c] = w;
+                    sum += w;
+                }
+                if(sum > 0.0) {
+                    return sum;
+                }
+            }
+            if(last == TransitionTable::NO_ROW) {
+                throw std::out_of_range("The MarkovChain is in an unknown State.");
+            }
+            return 0.0;
+        }
 
-            State s = util::Randomizer::pick_weighted(m_engine, states, func);
+        void MarkovChain::rebuild(const TransitionTable& table) {
+            std::vector<State> recent;
+            for(const auto& id : m_history) {
+                recent.emplace_back(id == TransitionTable::NONE ? m_begin : m_table.name(id));
+            }
 
-            m_current = s;
-            return s;
+            m_table    = table;
+            m_begin_id = m_table.find(m_begin);
+            m_first.clear();
+            m_steps = m_step = 0;
+            m_history.assign(std::max<std::size_t>(m_table.order(), 1), m_begin_id);
+            for(std::size_t i = 0; i < std::min(recent.size(), m_history.size()); ++i) {
+                m_history.at(m_history.size() - 1 - i) = m_table.find(recent.at(recent.size() - 1 - i));
+            }
         }
 
-        std::map<MarkovChain::State, double> MarkovChain::fetchPossibilities() const {
-            auto vec = m_matrix.get(m_current);
-            std::map<MarkovChain::State, double> poss;
-            for(const auto& pr : vec) {
-                poss.insert(pr);
+        NamedMatrix MarkovChain::matrix() const { return m_matrix ? *m_matrix : m_table.matrix(); }
+
+        namespace {
+            /**
+             * Count a transition from all contexts of a history to a State. For each length from 1 up to the size of
+             * the history, each combination of one State per event (of the most recent events) is a context.
+             * @param matrix    The matrix to update.
+             * @param history   The previous events, from the oldest to the newest.
+             * @param state     The State that follows.
+             */
+            void count(NamedMatrix& matrix, const SpecialQueue<std::string>& history, const std::string& state) {
+                if(!matrix.isColumn(state)) {
+                    matrix.addColumn(state);
+                }
+                if(!matrix.isRow(state)) {
+                    matrix.addRow(state);
+                }
+
+                std::vector<std::string> contexts = {""};
+                for(std::size_t i = history.size(); i > 0; --i) {
+                    std::vector<std::string> longer;
+                    for(const auto& s : history.at(i - 1)) {
+                        for(const auto& c : contexts) {
+                            longer.emplace_back(c.empty() ? s : s + TransitionTable::SEPARATOR + c);
+                        }
+                    }
+                    contexts = longer;
+                    for(const auto& c : contexts) {
+                        if(!matrix.isRow(c)) {
+                            matrix.addRow(c);
+                        }
+                        matrix.at(c, state) += 1;
+                    }
+                }
             }
-            return poss;
         }
 
-        std::vector<NamedMatrix> MarkovChain::generateMatrices(const path& directory, bool recursive) {
+        std::vector<std::string> MarkovChain::findScores(const path& directory, bool recursive) {
             if(!is_directory(directory)) {
                 throw std::runtime_error("The given path is not a directory.");
             }
-            NamedMatrix matPitch;
-            NamedMatrix matRhythm;
-            NamedMatrix matChord;
 
-            std::queue<path> q;
+            std::vector<std::string> files;
+            std::queue<path>         q;
             q.push(directory);
             while(!q.empty()) {
                 path p = q.front();
@@ -111,166 +312,297 @@ namespace autoplay {
                         if(recursive) {
                             q.push(entry.path());
                         }
-                    } else if(entry.path().extension().string() == ".xml") {
-                        generateMatrices(entry.path().string(), matPitch, matRhythm, matChord);
+                    } else if(entry.path().extension().string() == ".xml" ||
+                              MidiReader::isMidi(entry.path().string())) {
+                        files.emplace_back(entry.path().string());
                     }
                 }
                 q.pop();
             }
-            return {matPitch, matRhythm, matChord};
+            std::sort(files.begin(), files.end());
+            return files;
         }
 
-        void MarkovChain::generateMatrices(const std::string& filename, NamedMatrix& matPitch, NamedMatrix& matRhythm,
-                                           NamedMatrix& matChord) {
-            std::cout << "PATH: " << filename << std::endl;
+        std::vector<NamedMatrix> MarkovChain::generateMatrices(const path& directory, bool recursive,
+                                                               unsigned int order, unsigned int threads,
+                                                               const std::string& cache) {
+            return generateMatrices(findScores(directory, recursive), order, threads, cache);
+        }
 
-            pt::ptree score;
-            try {
-                pt::read_xml(filename, score);
-            } catch(const boost::property_tree::xml_parser_error& ex) {
-                std::cerr << "error in " << ex.filename() << ":" << ex.line() << "\n\t=> " << ex.what() << std::endl;
-                return;
+        std::vector<NamedMatrix> MarkovChain::generateMatrices(const std::vector<std::string>& files,
+                                                               unsigned int order, unsigned int threads,
+                                                               const std::string& cache) {
+            if(order == 0) {
+                throw std::invalid_argument("The order of a Markov Chain must be at least 1.");
             }
-            if(score.count("score-partwise") != 1) {
-                return;
+
+            if(threads == 0) {
+                threads = util::ThreadPool::hardware();
+            }
+            threads = (unsigned int)std::max<std::size_t>(std::min<std::size_t>(threads, files.size()), 1);
+
+            std::unique_ptr<TrainingCache> counts;
+            if(!cache.empty()) {
+                counts = std::make_unique<TrainingCache>(cache);
+            }
+
+            // Each worker counts into its own matrices. All counts are whole numbers, so the sum of the partial
+            // matrices is exact and does not depend on which worker read which file.
+            std::vector<std::vector<NamedMatrix>> partial(threads, std::vector<NamedMatrix>(3));
+            std::atomic<std::size_t>              next_file{0};
+            std::mutex                            print_mutex;
+            {
+                util::ThreadPool pool{threads};
+                for(unsigned int w = 0; w < threads; ++w) {
+                    pool.enqueue([&, w]() {
+                        auto& mats = partial.at(w);
+                        for(auto f = next_file++; f < files.size(); f = next_file++) {
+                            if(!counts) {
+                                {
+                                    std::lock_guard<std::mutex> lock(print_mutex);
+                                    std::cout << "PATH: " << files.at(f) << std::endl;
+                                }
+                                generateMatrices(files.at(f), mats.at(0), mats.at(1), mats.at(2), order);
+                                continue;
+                            }
+
+                            // The counts of every file are kept apart, so that they can be cached on their own
+                            std::vector<NamedMatrix> file(3);
+                            auto                     key    = TrainingCache::key(files.at(f), order);
+                            bool                     cached = counts->load(key, file);
+                            {
+                                std::lock_guard<std::mutex> lock(print_mutex);
+                                std::cout << "PATH: " << files.at(f) << (cached ? " (cached)" : "") << std::endl;
+                            }
+                            // The counts of a file that cannot be parsed are used, but not cached, so the error
+                            // is reported again on every training
+                            if(!cached && generateMatrices(files.at(f), file.at(0), file.at(1), file.at(2), order)) {
+                                counts->store(key, file);
+                            }
+                            for(unsigned int m = 0; m < mats.size(); ++m) {
+                                mats.at(m).add(file.at(m));
+                            }
+                        }
+                    });
+                }
+                pool.wait();
+            }
+
+            std::vector<NamedMatrix> res = std::move(partial.front());
+            for(unsigned int w = 1; w < threads; ++w) {
+                for(unsigned int m = 0; m < res.size(); ++m) {
+                    res.at(m).add(partial.at(w).at(m));
+                }
+            }
+            return res;
+        }
+
+        std::size_t MarkovChain::updateMatrices(const path& directory, const std::vector<std::string>& tables,
+                                                const std::string& manifest, bool recursive, unsigned int order,
+                                                unsigned int threads, const std::string& cache) {
+            if(order == 0) {
+                throw std::invalid_argument("The order of a Markov Chain must be at least 1.");
+            }
+            if(tables.size() != 3) {
+                throw std::invalid_argument("Three tables are required: pitch, rhythm and chord.");
+            }
+
+            // Continue from the previous training, if any
+            Manifest                 known{order};
+            std::vector<NamedMatrix> mats(3);
+            bool                     update = exists(manifest);
+            for(const auto& table : tables) {
+                if(update && !exists(table)) {
+                    throw std::runtime_error("The table '" + table + "' of the manifest '" + manifest +
+                                             "' does not exist.");
+                } else if(!update && exists(table)) {
+                    throw std::runtime_error("The table '" + table +
+                                             "' exists without a manifest, so the files it contains are unknown.");
+                }
+            }
+            if(update) {
+                known = Manifest::load(manifest);
+                if(known.order() != order) {
+                    throw std::invalid_argument("The manifest '" + manifest + "' has been trained with order " +
+                                                std::to_string(known.order()) + " instead of " +
+                                                std::to_string(order) + ".");
+                }
+                // Tables that differ from the ones the manifest was written with belong to an interrupted update;
+                // updating them again would count the files of that update twice
+                const auto& hashes = known.tables();
+                for(unsigned int m = 0; m < mats.size(); ++m) {
+                    if(!hashes.empty() && (hashes.size() != tables.size() ||
+                                           util::FileHandler::hash(tables.at(m)) != hashes.at(m))) {
+                        throw std::runtime_error("The table '" + tables.at(m) + "' does not match the manifest '" +
+                                                 manifest + "'; a previous update has been interrupted.");
+                    }
+                    mats.at(m) = NamedMatrix::fromCSV(tables.at(m));
+                }
+            }
+
+            std::vector<std::string> added;
+            for(const auto& file : findScores(directory, recursive)) {
+                auto name  = relative(file, directory).generic_string();
+                auto entry = Manifest::stat(file);
+                auto old   = known.find(name);
+                if(old == nullptr) {
+                    added.emplace_back(file);
+                    known.add(name, entry);
+                } else if(*old != entry) {
+                    std::cerr << "WARNING: " << file << " has changed since it was trained on; it is not read again."
+                              << std::endl;
+                }
+            }
+            if(added.empty() && update) {
+                return 0;
             }
 
-            std::string row = "begin";
-            if(!matPitch.isRow(row)) {
-                matPitch.addRow(row);
-            }
-            int new_divisions = 64;
-            if(!matRhythm.isRow(row)) {
-                matRhythm.addRow(row);
-            }
-            if(!matChord.isRow(row)) {
-                matChord.addRow(row);
-            }
-            SpecialQueue<std::string> history_pitch;
-            SpecialQueue<std::string> history_rhythm;
-            SpecialQueue<std::string> history_chord;
-            history_pitch.enqueue(row);
-            history_rhythm.enqueue(row);
-            history_chord.enqueue(row);
-            for(const auto& o : score.get_child("score-partwise")) {
-                if(o.first == "part") {
-                    int divisions = 64;
-                    for(const auto& p : o.second) {
-                        if(p.first == "measure") {
-                            divisions      = p.second.get<int>("attributes.divisions", divisions);
-                            int chord_size = 1;
-                            for(const auto& m : p.second) {
-                                if(m.first == "note") {
-                                    if(m.second.count("rest") == 0) {
-                                        bool unp = (m.second.count("unpitched") == 0);
-
-                                        /// Pitch
-                                        auto prepr = m.second.get<std::string>("pitch.step", "");
-                                        if(unp) {
-                                            if(m.second.get<int>("pitch.alter", 0) == -1) {
-                                                prepr += "b";
-                                            } else if(m.second.get<int>("pitch.alter", 0) == 1) {
-                                                prepr += "#";
-                                            }
-                                            prepr += m.second.get<std::string>("pitch.octave");
-                                            // auto pitch = (int)music::Note::pitch(prepr);
-                                            if(!matPitch.isColumn(prepr)) {
-                                                matPitch.addColumn(prepr);
-                                            }
-                                            if(!matPitch.isRow(prepr)) {
-                                                matPitch.addRow(prepr);
-                                            }
-
-                                            for(const auto& note : history_pitch.front()) {
-                                                matPitch.at(note, prepr) += 1;
-                                            }
-                                        }
-
-                                        /// Rhythm
-                                        std::string new_length =
-                                            std::to_string(new_divisions * m.second.get<int>("duration") / divisions);
-                                        if(!matRhythm.isColumn(new_length)) {
-                                            matRhythm.addColumn(new_length);
-                                        }
-                                        if(!matRhythm.isRow(new_length)) {
-                                            matRhythm.addRow(new_length);
-                                        }
-
-                                        for(const auto& note : history_rhythm.front()) {
-                                            matRhythm.at(note, new_length) += 1;
-                                        }
-
-                                        /// Control History
-                                        if(m.second.count("chord") == 1) {
-                                            chord_size += 1;
-                                            if(unp) {
-                                                history_pitch.enqueue(prepr, true);
-                                            }
-                                        } else {
-                                            if(unp) {
-                                                history_pitch.enqueue(prepr);
-                                                history_pitch.dequeue();
-                                            }
-
-                                            history_rhythm.enqueue(new_length);
-                                            history_rhythm.dequeue();
-
-                                            /// Chord Count
-                                            std::string chrd = std::to_string(chord_size);
-                                            if(!matChord.isColumn(chrd)) {
-                                                matChord.addColumn(chrd);
-                                            }
-                                            if(!matChord.isRow(chrd)) {
-                                                matChord.addRow(chrd);
-                                            }
-
-                                            for(const auto& note : history_chord.front()) {
-                                                matChord.at(note, chrd) += 1;
-                                            }
-
-                                            history_chord.enqueue(chrd);
-                                            history_chord.dequeue();
-
-                                            chord_size = 1;
-                                        }
-                                    } else { // rest
-                                        /// Pitch
-                                        std::string prepr = "rest";
-                                        if(!matPitch.isColumn(prepr)) {
-                                            matPitch.addColumn(prepr);
-                                        }
-                                        if(!matPitch.isRow(prepr)) {
-                                            matPitch.addRow(prepr);
-                                        }
-
-                                        for(const auto& note : history_pitch.front()) {
-                                            matPitch.at(note, prepr) += 1;
-                                        }
-                                        history_pitch.enqueue(prepr);
-                                        history_pitch.dequeue();
-
-                                        /// Rhythm
-                                        std::string new_length =
-                                            std::to_string(new_divisions * m.second.get<int>("duration") / divisions);
-                                        if(!matRhythm.isColumn(new_length)) {
-                                            matRhythm.addColumn(new_length);
-                                        }
-                                        if(!matRhythm.isRow(new_length)) {
-                                            matRhythm.addRow(new_length);
-                                        }
-
-                                        for(const auto& note : history_rhythm.front()) {
-                                            matRhythm.at(note, new_length) += 1;
-                                        }
-                                        history_rhythm.enqueue(new_length);
-                                        history_rhythm.dequeue();
-                                    }
+            // The manifest is written last and names the tables by their hashes, which commits the update
+            auto                  partial = generateMatrices(added, order, threads, cache);
+            std::vector<uint64_t> hashes;
+            for(unsigned int m = 0; m < mats.size(); ++m) {
+                mats.at(m).add(partial.at(m));
+                mats.at(m).toCSV(tables.at(m), ',', true);
+                hashes.emplace_back(util::FileHandler::hash(tables.at(m)));
+            }
+            known.setTables(hashes);
+            known.save(manifest);
+            return added.size();
+        }
+
+        namespace {
+            /**
+             * Count all transitions of a Score. The Measures are read one at a time.
+             * @param reader    The reader of the Score (a ScoreReader or a MidiReader).
+             * @param matPitch  The pitch matrix to update.
+             * @param matRhythm The rhythm matrix to update.
+             * @param matChord  The chord matrix to update.
+             * @param order     The amount of previous events that decide the next one.
+             */
+            template <typename Reader>
+            void train(Reader& reader, NamedMatrix& matPitch, NamedMatrix& matRhythm, NamedMatrix& matChord,
+                       unsigned int order) {
+                if(!reader.isScore()) {
+                    return;
+                }
+
+                std::string row = "begin";
+                if(!matPitch.isRow(row)) {
+                    matPitch.addRow(row);
+                }
+                int new_divisions = 64;
+                if(!matRhythm.isRow(row)) {
+                    matRhythm.addRow(row);
+                }
+                if(!matChord.isRow(row)) {
+                    matChord.addRow(row);
+                }
+                SpecialQueue<std::string> history_pitch;
+                SpecialQueue<std::string> history_rhythm;
+                SpecialQueue<std::string> history_chord;
+                for(unsigned int i = 0; i < order; ++i) {
+                    history_pitch.enqueue(row);
+                    history_rhythm.enqueue(row);
+                    history_chord.enqueue(row);
+                }
+
+                ScoreReader::Measure measure;
+                unsigned int         part      = 0;
+                int                  divisions = 64;
+                std::string          prepr;
+                while(reader.next(measure)) {
+                    if(measure.part != part) {
+                        part      = measure.part;
+                        divisions = 64;
+                    }
+                    if(measure.divisions > 0) {
+                        divisions = measure.divisions;
+                    }
+                    int chord_size = 1;
+                    for(const auto& note : measure.notes) {
+                        /// Rhythm
+                        std::string new_length = std::to_string(new_divisions * note.duration / divisions);
+
+                        if(!note.rest) {
+                            bool unp = !note.unpitched;
+
+                            /// Pitch
+                            if(unp) {
+                                prepr = note.step;
+                                if(note.alter == -1) {
+                                    prepr += "b";
+                                } else if(note.alter == 1) {
+                                    prepr += "#";
+                                }
+                                prepr += note.octave;
+                                count(matPitch, history_pitch, prepr);
+                            }
+
+                            count(matRhythm, history_rhythm, new_length);
+
+                            /// Control History
+                            if(note.chord) {
+                                chord_size += 1;
+                                if(unp) {
+                                    history_pitch.enqueue(prepr, true);
                                 }
+                            } else {
+                                if(unp) {
+                                    history_pitch.enqueue(prepr);
+                                    history_pitch.dequeue();
+                                }
+
+                                history_rhythm.enqueue(new_length);
+                                history_rhythm.dequeue();
+
+                                /// Chord Count
+                                std::string chrd = std::to_string(chord_size);
+                                count(matChord, history_chord, chrd);
+
+                                history_chord.enqueue(chrd);
+                                history_chord.dequeue();
+
+                                chord_size = 1;
                             }
+                        } else { // rest
+                            /// Pitch
+                            prepr = "rest";
+                            count(matPitch, history_pitch, prepr);
+                            history_pitch.enqueue(prepr);
+                            history_pitch.dequeue();
+
+                            /// Rhythm
+                            count(matRhythm, history_rhythm, new_length);
+                            history_rhythm.enqueue(new_length);
+                            history_rhythm.dequeue();
                         }
                     }
                 }
             }
         }
+
+        bool MarkovChain::generateMatrices(const std::string& filename, NamedMatrix& matPitch, NamedMatrix& matRhythm,
+                                           NamedMatrix& matChord, unsigned int order) {
+            if(MidiReader::isMidi(filename)) {
+                MidiReader reader{filename};
+                try {
+                    train(reader, matPitch, matRhythm, matChord, order);
+                } catch(const MidiReader::ParseError& ex) {
+                    std::cerr << "error in " << ex.filename() << " at byte " << ex.offset() << "\n\t=> " << ex.what()
+                              << std::endl;
+                    return false;
+                }
+                return true;
+            }
+
+            ScoreReader reader{filename};
+            try {
+                train(reader, matPitch, matRhythm, matChord, order);
+            } catch(const ScoreReader::ParseError& ex) {
+                std::cerr << "error in " << ex.filename() << ":" << ex.line() << "\n\t=> " << ex.what() << std::endl;
+                return false;
+            }
+            return true;
+        }
     }
 }
\ No newline at end of file
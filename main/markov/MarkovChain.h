@@ -19,10 +19,15 @@
 #define AUTOPLAY_MARKOVCHAIN_H
 
 #include "../util/RNEngine.h"
+#include "../util/UniformBlock.h"
 #include "NamedMatrix.h"
+#include "TransitionTable.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/range/iterator_range.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 using namespace boost::filesystem;
 
@@ -35,9 +40,11 @@ namespace autoplay {
         {
         public:
             using State = std::string;
+            using Id    = TransitionTable::Id;
 
             /**
-             * Constructor of a MarkovChain that is created from a CSV file.
+             * Constructor of a MarkovChain that is created from a CSV file or a binary model (see TransitionTable).
+             * A binary model is mapped into memory and used in place.
              * @param filename  The file to read from.
              * @param engine    The random engine to use.
              * @param begin     The initial State.
@@ -54,6 +61,22 @@ namespace autoplay {
             explicit MarkovChain(const NamedMatrix& namedMatrix, const util::RNEngine& engine,
                                  const State& begin = "begin");
 
+            /**
+             * Constructor of a MarkovChain that starts from the model of another chain, with its own random engine.
+             * The model is shared, so this does not depend on the size of the model.
+             * @param model     The chain to take the model from.
+             * @param engine    The random engine to use.
+             */
+            MarkovChain(const MarkovChain& model, const util::RNEngine& engine);
+
+            /**
+             * Save the model of the chain as a binary model file.
+             * @param filename  The file to write.
+             *
+             * @throws std::runtime_error When the file cannot be written.
+             */
+            inline void save(const std::string& filename) const { m_table.save(filename); }
+
             /**
              * Erases a set of States from the MarkovChain
              * @param erasables The set of elements that must be erased.
@@ -61,60 +84,224 @@ namespace autoplay {
             void erase(const std::vector<State>& erasables);
 
             /**
-             * Erases all States from the MarkovChain that do not appear in the set
-             * @param non_erasables The set of elements that must be erased.
+             * Erases all States from the MarkovChain that do not appear in the set. The model is not copied: the chain
+             * uses a view of it (see TransitionTable::filter).
+             * @param non_erasables The set of elements that must be kept.
              */
             void keep(const std::vector<State>& non_erasables);
 
             /**
-             * Resets the MarkovChain to its initial State.
+             * Resets the MarkovChain to its initial State. The constraints (see constrain()) are removed.
              */
-            inline void reset() { m_current = m_begin; }
+            inline void reset() {
+                std::fill(m_history.begin(), m_history.end(), m_begin_id);
+                m_steps = m_step = 0;
+            }
 
             /**
              * Gets the current State of the chain.
              * @return The State of the chain.
              */
-            inline State getState() const { return m_current; }
+            inline State getState() const {
+                return m_history.back() == TransitionTable::NONE ? m_begin : state(m_history.back());
+            }
+
+            /**
+             * Gets the initial State of the chain.
+             * @return The begin State.
+             */
+            inline const State& begin() const { return m_begin; }
+
+            /**
+             * Get the order of the chain, i.e. the amount of previous States that decide the next one.
+             * @return The order of the chain.
+             */
+            inline std::size_t order() const { return m_history.size(); }
+
+            /**
+             * Get the compact form of the model of the chain.
+             * @return The TransitionTable.
+             */
+            inline const TransitionTable& table() const { return m_table; }
+
+            /**
+             * Get the name of a State.
+             * @param id    The id of the State, as returned by next().
+             * @return The State.
+             */
+            inline const State& state(Id id) const { return m_table.name(id); }
+
+            /**
+             * Go to the next State. This does not allocate; use state() to get the name of the new State.
+             * When the last order() States have never been seen together, the longest known part of them is used.
+             * @return The id of the new State.
+             *
+             * @throws std::out_of_range When the current State is unknown or has no transitions.
+             */
+            Id next();
+
+            /**
+             * Go to the next State, without going to some States when that is possible. When there are constraints
+             * (see constrain()), only States from which they can still be met are gone to. When none of the rows of
+             * the history can go to such a State, the avoided States are allowed again.
+             * @param avoid The ids of the States that should not be gone to.
+             * @return The id of the new State.
+             *
+             * @throws std::out_of_range When the current State is unknown, or cannot go to an allowed State.
+             */
+            Id next(const std::vector<Id>& avoid);
+
+            /**
+             * Constrain the next States of the chain, e.g. to end on a certain State. A backward pass over the
+             * transitions computes, for each of the next steps, how likely the constraints after it can still be met
+             * from each State. next() uses this to only go to States from which they can, so a sequence that meets
+             * all constraints is generated in a single pass, without rejecting or changing any State. For a chain of
+             * order 1, the States have exactly the chances of the chain, given that the constraints are met.
+             *
+             * Higher orders use the first-order rows for the backward pass; a longer context that cannot go to a
+             * valid State falls back to a shorter one. The constraints are removed after the last constrained step.
+             * @param allowed   For each of the next steps, the States that the chain may go to. An empty set
+             *                  allows all States.
+             *
+             * @throws std::invalid_argument When no sequence from the current State meets the constraints. The chain
+             *                               is not constrained then.
+             */
+            void constrain(const std::vector<std::vector<State>>& allowed);
 
             /**
-             * Go to the next State.
-             * @return The new State.
+             * Get the amount of next steps that are still constrained.
+             * @return The amount of steps, or 0 when the chain is not constrained.
              */
-            State next();
+            inline std::size_t constrained() const { return m_steps - m_step; }
 
         private:
-            NamedMatrix    m_matrix;  ///< The transition matrix
-            util::RNEngine m_engine;  ///< The random engine to use
-            State          m_current; ///< The current State
-            State          m_begin;   ///< The begin/start State
+            std::shared_ptr<const NamedMatrix> m_matrix; ///< The normalized transition matrix, if it has been loaded
+            TransitionTable                    m_table;  ///< The compact form of the matrix, to go to the next State
+            util::RNEngine     m_engine;   ///< The random engine to use
+            util::UniformBlock m_uniform;  ///< The prefetched random numbers of m_engine
+            std::vector<Id>    m_history;  ///< The last order() States, from the oldest to the current one
+            State              m_begin;    ///< The begin/start State
+            Id                 m_begin_id; ///< The id of the begin/start State
+
+            std::vector<double> m_first;   ///< The dense first-order chances between the columns, once constrained
+            std::vector<double> m_reach;   ///< Per constrained step and column, how likely the constraints are met
+            std::vector<double> m_weights; ///< The weights of the columns for the next State
+            std::size_t         m_steps;   ///< The amount of constrained steps
+            std::size_t         m_step;    ///< The next constrained step
+
+            /**
+             * Weigh the columns the chain can go to, with the chances of the longest suffix of the history that can
+             * go to a column that is allowed at the next step and not avoided. The weights are stored in m_weights.
+             * @param avoid The ids of the States that must not be gone to.
+             * @return The sum of the weights, or 0 when no suffix of the history can go to such a column.
+             */
+            double weigh(const std::vector<Id>& avoid);
+
+            /**
+             * Replace the TransitionTable after the matrix has changed, keeping the most recent States.
+             * @param table The new table.
+             */
+            void rebuild(const TransitionTable& table);
 
             /**
-             * Fetches a map of all possible States to go to.
-             * @return A map in the form of < State, chance to get there from current state >
+             * Get a copy of the transition matrix to change. When the chain has been loaded from a binary model, the
+             * matrix is created from the TransitionTable.
+             * @return The normalized transition matrix.
              */
-            std::map<State, double> fetchPossibilities() const;
+            NamedMatrix matrix() const;
 
             /// Special functions for machine-learning itself
         public:
             /**
-             * Generate a matrix from a list of MusicXML files in a certain directory.
+             * Generate a matrix from a list of MusicXML files and Standard MIDI Files (see MidiReader) in a certain
+             * directory.
              * @param directory The directory to read from.
              * @param recursive When true, it continues to look for files in subdirectories.
+             * @param order     The amount of previous events that decide the next one. The rows of the matrices
+             *                  are the contexts of 1 up to order events (see TransitionTable), so a chain can fall
+             *                  back to a shorter context when a longer one has never been seen.
+             * @param threads   The amount of threads to read the files with. When 0, the amount of hardware threads
+             *                  is used. The result does not depend on it.
+             * @param cache     The directory of a TrainingCache. When not empty, only the files of which the counts
+             *                  are not in it yet are read. The result does not depend on it.
+             * @return A vector of three NamedMatrix that represent the Markov Chains.
+             *
+             * @throws std::invalid_argument When the order is 0.
+             * @throws std::runtime_error When the cache cannot be read or written.
+             */
+            static std::vector<NamedMatrix> generateMatrices(const path& directory, bool recursive = true,
+                                                             unsigned int order = 1, unsigned int threads = 1,
+                                                             const std::string& cache = "");
+
+            /**
+             * Generate a matrix from a list of MusicXML files and Standard MIDI Files.
+             * @param files     The files to read. The result does not depend on their order.
+             * @param order     The amount of previous events that decide the next one.
+             * @param threads   The amount of threads to read the files with. When 0, the amount of hardware threads
+             *                  is used.
+             * @param cache     The directory of a TrainingCache, or empty to read all files.
              * @return A vector of three NamedMatrix that represent the Markov Chains.
+             *
+             * @throws std::invalid_argument When the order is 0.
+             * @throws std::runtime_error When the cache cannot be read or written.
+             */
+            static std::vector<NamedMatrix> generateMatrices(const std::vector<std::string>& files,
+                                                             unsigned int order = 1, unsigned int threads = 1,
+                                                             const std::string& cache = "");
+
+            /**
+             * Update the raw counts of a previous training with the scores (see findScores()) that have been added to a
+             * directory since. The files that have been used are remembered in a Manifest; files of which the size
+             * or modification time has changed are reported, but not read again. The tables are only replaced once
+             * all new files have been read, and the Manifest is written last, with the hashes of the new tables.
+             * Tables that do not match the hashes in the Manifest are left by an interrupted update, and are refused.
+             *
+             * When neither the tables nor the Manifest exist, this is the same as a complete training.
+             * @param directory The directory to read from.
+             * @param tables    The CSV files of the pitch, rhythm and chord counts.
+             * @param manifest  The file of the Manifest.
+             * @param recursive When true, it continues to look for files in subdirectories.
+             * @param order     The amount of previous events that decide the next one. It must be the same as the
+             *                  order in the Manifest.
+             * @param threads   The amount of threads to read the new files with. When 0, the amount of hardware
+             *                  threads is used.
+             * @param cache     The directory of a TrainingCache, or empty to read all new files.
+             * @return The amount of files that have been added.
+             *
+             * @throws std::invalid_argument When the order is 0 or differs from the order in the Manifest.
+             * @throws std::runtime_error When the tables exist without a Manifest (or the other way around), when
+             *                            they do not match the Manifest, or when a file cannot be read or written.
+             */
+            static std::size_t updateMatrices(const path& directory, const std::vector<std::string>& tables,
+                                              const std::string& manifest, bool recursive = true,
+                                              unsigned int order = 1, unsigned int threads = 1,
+                                              const std::string& cache = "");
+
+            /**
+             * Find all MusicXML files (with the '.xml' extension) and Standard MIDI Files (with the '.mid' or '.midi'
+             * extension) in a directory.
+             * @param directory The directory to look in.
+             * @param recursive When true, it continues to look for files in subdirectories.
+             * @return The paths of the files, sorted.
+             *
+             * @throws std::runtime_error When the path is not a directory.
              */
-            static std::vector<NamedMatrix> generateMatrices(const path& directory, bool recursive = true);
+            static std::vector<std::string> findScores(const path& directory, bool recursive = true);
 
         private:
             /**
-             * Helper function for generating matrices.
-             * @param filename  The filename of the MusicXML file to read.
+             * Helper function for generating matrices. A MusicXML file is streamed one Measure at a time with a
+             * ScoreReader; a Standard MIDI File is read with a MidiReader.
+             * @param filename  The filename of the MusicXML file or Standard MIDI File to read.
              * @param matPitch  The pitch matrix to update.
              * @param matRhythm The rhythm matrix to update.
              * @param matChord  The chord matrix to update.
+             * @param order     The amount of previous events that decide the next one.
+             * @return False when a parse error has been reported; the matrices then contain the counts of the part of
+             *         the file before the error.
              */
-            static void generateMatrices(const std::string& filename, NamedMatrix& matPitch, NamedMatrix& matRhythm,
-                                         NamedMatrix& matChord);
+            static bool generateMatrices(const std::string& filename, NamedMatrix& matPitch, NamedMatrix& matRhythm,
+                                         NamedMatrix& matChord, unsigned int order);
         };
     }
 }
@@ -0,0 +1,312 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "MidiReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+namespace autoplay {
+    namespace markov {
+        namespace {
+            /**
+             * Quantize a time in MIDI ticks to the grid of the Measures.
+             * @param tick  The time in ticks.
+             * @param ppq   The amount of ticks per quarter note.
+             * @return The time in MidiReader::DIVISIONS per quarter note, rounded to the nearest one.
+             */
+            unsigned int quantize(uint64_t tick, unsigned int ppq) {
+                return (unsigned int)((tick * MidiReader::DIVISIONS + ppq / 2) / ppq);
+            }
+        }
+
+        MidiReader::MidiReader(std::string filename)
+            : m_filename(std::move(filename)), m_data(), m_pos(0), m_end(0), m_parts(), m_signatures(), m_part(0),
+              m_event(0), m_at(0) {}
+
+        bool MidiReader::isScore() {
+            std::ifstream file{m_filename, std::ios::binary};
+            if(!file.is_open()) {
+                error("cannot open file");
+            }
+            m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            m_pos = 0;
+            m_end = m_data.size();
+            if(m_data.size() < 4 || std::memcmp(m_data.data(), "MThd", 4) != 0) {
+                return false;
+            }
+
+            m_pos       = 4;
+            auto length = number(4);
+            if(length < 6 || length > m_end - m_pos) {
+                error("invalid header chunk length");
+            }
+            auto header   = m_pos + length;
+            auto format   = number(2);
+            number(2); // The amount of tracks; all track chunks are read
+            auto division = number(2);
+            if(format > 2) {
+                error("unknown format " + std::to_string(format));
+            }
+            if(division & 0x8000) {
+                error("SMPTE time divisions are not supported");
+            }
+            if(division == 0) {
+                error("the time division is 0");
+            }
+            if(format == 2) {
+                return false;
+            }
+
+            m_pos = header;
+            m_parts.clear();
+            m_signatures = {{0, {4, 4}}};
+            while(m_end - m_pos >= 8) {
+                bool chunk = std::memcmp(m_data.data() + m_pos, "MTrk", 4) == 0;
+                m_pos += 4;
+                auto size = number(4);
+                if(size > m_end - m_pos) {
+                    error("the chunk is longer than the file");
+                }
+                auto end = m_pos + size;
+                if(chunk) {
+                    track(end, division);
+                }
+                m_pos = end;
+            }
+
+            m_part  = 0;
+            m_event = 0;
+            m_at    = 0;
+            return true;
+        }
+
+        bool MidiReader::next(ScoreReader::Measure& measure) {
+            // Pitches spelled like music::Note::pitchRepr
+            static const char* const STEPS[12]  = {"C", "D", "D", "E", "E", "F", "G", "G", "A", "A", "B", "B"};
+            static const int         ALTERS[12] = {0, -1, 0, -1, 0, 0, -1, 0, -1, 0, -1, 0};
+
+            while(m_part < m_parts.size()) {
+                const auto& current = m_parts[m_part];
+                if(m_event == current.events.size()) {
+                    ++m_part;
+                    m_event = 0;
+                    m_at    = 0;
+                    continue;
+                }
+
+                // A Measure ends after the length of its time signature, or at the next time signature
+                auto         sig = m_signatures.upper_bound(m_at);
+                unsigned int end = sig == m_signatures.end() ? std::numeric_limits<unsigned int>::max() : sig->first;
+                --sig;
+                end = std::min(end, m_at + DIVISIONS * 4 * sig->second.first / sig->second.second);
+
+                measure.part      = (unsigned int)m_part;
+                measure.divisions = m_at == 0 ? DIVISIONS : 0;
+                measure.notes.clear();
+                while(m_event < current.events.size() && m_at < end) {
+                    const auto& event = current.events[m_event];
+                    auto        stop  = std::min(event.start + event.duration, end);
+
+                    ScoreReader::Note note{"", 0, "", (int)(stop - m_at), event.pitches.empty(), false, false};
+                    if(note.rest) {
+                        measure.notes.emplace_back(note);
+                    }
+                    for(std::size_t i = 0; i < event.pitches.size(); ++i) {
+                        auto pitch     = event.pitches[i];
+                        note.step      = STEPS[pitch % 12];
+                        note.alter     = ALTERS[pitch % 12];
+                        note.octave    = std::to_string(pitch / 12 - 1);
+                        note.unpitched = current.percussion;
+                        note.chord     = i > 0;
+                        measure.notes.emplace_back(note);
+                    }
+
+                    m_at = stop;
+                    if(m_at == event.start + event.duration) {
+                        ++m_event;
+                    }
+                }
+                return true;
+            }
+            return false;
+        }
+
+        bool MidiReader::isMidi(const std::string& filename) {
+            auto dot = filename.find_last_of("./\\");
+            if(dot == std::string::npos || filename[dot] != '.') {
+                return false;
+            }
+            auto extension = filename.substr(dot);
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                           [](char c) { return (char)std::tolower((unsigned char)c); });
+            return extension == ".mid" || extension == ".midi";
+        }
+
+        void MidiReader::track(std::size_t end, unsigned int ppq) {
+            m_end = end;
+
+            uint64_t                                                    tick   = 0;
+            uint8_t                                                     status = 0;
+            std::vector<std::vector<Note>>                              notes(16);
+            std::map<std::pair<uint8_t, uint8_t>, std::deque<uint64_t>> open; // <channel, key> -> start times
+
+            auto add = [&](uint8_t channel, uint8_t key, uint64_t on) {
+                auto from = quantize(on, ppq);
+                notes[channel].push_back({from, std::max(quantize(tick, ppq), from + 1), key});
+            };
+
+            while(m_pos < m_end) {
+                tick += variable();
+                auto b = byte();
+                if(b == 0xFF) {
+                    auto type   = byte();
+                    auto length = variable();
+                    if(length > m_end - m_pos) {
+                        error("the meta event is longer than the track");
+                    }
+                    if(type == 0x2F) { // End of track
+                        break;
+                    }
+                    if(type == 0x58 && length >= 2) { // Time signature
+                        auto numerator   = m_data[m_pos];
+                        auto denominator = m_data[m_pos + 1];
+                        if(numerator > 0 && denominator < 8) {
+                            m_signatures[quantize(tick, ppq)] = {numerator, 1u << denominator};
+                        }
+                    }
+                    m_pos += length;
+                    continue;
+                }
+                if(b == 0xF0 || b == 0xF7) { // System exclusive
+                    auto length = variable();
+                    if(length > m_end - m_pos) {
+                        error("the system exclusive event is longer than the track");
+                    }
+                    m_pos += length;
+                    continue;
+                }
+
+                uint8_t data;
+                if(b & 0x80) {
+                    if(b > 0xEF) {
+                        error("unexpected system message");
+                    }
+                    status = b;
+                    data   = byte();
+                } else if(status == 0) {
+                    error("data byte without a running status");
+                } else {
+                    data = b;
+                }
+                uint8_t type     = status & 0xF0;
+                uint8_t channel  = status & 0x0F;
+                uint8_t velocity = type == 0xC0 || type == 0xD0 ? 0 : byte();
+                if((data | velocity) & 0x80) {
+                    error("invalid data byte");
+                }
+
+                if(type == 0x90 && velocity > 0) {
+                    open[{channel, data}].push_back(tick);
+                } else if(type == 0x80 || type == 0x90) {
+                    auto& on = open[{channel, data}];
+                    if(!on.empty()) {
+                        add(channel, data, on.front());
+                        on.pop_front();
+                    }
+                }
+            }
+
+            // Notes that are never released end with the track
+            for(const auto& kv : open) {
+                for(const auto& on : kv.second) {
+                    add(kv.first.first, kv.first.second, on);
+                }
+            }
+            for(uint8_t channel = 0; channel < 16; ++channel) {
+                if(!notes[channel].empty()) {
+                    part(notes[channel], channel == 9);
+                }
+            }
+            m_end = m_data.size();
+        }
+
+        void MidiReader::part(std::vector<Note>& notes, bool percussion) {
+            std::sort(notes.begin(), notes.end(), [](const Note& a, const Note& b) {
+                return a.on < b.on || (a.on == b.on && a.pitch < b.pitch);
+            });
+
+            Part         res{percussion, {}};
+            unsigned int at = 0;
+            for(std::size_t i = 0; i < notes.size();) {
+                Event chord{notes[i].on, 0, {}};
+                unsigned int off = chord.start;
+                for(; i < notes.size() && notes[i].on == chord.start; ++i) {
+                    off = std::max(off, notes[i].off);
+                    if(chord.pitches.empty() || chord.pitches.back() != notes[i].pitch) {
+                        chord.pitches.emplace_back(notes[i].pitch);
+                    }
+                }
+                // A Chord is cut off by the next one
+                if(i < notes.size()) {
+                    off = std::min(off, notes[i].on);
+                }
+                if(chord.start > at) {
+                    res.events.push_back({at, chord.start - at, {}});
+                }
+                chord.duration = off - chord.start;
+                res.events.emplace_back(std::move(chord));
+                at = off;
+            }
+            m_parts.emplace_back(std::move(res));
+        }
+
+        uint32_t MidiReader::number(unsigned int bytes) {
+            uint32_t res = 0;
+            for(unsigned int i = 0; i < bytes; ++i) {
+                res = (res << 8) | byte();
+            }
+            return res;
+        }
+
+        uint32_t MidiReader::variable() {
+            uint32_t res = 0;
+            for(int i = 0; i < 4; ++i) {
+                auto b = byte();
+                res    = (res << 7) | (b & 0x7F);
+                if(!(b & 0x80)) {
+                    return res;
+                }
+            }
+            error("variable-length quantity of more than 4 bytes");
+        }
+
+        uint8_t MidiReader::byte() {
+            if(m_pos >= m_end) {
+                error("unexpected end of chunk");
+            }
+            return m_data[m_pos++];
+        }
+
+        void MidiReader::error(const std::string& message) const { throw ParseError(message, m_filename, m_pos); }
+    }
+}
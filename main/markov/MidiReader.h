@@ -0,0 +1,192 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_MIDIREADER_H
+#define AUTOPLAY_MIDIREADER_H
+
+#include "ScoreReader.h"
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The MidiReader class reads a Standard MIDI File (format 0 or 1) into the same Measures as a ScoreReader,
+         * so the Markov training can use a MIDI corpus without converting it to MusicXML first.
+         *
+         * Each combination of a track and a channel becomes a Part; channel 10 is played by percussion, so its Notes
+         * are unpitched. All times are quantized to a grid of DIVISIONS per quarter note. The Notes that start at
+         * the same time form a Chord, which lasts until the next Chord starts or its longest Note ends; the time in
+         * between Chords becomes a rest. Notes that cross a barline are split, like tied Notes in MusicXML. The
+         * barlines follow the time signature meta events (4/4 by default). Tempo changes do not change the note
+         * values, so they are skipped like all other meta and system exclusive events.
+         *
+         * Pitches are spelled with flats, in the same way as music::Note::pitchRepr.
+         */
+        class MidiReader
+        {
+        public:
+            static constexpr int DIVISIONS = 64; ///< The amount of ticks of a quarter note in the Measures
+
+            /**
+             * The ParseError is thrown when the file could not be opened, or is no valid Standard MIDI File.
+             */
+            class ParseError : public std::runtime_error
+            {
+            public:
+                /**
+                 * Constructor
+                 * @param message   The description of the error.
+                 * @param filename  The name of the file.
+                 * @param offset    The position in the file at which the error occurred.
+                 */
+                ParseError(const std::string& message, std::string filename, std::size_t offset)
+                    : std::runtime_error(message), m_filename(std::move(filename)), m_offset(offset) {}
+
+                /**
+                 * Get the name of the file in which the error occurred.
+                 * @return The filename.
+                 */
+                inline const std::string& filename() const { return m_filename; }
+
+                /**
+                 * Get the position at which the error occurred.
+                 * @return The offset in bytes, from the start of the file.
+                 */
+                inline std::size_t offset() const { return m_offset; }
+
+            private:
+                std::string m_filename; ///< The name of the file
+                std::size_t m_offset;   ///< The offset of the error
+            };
+
+            /**
+             * Constructor
+             * @param filename  The file to read.
+             */
+            explicit MidiReader(std::string filename);
+
+            /**
+             * Read all tracks of the file, and check that it is a Standard MIDI File of format 0 or 1.
+             * @return True if it is; format 2 files (and files without a header chunk) are no Scores.
+             *
+             * @throws MidiReader::ParseError When the file could not be opened, or a chunk is not well-formed.
+             */
+            bool isScore();
+
+            /**
+             * Get the next Measure of the Score. Must only be called after isScore() returned true.
+             * @param measure   The Measure to fill in. Its Notes are reused.
+             * @return True if a Measure has been read, false at the end of the file.
+             */
+            bool next(ScoreReader::Measure& measure);
+
+            /**
+             * Check if a file is a Standard MIDI File, by looking at its extension.
+             * @param filename  The name of the file.
+             * @return True for the '.mid' and '.midi' extensions, in any case.
+             */
+            static bool isMidi(const std::string& filename);
+
+        private:
+            /**
+             * A Chord (or rest) of a Part, on the quantized grid.
+             */
+            struct Event {
+                unsigned int         start;    ///< The time at which it starts
+                unsigned int         duration; ///< Its duration
+                std::vector<uint8_t> pitches;  ///< The pitches, from low to high; empty for a rest
+            };
+
+            /**
+             * A Part, as a sequence of Events without gaps, starting at 0.
+             */
+            struct Part {
+                bool               percussion; ///< True if the Part is played on channel 10
+                std::vector<Event> events;     ///< The Events, in order
+            };
+
+            /**
+             * A Note, as it is read from a track.
+             */
+            struct Note {
+                unsigned int on;    ///< The quantized time at which it starts
+                unsigned int off;   ///< The quantized time at which it ends
+                uint8_t      pitch; ///< The key of the Note
+            };
+
+            /**
+             * Read a track chunk and add a Part for each channel that plays Notes in it.
+             * @param end   The offset of the end of the chunk.
+             * @param ppq   The amount of ticks per quarter note of the file.
+             */
+            void track(std::size_t end, unsigned int ppq);
+
+            /**
+             * Turn the Notes of a channel into a Part.
+             * @param notes         The Notes; they are sorted.
+             * @param percussion    True if the channel is played by percussion.
+             */
+            void part(std::vector<Note>& notes, bool percussion);
+
+            /**
+             * Read a big-endian number of a number of bytes.
+             * @param bytes The amount of bytes.
+             * @return The number.
+             */
+            uint32_t number(unsigned int bytes);
+
+            /**
+             * Read a variable-length quantity.
+             * @return The number.
+             */
+            uint32_t variable();
+
+            /**
+             * Read a single byte.
+             * @return The byte.
+             */
+            uint8_t byte();
+
+            /**
+             * Throw a ParseError at the current position.
+             * @param message   The description of the error.
+             */
+            [[noreturn]] void error(const std::string& message) const;
+
+        private:
+            std::string          m_filename; ///< The name of the file
+            std::vector<uint8_t> m_data;     ///< The content of the file
+            std::size_t          m_pos;      ///< The position of the next byte in m_data
+            std::size_t          m_end;      ///< The end of the chunk that is being read
+
+            std::vector<Part>                                         m_parts;      ///< The Parts of the file
+            std::map<unsigned int, std::pair<unsigned int, unsigned int>> m_signatures; ///< Time -> time signature
+
+            std::size_t  m_part;  ///< The index of the Part that is being read
+            std::size_t  m_event; ///< The index of the next Event of that Part
+            unsigned int m_at;    ///< The time up to which that Part has been read
+        };
+    }
+}
+
+#endif // AUTOPLAY_MIDIREADER_H
@@ -0,0 +1,70 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "ModelRegistry.h"
+
+#include <algorithm>
+
+namespace autoplay {
+    namespace markov {
+        ModelRegistry& ModelRegistry::instance() {
+            static ModelRegistry registry;
+            return registry;
+        }
+
+        std::shared_ptr<const MarkovChain> ModelRegistry::model(const std::string& filename) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return load(filename);
+        }
+
+        std::shared_ptr<const MarkovChain> ModelRegistry::model(const std::string& filename,
+                                                                std::vector<std::string> keep) {
+            std::sort(keep.begin(), keep.end());
+            keep.erase(std::unique(keep.begin(), keep.end()), keep.end());
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            View                        key{filename, std::move(keep)};
+            auto                        it = m_views.find(key);
+            if(it == m_views.end()) {
+                auto view = std::make_shared<MarkovChain>(*load(filename), util::RNEngine{});
+                view->keep(key.second);
+                it = m_views.insert({std::move(key), view}).first;
+            }
+            return it->second;
+        }
+
+        std::size_t ModelRegistry::size() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_models.size();
+        }
+
+        void ModelRegistry::clear() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_models.clear();
+            m_views.clear();
+        }
+
+        std::shared_ptr<const MarkovChain> ModelRegistry::load(const std::string& filename) {
+            auto it = m_models.find(filename);
+            if(it == m_models.end()) {
+                auto chain = std::make_shared<const MarkovChain>(filename, util::RNEngine{});
+                it         = m_models.insert({filename, chain}).first;
+            }
+            return it->second;
+        }
+    }
+}
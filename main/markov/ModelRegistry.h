@@ -0,0 +1,102 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_MODELREGISTRY_H
+#define AUTOPLAY_MODELREGISTRY_H
+
+#include "MarkovChain.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The ModelRegistry class holds the models of all Markov Chains that are used by the process. Each file is
+         * loaded only once, and its model is shared (read-only) by all Parts, generations and threads. A chain for a
+         * Part is created from a model with its own random engine (see MarkovChain(const MarkovChain&, ...)).
+         *
+         * A model that is restricted to a set of States (e.g. the pitches in the range of a stave) is a view of the
+         * full model (see TransitionTable::filter), and is also only created once for each set.
+         */
+        class ModelRegistry
+        {
+        public:
+            /**
+             * Get the registry of the process.
+             * @return The registry.
+             */
+            static ModelRegistry& instance();
+
+            /**
+             * Get the model of a Markov Chain. It is loaded the first time it is asked for.
+             * @param filename  The CSV file or binary model of the Markov Chain.
+             * @return The chain that holds the model.
+             *
+             * @throws std::runtime_error When the file cannot be read.
+             */
+            std::shared_ptr<const MarkovChain> model(const std::string& filename);
+
+            /**
+             * Get the model of a Markov Chain, restricted to a set of States.
+             * @param filename  The CSV file or binary model of the Markov Chain.
+             * @param keep      The States the chain may go to. Neither their order nor duplicates matter.
+             * @return The chain that holds the restricted model.
+             *
+             * @throws std::runtime_error When the file cannot be read.
+             */
+            std::shared_ptr<const MarkovChain> model(const std::string& filename, std::vector<std::string> keep);
+
+            /**
+             * Get the amount of files that have been loaded.
+             * @return The amount of models.
+             */
+            std::size_t size() const;
+
+            /**
+             * Forget all models, so they are loaded again when they are asked for. The models stay valid as long as
+             * they are used.
+             */
+            void clear();
+
+        private:
+            /// Only instance() creates the registry
+            ModelRegistry() = default;
+
+            /**
+             * Get the model of a file, assuming the mutex is locked.
+             * @param filename  The CSV file or binary model of the Markov Chain.
+             * @return The chain that holds the model.
+             */
+            std::shared_ptr<const MarkovChain> load(const std::string& filename);
+
+        private:
+            using View = std::pair<std::string, std::vector<std::string>>;
+
+            mutable std::mutex m_mutex; ///< Guards the maps
+
+            std::map<std::string, std::shared_ptr<const MarkovChain>> m_models; ///< Filename -> model
+            std::map<View, std::shared_ptr<const MarkovChain>>        m_views;  ///< (filename, States) -> view
+        };
+    }
+}
+
+#endif // AUTOPLAY_MODELREGISTRY_H
@@ -18,7 +18,9 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <fstream>
+#include <limits>
 
+#include "../util/FileHandler.h"
 #include "NamedMatrix.h"
 
 namespace autoplay {
@@ -128,6 +130,24 @@ namespace autoplay {
             }
         }
 
+        void NamedMatrix::add(const NamedMatrix& other) {
+            for(const auto& col : other.m_colmap) {
+                if(!isColumn(col.first)) {
+                    addColumn(col.first);
+                }
+            }
+            for(const auto& row : other.m_rowmap) {
+                if(!isRow(row.first)) {
+                    addRow(row.first);
+                }
+                auto& dst = at(m_rowmap.at(row.first));
+                auto& src = other.at(row.second);
+                for(const auto& col : other.m_colmap) {
+                    dst.at(m_colmap.at(col.first)) += src.at(col.second);
+                }
+            }
+        }
+
         bool NamedMatrix::empty() const {
             bool r = true;
             for(const auto& row : m_matrix) {
@@ -191,6 +211,57 @@ namespace autoplay {
             } catch(std::out_of_range& e) { return false; }
         }
 
+        namespace {
+            /**
+             * Renumber the kept names of an index, in the order of their old indices.
+             * @param index The index to select from.
+             * @param keep  The names to keep.
+             * @param old   Filled with the old index of each new index.
+             * @return The new index.
+             */
+            std::map<std::string, unsigned long> reindex(const std::map<std::string, unsigned long>& index,
+                                                         const std::vector<std::string>&             keep,
+                                                         std::vector<unsigned long>&                 old) {
+                std::vector<const std::string*> names(index.size(), nullptr);
+                for(const auto& name : keep) {
+                    auto it = index.find(name);
+                    if(it != index.end()) {
+                        names[it->second] = &it->first;
+                    }
+                }
+
+                std::map<std::string, unsigned long> res;
+                old.clear();
+                for(unsigned long i = 0; i < names.size(); ++i) {
+                    if(names[i] != nullptr) {
+                        res.emplace(*names[i], old.size());
+                        old.emplace_back(i);
+                    }
+                }
+                return res;
+            }
+        }
+
+        NamedMatrix NamedMatrix::project(const std::vector<std::string>& rows,
+                                         const std::vector<std::string>& columns) const {
+            NamedMatrix                res;
+            std::vector<unsigned long> old_rows;
+            std::vector<unsigned long> old_cols;
+            res.m_rowmap = reindex(m_rowmap, rows, old_rows);
+            res.m_colmap = reindex(m_colmap, columns, old_cols);
+
+            res.m_matrix.resize(old_rows.size());
+            for(unsigned long r = 0; r < old_rows.size(); ++r) {
+                const auto& src = m_matrix[old_rows[r]];
+                auto&       dst = res.m_matrix[r];
+                dst.reserve(old_cols.size());
+                for(const auto& c : old_cols) {
+                    dst.emplace_back(src[c]);
+                }
+            }
+            return res;
+        }
+
         std::vector<std::string> NamedMatrix::getColumns() const {
             std::vector<std::string> res;
             for(const auto& col : m_colmap) {
@@ -207,34 +278,33 @@ namespace autoplay {
             return res;
         }
 
-        void NamedMatrix::toCSV(const std::string& filename, char sep) const {
+        void NamedMatrix::toCSV(const std::string& filename, char sep, bool replace) const {
             // Check if file exists
             std::ifstream f(filename);
             bool          exists = f.good();
             f.close();
-            if(exists) {
+            if(exists && !replace) {
                 throw std::runtime_error("Undefined behaviour for writing a CSV to an existing file '" + filename +
                                          "'.");
             }
 
-            // Create file
-            std::ofstream file(filename);
+            util::FileHandler::writeAtomic(filename, [this, sep](std::ostream& out) { toCSV(out, sep); });
+        }
 
-            if(file.is_open()) {
-                file << "x";
-                for(const auto& kv : m_colmap) {
-                    file << sep << " \"" << kv.first << "\"";
-                }
-                for(const auto& kv : m_rowmap) {
-                    file << "\n\"" << kv.first << "\"";
-                    for(const auto& ckv : m_colmap) {
-                        file << sep << " " << at(kv.first, ckv.first);
-                    }
+        void NamedMatrix::toCSV(std::ostream& out, char sep) const {
+            // Enough digits to read back the exact same values
+            auto precision = out.precision(std::numeric_limits<double>::max_digits10);
+            out << "x";
+            for(const auto& kv : m_colmap) {
+                out << sep << " \"" << kv.first << "\"";
+            }
+            for(const auto& kv : m_rowmap) {
+                out << "\n\"" << kv.first << "\"";
+                for(const auto& ckv : m_colmap) {
+                    out << sep << " " << m_matrix[kv.second][ckv.second];
                 }
-                file.close();
-            } else {
-                throw std::runtime_error("Unable to open file with filename '" + filename + "'");
             }
+            out.precision(precision);
         }
 
         NamedMatrix NamedMatrix::fromCSV(const std::string& filename, char sep) {
@@ -242,9 +312,13 @@ namespace autoplay {
             if(file.is_open()) {
                 NamedMatrix nm;
                 std::string line;
+                // split_on drops the part after the last separator, so one is added to each line
+                auto split = [sep](const std::string& l) {
+                    return split_on(!l.empty() && l.back() == sep ? l : l + sep, sep);
+                };
                 if(getline_safe(file, line)) {
                     // Header
-                    std::vector<std::string> names = split_on(line, sep);
+                    std::vector<std::string> names = split(line);
                     names.erase(names.begin()); // remove useless header column
                     // remove surrounding quotes and insert as column
                     for(auto& name : names) {
@@ -256,13 +330,13 @@ namespace autoplay {
                     if(line.empty()) {
                         continue;
                     }
-                    std::vector<std::string> values = split_on(line, sep);
+                    std::vector<std::string> values = split(line);
                     std::string              name   = values.at(0);
                     name                            = name.substr(1, name.length() - 2);
                     nm.addRow(name);
                     values.erase(values.begin()); // remove name from sequence
                     for(unsigned int col = 0; col < values.size(); ++col) {
-                        nm.at(nm.m_rowmap.at(name), col) = std::stof(values.at(col));
+                        nm.at(nm.m_rowmap.at(name), col) = std::stod(values.at(col));
                     }
                 }
                 file.close();
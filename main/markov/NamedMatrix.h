@@ -19,6 +19,7 @@
 #define AUTOPLAY_NAMEDMATRIX_H
 
 #include <map>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -133,6 +134,13 @@ namespace autoplay {
              */
             void normalizeRows();
 
+            /**
+             * Add all elements of another matrix to this one, by name. Rows and columns that do not exist yet are
+             * added first.
+             * @param other The matrix to add.
+             */
+            void add(const NamedMatrix& other);
+
             /**
              * Checks if the matrix is empty
              * @return True if it's empty
@@ -181,6 +189,15 @@ namespace autoplay {
              */
             bool dropRow(const std::string& row);
 
+            /**
+             * Create a matrix with only some of the rows and columns of this matrix. Unlike dropping them one by
+             * one, this builds the new matrix (and its indexes) in a single pass.
+             * @param rows      The rows to keep. Names that are not rows are ignored.
+             * @param columns   The columns to keep. Names that are not columns are ignored.
+             * @return The projected matrix.
+             */
+            NamedMatrix project(const std::vector<std::string>& rows, const std::vector<std::string>& columns) const;
+
             /**
              * Fetch all the column headers
              * @return A list of all the columns
@@ -194,11 +211,21 @@ namespace autoplay {
             std::vector<std::string> getRows() const;
 
             /**
-             * Write the matrix to a CSV-file
+             * Write the matrix to a CSV-file. The file is written atomically, and the values are written exactly.
              * @param filename  The filename of the CSV.
              * @param sep       The separator in the file
+             * @param replace   When true, an existing file is replaced.
+             *
+             * @throws std::runtime_error When the file exists and replace is false, or cannot be written.
+             */
+            void toCSV(const std::string& filename, char sep = ',', bool replace = false) const;
+
+            /**
+             * Write the matrix as CSV to a stream.
+             * @param out   The stream to write to.
+             * @param sep   The separator in the file
              */
-            void toCSV(const std::string& filename, char sep = ',') const;
+            void toCSV(std::ostream& out, char sep = ',') const;
 
             /**
              * Generate a NamedMatrix from a CSV file.
@@ -0,0 +1,440 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "ScoreReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace autoplay {
+    namespace markov {
+        namespace {
+            /// The elements of the current Measure and Note that have been seen
+            enum Seen : unsigned int {
+                ATTRIBUTES    = 1u << 0, ///< The first 'attributes' of the Measure has been seen
+                IN_ATTRIBUTES = 1u << 1, ///< The first 'attributes' of the Measure is open
+                DIVISIONS     = 1u << 2, ///< The first 'divisions' of the first 'attributes' has been seen
+                PITCH         = 1u << 3, ///< The first 'pitch' of the Note has been seen
+                IN_PITCH      = 1u << 4, ///< The first 'pitch' of the Note is open
+                STEP          = 1u << 5, ///< The first 'step' has been seen
+                ALTER         = 1u << 6, ///< The first 'alter' has been seen
+                OCTAVE        = 1u << 7, ///< The first 'octave' has been seen
+                DURATION      = 1u << 8, ///< The first 'duration' has been seen
+                MEASURE_BITS  = ATTRIBUTES | IN_ATTRIBUTES | DIVISIONS ///< The bits that belong to the Measure
+            };
+
+            inline bool is_space(int c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+            /**
+             * Parse an integer the way a property tree does: surrounding whitespace is allowed, anything else is not.
+             * @param text  The text to parse.
+             * @param value The value, only set on success.
+             * @return True if the text is an integer.
+             */
+            bool parse_int(const std::string& text, int& value) {
+                std::size_t i = 0;
+                while(i < text.size() && is_space(text[i])) {
+                    ++i;
+                }
+                bool negative = false;
+                if(i < text.size() && (text[i] == '-' || text[i] == '+')) {
+                    negative = text[i] == '-';
+                    ++i;
+                }
+                std::size_t digits = i;
+                long        res    = 0;
+                while(i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                    res = res * 10 + (text[i] - '0');
+                    if(res > std::numeric_limits<int>::max()) {
+                        return false;
+                    }
+                    ++i;
+                }
+                if(i == digits) {
+                    return false;
+                }
+                while(i < text.size() && is_space(text[i])) {
+                    ++i;
+                }
+                if(i != text.size()) {
+                    return false;
+                }
+                value = (int)(negative ? -res : res);
+                return true;
+            }
+        }
+
+        ScoreReader::ScoreReader(const std::string& filename, std::size_t buffer)
+            : m_filename(filename), m_file(filename, std::ios::binary), m_buffer(std::max<std::size_t>(buffer, 16)),
+              m_pos(0), m_end(0), m_line(1), m_stack(), m_depth(0), m_name(), m_text(), m_root(false), m_parts(0),
+              m_note(), m_capture(nullptr), m_capture_at(0), m_duration(), m_alter(), m_divisions(), m_seen(0),
+              m_chords(0) {}
+
+        bool ScoreReader::isScore() {
+            if(!m_file.is_open()) {
+                error("cannot open file");
+            }
+            while(!m_root) {
+                switch(read()) {
+                case Token::START:
+                    m_root = true;
+                    m_stack.emplace_back(m_name);
+                    m_depth = 1;
+                    break;
+                case Token::EMPTY: m_root = true; break;
+                case Token::END: error("unexpected end tag </" + m_name + ">");
+                case Token::TEXT: break;
+                case Token::DONE: error("no root element");
+                }
+            }
+            return m_name == "score-partwise";
+        }
+
+        bool ScoreReader::next(Measure& measure) {
+            while(true) {
+                switch(read()) {
+                case Token::START: start(measure); break;
+                case Token::EMPTY:
+                    start(measure);
+                    if(end(measure)) {
+                        return true;
+                    }
+                    break;
+                case Token::END:
+                    if(m_depth == 0 || m_stack[m_depth - 1] != m_name) {
+                        error("unexpected end tag </" + m_name + ">");
+                    }
+                    if(end(measure)) {
+                        return true;
+                    }
+                    break;
+                case Token::TEXT:
+                    if(m_capture && m_depth == m_capture_at) {
+                        m_capture->append(m_text);
+                    }
+                    break;
+                case Token::DONE:
+                    if(m_depth != 0) {
+                        error("unexpected end of file, expected </" + m_stack[m_depth - 1] + ">");
+                    }
+                    return false;
+                }
+            }
+        }
+
+        void ScoreReader::start(Measure& measure) {
+            if(m_depth == m_stack.size()) {
+                m_stack.emplace_back();
+            }
+            m_stack[m_depth++] = m_name;
+
+            auto capture = [this](std::string& target, unsigned int bit) {
+                if((m_seen & bit) == 0) {
+                    m_seen |= bit;
+                    target.clear();
+                    m_capture    = &target;
+                    m_capture_at = m_depth;
+                }
+            };
+
+            if(m_depth < 2 || m_stack[0] != "score-partwise" || m_stack[1] != "part") {
+                return;
+            }
+            switch(m_depth) {
+            case 2: ++m_parts; break;
+            case 3:
+                if(m_name == "measure") {
+                    measure.part      = m_parts - 1;
+                    measure.divisions = 0;
+                    measure.notes.clear();
+                    m_seen = 0;
+                }
+                break;
+            case 4:
+                if(m_stack[2] != "measure") {
+                    break;
+                }
+                if(m_name == "note") {
+                    m_note.step.clear();
+                    m_note.octave.clear();
+                    m_note.alter     = 0;
+                    m_note.duration  = 0;
+                    m_note.rest      = false;
+                    m_note.unpitched = false;
+                    m_note.chord     = false;
+                    m_chords         = 0;
+                    m_seen &= MEASURE_BITS;
+                } else if(m_name == "attributes" && (m_seen & ATTRIBUTES) == 0) {
+                    m_seen |= ATTRIBUTES | IN_ATTRIBUTES;
+                }
+                break;
+            case 5:
+                if(m_stack[2] != "measure") {
+                    break;
+                }
+                if(m_stack[3] == "note") {
+                    if(m_name == "rest") {
+                        m_note.rest = true;
+                    } else if(m_name == "unpitched") {
+                        m_note.unpitched = true;
+                    } else if(m_name == "chord") {
+                        ++m_chords;
+                    } else if(m_name == "duration") {
+                        capture(m_duration, DURATION);
+                    } else if(m_name == "pitch" && (m_seen & PITCH) == 0) {
+                        m_seen |= PITCH | IN_PITCH;
+                    }
+                } else if(m_stack[3] == "attributes" && (m_seen & IN_ATTRIBUTES) != 0 && m_name == "divisions") {
+                    capture(m_divisions, DIVISIONS);
+                }
+                break;
+            case 6:
+                if(m_stack[2] != "measure" || m_stack[3] != "note" || (m_seen & IN_PITCH) == 0) {
+                    break;
+                }
+                if(m_name == "step") {
+                    capture(m_note.step, STEP);
+                } else if(m_name == "alter") {
+                    capture(m_alter, ALTER);
+                } else if(m_name == "octave") {
+                    capture(m_note.octave, OCTAVE);
+                }
+                break;
+            default: break;
+            }
+        }
+
+        bool ScoreReader::end(Measure& measure) {
+            auto depth = m_depth--;
+            if(m_capture && depth == m_capture_at) {
+                m_capture = nullptr;
+            }
+            if(depth < 3 || depth > 5 || m_stack[0] != "score-partwise" || m_stack[1] != "part" ||
+               (depth > 3 && m_stack[2] != "measure")) {
+                return false;
+            }
+            const auto& name = m_stack[depth - 1];
+            if(depth == 3) {
+                if(name != "measure") {
+                    return false;
+                }
+                int divisions = 0;
+                if((m_seen & DIVISIONS) != 0 && parse_int(m_divisions, divisions) && divisions > 0) {
+                    measure.divisions = divisions;
+                }
+                return true;
+            }
+            if(depth == 5) {
+                if(m_stack[3] == "note" && name == "pitch") {
+                    m_seen &= ~IN_PITCH;
+                }
+                return false;
+            }
+            if(name == "attributes") {
+                m_seen &= ~IN_ATTRIBUTES;
+            } else if(name == "note") {
+                if((m_seen & DURATION) == 0 || !parse_int(m_duration, m_note.duration)) {
+                    throw std::runtime_error(m_filename + ":" + std::to_string(m_line) +
+                                             ": a note has no valid duration");
+                }
+                if(!m_note.rest && !m_note.unpitched && (m_seen & OCTAVE) == 0) {
+                    throw std::runtime_error(m_filename + ":" + std::to_string(m_line) +
+                                             ": a pitched note has no octave");
+                }
+                if((m_seen & ALTER) == 0 || !parse_int(m_alter, m_note.alter)) {
+                    m_note.alter = 0;
+                }
+                m_note.chord = m_chords == 1;
+                measure.notes.emplace_back(m_note);
+            }
+            return false;
+        }
+
+        ScoreReader::Token ScoreReader::read() {
+            m_text.clear();
+            while(true) {
+                int c = peek();
+                if(c == EOF) {
+                    return Token::DONE;
+                }
+                if(c != '<') {
+                    while((c = peek()) != EOF && c != '<') {
+                        get();
+                        if(c == '&') {
+                            entity();
+                        } else {
+                            m_text.push_back((char)c);
+                        }
+                    }
+                    return Token::TEXT;
+                }
+                get();
+                c = peek();
+                if(c == '?') {
+                    skip("?>");
+                    continue;
+                }
+                if(c == '!') {
+                    get();
+                    if(peek() == '-') {
+                        expect("--");
+                        skip("-->");
+                        continue;
+                    }
+                    if(peek() == '[') {
+                        expect("[CDATA[");
+                        skip("]]>", &m_text);
+                        m_text.resize(m_text.size() - 3);
+                        return Token::TEXT;
+                    }
+                    // A declaration, e.g. a DOCTYPE with an internal subset
+                    int brackets = 0;
+                    while((c = get()) != '>' || brackets > 0) {
+                        if(c == EOF) {
+                            error("unterminated declaration");
+                        } else if(c == '[') {
+                            ++brackets;
+                        } else if(c == ']') {
+                            --brackets;
+                        }
+                    }
+                    continue;
+                }
+
+                bool closing = c == '/';
+                if(closing) {
+                    get();
+                }
+                m_name.clear();
+                while((c = peek()) != EOF && !is_space(c) && c != '/' && c != '>') {
+                    m_name.push_back((char)get());
+                }
+                if(m_name.empty()) {
+                    error("expected an element name");
+                }
+                if(closing) {
+                    while(is_space(c = get())) {}
+                    if(c != '>') {
+                        error("expected '>' after </" + m_name);
+                    }
+                    return Token::END;
+                }
+                while(true) {
+                    c = get();
+                    if(c == '>') {
+                        return Token::START;
+                    } else if(c == '/') {
+                        if(get() != '>') {
+                            error("expected '>' after '/' in <" + m_name + ">");
+                        }
+                        return Token::EMPTY;
+                    } else if(c == '"' || c == '\'') {
+                        int quote = c;
+                        while((c = get()) != EOF && c != quote) {}
+                    }
+                    if(c == EOF) {
+                        error("unterminated tag <" + m_name + ">");
+                    }
+                }
+            }
+        }
+
+        bool ScoreReader::fill() {
+            if(!m_file) {
+                return false;
+            }
+            m_file.read(m_buffer.data(), (std::streamsize)m_buffer.size());
+            m_pos = 0;
+            m_end = (std::size_t)m_file.gcount();
+            return m_end > 0;
+        }
+
+        void ScoreReader::skip(const char* terminator, std::string* keep) {
+            std::size_t len = std::strlen(terminator);
+            std::string tail;
+            while(tail.size() < len || tail.compare(tail.size() - len, len, terminator) != 0) {
+                int c = get();
+                if(c == EOF) {
+                    error(std::string("expected '") + terminator + "'");
+                }
+                if(keep) {
+                    keep->push_back((char)c);
+                }
+                if(tail.size() == len) {
+                    tail.erase(0, 1);
+                }
+                tail.push_back((char)c);
+            }
+        }
+
+        void ScoreReader::expect(const char* literal) {
+            for(const char* l = literal; *l != '\0'; ++l) {
+                if(get() != (unsigned char)*l) {
+                    error(std::string("expected '") + literal + "'");
+                }
+            }
+        }
+
+        void ScoreReader::entity() {
+            std::string name;
+            int         c;
+            while((c = peek()) != EOF && c != ';' && c != '<' && name.size() < 16) {
+                name.push_back((char)get());
+            }
+            if(c != ';') {
+                m_text += "&" + name;
+                return;
+            }
+            get();
+            if(name == "lt") {
+                m_text.push_back('<');
+            } else if(name == "gt") {
+                m_text.push_back('>');
+            } else if(name == "amp") {
+                m_text.push_back('&');
+            } else if(name == "quot") {
+                m_text.push_back('"');
+            } else if(name == "apos") {
+                m_text.push_back('\'');
+            } else if(name.size() > 1 && name[0] == '#') {
+                unsigned long code = std::strtoul(name.c_str() + (name[1] == 'x' ? 2 : 1), nullptr,
+                                                  name[1] == 'x' ? 16 : 10);
+                // Encode the code point as UTF-8
+                if(code < 0x80) {
+                    m_text.push_back((char)code);
+                } else if(code < 0x800) {
+                    m_text.push_back((char)(0xC0 | (code >> 6)));
+                    m_text.push_back((char)(0x80 | (code & 0x3F)));
+                } else if(code < 0x10000) {
+                    m_text.push_back((char)(0xE0 | (code >> 12)));
+                    m_text.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+                    m_text.push_back((char)(0x80 | (code & 0x3F)));
+                } else {
+                    m_text.push_back((char)(0xF0 | (code >> 18)));
+                    m_text.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+                    m_text.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+                    m_text.push_back((char)(0x80 | (code & 0x3F)));
+                }
+            } else {
+                m_text += "&" + name + ";";
+            }
+        }
+
+        void ScoreReader::error(const std::string& message) const { throw ParseError(message, m_filename, m_line); }
+    }
+}
@@ -0,0 +1,229 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_SCOREREADER_H
+#define AUTOPLAY_SCOREREADER_H
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The ScoreReader class reads a (partwise) MusicXML file one Measure at a time, without building a document
+         * tree. It only keeps the parts of the Notes that the Markov training looks at, so the memory it uses does
+         * not depend on the size of the file.
+         *
+         * The elements are looked up like a property tree would: only the first 'attributes' of a Measure, the
+         * first 'divisions' in it, and the first 'pitch', 'step', 'alter', 'octave' and 'duration' of a Note are
+         * used. The whitespace around the texts is kept.
+         */
+        class ScoreReader
+        {
+        public:
+            /**
+             * The ParseError is thrown when the file could not be opened, or is not well-formed XML.
+             */
+            class ParseError : public std::runtime_error
+            {
+            public:
+                /**
+                 * Constructor
+                 * @param message   The description of the error.
+                 * @param filename  The name of the file.
+                 * @param line      The line on which the error occurred.
+                 */
+                ParseError(const std::string& message, std::string filename, unsigned long line)
+                    : std::runtime_error(message), m_filename(std::move(filename)), m_line(line) {}
+
+                /**
+                 * Get the name of the file in which the error occurred.
+                 * @return The filename.
+                 */
+                inline const std::string& filename() const { return m_filename; }
+
+                /**
+                 * Get the line on which the error occurred.
+                 * @return The line, starting from 1.
+                 */
+                inline unsigned long line() const { return m_line; }
+
+            private:
+                std::string   m_filename; ///< The name of the file
+                unsigned long m_line;     ///< The line of the error
+            };
+
+            /**
+             * A Note, as far as the Markov training needs it.
+             */
+            struct Note {
+                std::string step;      ///< The text of 'pitch/step'
+                int         alter;     ///< The value of 'pitch/alter', or 0 if there is none (or it is no integer)
+                std::string octave;    ///< The text of 'pitch/octave'
+                int         duration;  ///< The value of 'duration'
+                bool        rest;      ///< True if the Note has a 'rest'
+                bool        unpitched; ///< True if the Note has an 'unpitched'
+                bool        chord;     ///< True if the Note has exactly one 'chord'
+            };
+
+            /**
+             * A Measure, as far as the Markov training needs it.
+             */
+            struct Measure {
+                unsigned int      part;      ///< The index of the Part of the Measure, starting from 0
+                int               divisions; ///< The divisions set in the Measure, or 0 if it does not set any
+                std::vector<Note> notes;     ///< The Notes of the Measure, in order
+            };
+
+            /**
+             * Constructor
+             * @param filename  The file to read.
+             * @param buffer    The size of the read buffer, in bytes.
+             */
+            explicit ScoreReader(const std::string& filename, std::size_t buffer = 1 << 16);
+
+            /**
+             * Read up to the root element and check that it is a 'score-partwise'.
+             * @return True if it is.
+             *
+             * @throws ScoreReader::ParseError When the file could not be opened, or has no root element.
+             */
+            bool isScore();
+
+            /**
+             * Read the next Measure of the Score. Must only be called after isScore() returned true.
+             * @param measure   The Measure to fill in. Its Notes are reused.
+             * @return True if a Measure has been read, false at the end of the file.
+             *
+             * @throws ScoreReader::ParseError When the file is not well-formed.
+             * @throws std::runtime_error When a Note has no valid 'duration', or a pitched Note has no 'octave'.
+             */
+            bool next(Measure& measure);
+
+        private:
+            /// The kinds of markup that can be read
+            enum class Token { START, EMPTY, END, TEXT, DONE };
+
+            /**
+             * Read the next tag or text.
+             * @return The kind of markup that was read. For START, EMPTY and END, the name is stored in m_name. For
+             *         TEXT, the decoded text is stored in m_text.
+             */
+            Token read();
+
+            /**
+             * Push the element named m_name on the stack and handle its start.
+             * @param measure   The Measure that is being read.
+             */
+            void start(Measure& measure);
+
+            /**
+             * Handle the end of the element on top of the stack, and pop it.
+             * @param measure   The Measure that is being read.
+             * @return True if a Measure ends.
+             */
+            bool end(Measure& measure);
+
+            /**
+             * Get the next character and move past it.
+             * @return The character, or EOF at the end of the file.
+             */
+            inline int get() {
+                if(m_pos == m_end && !fill()) {
+                    return EOF;
+                }
+                char c = m_buffer[m_pos++];
+                if(c == '\n') {
+                    ++m_line;
+                }
+                return (unsigned char)c;
+            }
+
+            /**
+             * Get the next character without moving past it.
+             * @return The character, or EOF at the end of the file.
+             */
+            inline int peek() {
+                if(m_pos == m_end && !fill()) {
+                    return EOF;
+                }
+                return (unsigned char)m_buffer[m_pos];
+            }
+
+            /**
+             * Read the next block of the file into the buffer.
+             * @return False at the end of the file.
+             */
+            bool fill();
+
+            /**
+             * Skip everything up to and including a terminator.
+             * @param terminator    The string that ends the skipped markup.
+             * @param keep          When not null, the skipped characters are appended to it.
+             */
+            void skip(const char* terminator, std::string* keep = nullptr);
+
+            /**
+             * Read a literal string.
+             * @param literal   The characters that must follow.
+             *
+             * @throws ScoreReader::ParseError When other characters follow.
+             */
+            void expect(const char* literal);
+
+            /**
+             * Decode an entity reference (after the '&') and append it to the text.
+             */
+            void entity();
+
+            /**
+             * Throw a ParseError on the current line.
+             * @param message   The description of the error.
+             */
+            [[noreturn]] void error(const std::string& message) const;
+
+        private:
+            std::string       m_filename; ///< The name of the file
+            std::ifstream     m_file;     ///< The file
+            std::vector<char> m_buffer;   ///< The read buffer
+            std::size_t       m_pos;      ///< The position of the next character in the buffer
+            std::size_t       m_end;      ///< The amount of characters in the buffer
+            unsigned long     m_line;     ///< The current line
+
+            std::vector<std::string> m_stack; ///< The names of the open elements (only the first m_depth are used)
+            std::size_t              m_depth; ///< The amount of open elements
+            std::string              m_name;  ///< The name of the last tag
+            std::string              m_text;  ///< The last text
+
+            bool         m_root;       ///< True if the root element has been read
+            unsigned int m_parts;      ///< The amount of Parts that have been started
+            Note         m_note;       ///< The Note that is being read
+            std::string* m_capture;    ///< The string that receives the text of the current element, if any
+            std::size_t  m_capture_at; ///< The depth of the element whose text is captured
+            std::string  m_duration;   ///< The text of 'duration' of the current Note
+            std::string  m_alter;      ///< The text of 'pitch/alter' of the current Note
+            std::string  m_divisions;  ///< The text of 'attributes/divisions' of the current Measure
+            unsigned int m_seen;       ///< The elements of the current Note or Measure that have already been seen
+            unsigned int m_chords;     ///< The amount of 'chord' elements in the current Note
+        };
+    }
+}
+
+#endif // AUTOPLAY_SCOREREADER_H
@@ -18,7 +18,7 @@
 #ifndef AUTOPLAY_SPECIALQUEUE_H
 #define AUTOPLAY_SPECIALQUEUE_H
 
-#include <queue>
+#include <deque>
 #include <vector>
 
 namespace autoplay {
@@ -34,7 +34,7 @@ namespace autoplay {
         {
         public:
             using queue_element_type = std::vector<T>;                 ///< The queue element type
-            using queue_type         = std::queue<queue_element_type>; ///< The type of the queue (internally)
+            using queue_type         = std::deque<queue_element_type>; ///< The type of the queue (internally)
 
             /**
              * Enqueue an element on to the queue, or add it to the lastly added container.
@@ -47,14 +47,14 @@ namespace autoplay {
                 if(to_top && !m_queue.empty()) {
                     m_queue.back().emplace_back(element);
                 } else {
-                    m_queue.push({element});
+                    m_queue.push_back({element});
                 }
             }
 
             /**
              * Dequeue an element from the queue.
              */
-            void dequeue() { m_queue.pop(); }
+            void dequeue() { m_queue.pop_front(); }
 
             /**
              * Get the front of the queue.
@@ -62,6 +62,19 @@ namespace autoplay {
              */
             queue_element_type& front() { return m_queue.front(); }
 
+            /**
+             * Get an element of the queue.
+             * @param idx   The index of the element, where 0 is the front.
+             * @return The element.
+             */
+            const queue_element_type& at(std::size_t idx) const { return m_queue.at(idx); }
+
+            /**
+             * Get the amount of elements in the queue.
+             * @return The size of the queue.
+             */
+            std::size_t size() const { return m_queue.size(); }
+
         private:
             queue_type m_queue; ///< The queue that's used internally
         };
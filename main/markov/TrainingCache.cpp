@@ -0,0 +1,162 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+#include "TrainingCache.h"
+#include "../util/FileHandler.h"
+#include "MidiReader.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace autoplay {
+    namespace markov {
+        namespace {
+            constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+            /**
+             * Continue a 64-bit FNV-1a hash over a block of bytes.
+             * @param h     The hash so far.
+             * @param data  The bytes.
+             * @param size  The amount of bytes.
+             * @return The new hash.
+             */
+            uint64_t fnv(uint64_t h, const char* data, std::size_t size) {
+                for(std::size_t i = 0; i < size; ++i) {
+                    h ^= (unsigned char)data[i];
+                    h *= FNV_PRIME;
+                }
+                return h;
+            }
+        }
+
+        constexpr uint32_t TrainingCache::VERSION;
+
+        TrainingCache::TrainingCache(std::string directory) : m_directory(std::move(directory)) {
+            boost::system::error_code ec;
+            boost::filesystem::create_directories(m_directory, ec);
+            if(!boost::filesystem::is_directory(m_directory)) {
+                throw std::runtime_error("Unable to create the cache directory '" + m_directory + "'");
+            }
+        }
+
+        uint64_t TrainingCache::hash(const std::string& filename) { return util::FileHandler::hash(filename); }
+
+        std::string TrainingCache::key(const std::string& filename, unsigned int order) {
+            std::ostringstream salt;
+            salt << '\0' << order << ' ' << VERSION << ' ' << MidiReader::isMidi(filename);
+            auto s = salt.str();
+
+            std::ostringstream out;
+            out << std::hex << std::setw(16) << std::setfill('0') << fnv(hash(filename), s.data(), s.size());
+            return out.str();
+        }
+
+        bool TrainingCache::load(const std::string& key, std::vector<NamedMatrix>& counts) const {
+            auto          filename = path(key);
+            std::ifstream file(filename);
+            if(!file.is_open()) {
+                return false;
+            }
+
+            auto invalid = [&filename](const std::string& why) {
+                std::cerr << "WARNING: the cache entry '" << filename << "' is ignored: " << why << "." << std::endl;
+                return false;
+            };
+
+            std::string line;
+            if(!std::getline(file, line) || line != "autoplay-counts 1") {
+                return invalid("unknown header");
+            }
+
+            std::vector<NamedMatrix> res;
+            while(std::getline(file, line)) {
+                std::istringstream       in(line);
+                std::string              tag;
+                std::size_t              rows = 0, columns = 0, entries = 0;
+                std::vector<std::string> rownames, colnames;
+                if(!(in >> tag >> rows >> columns >> entries) || tag != "matrix") {
+                    return invalid("invalid line '" + line + "'");
+                }
+                for(std::size_t i = 0; i < rows + columns; ++i) {
+                    if(!std::getline(file, line)) {
+                        return invalid("missing names");
+                    }
+                    (i < rows ? rownames : colnames).emplace_back(line);
+                }
+                NamedMatrix matrix{rownames, colnames};
+                for(std::size_t e = 0; e < entries; ++e) {
+                    std::size_t r = 0, c = 0;
+                    double      value = 0;
+                    if(!std::getline(file, line) || !(std::istringstream(line) >> r >> c >> value) || r >= rows ||
+                       c >= columns) {
+                        return invalid("invalid count");
+                    }
+                    matrix.at(rownames.at(r), colnames.at(c)) = value;
+                }
+                res.emplace_back(std::move(matrix));
+            }
+            if(res.size() != 3) {
+                return invalid("expected 3 matrices instead of " + std::to_string(res.size()));
+            }
+            counts = std::move(res);
+            return true;
+        }
+
+        void TrainingCache::store(const std::string& key, const std::vector<NamedMatrix>& counts) const {
+            util::FileHandler::writeAtomic(path(key), [&counts](std::ostream& out) {
+                out << std::setprecision(std::numeric_limits<double>::max_digits10);
+                out << "autoplay-counts 1\n";
+                for(const auto& matrix : counts) {
+                    auto rows    = matrix.getRows();
+                    auto columns = matrix.getColumns();
+
+                    // The counts of a single file are sparse: only the ones that are not 0 are written
+                    std::ostringstream entries;
+                    entries << std::setprecision(std::numeric_limits<double>::max_digits10);
+                    std::size_t amount = 0;
+                    for(std::size_t r = 0; r < rows.size(); ++r) {
+                        std::size_t c = 0;
+                        for(const auto& col : matrix.get(rows.at(r))) {
+                            if(col.second != 0.0) {
+                                entries << r << " " << c << " " << col.second << "\n";
+                                ++amount;
+                            }
+                            ++c;
+                        }
+                    }
+
+                    out << "matrix " << rows.size() << " " << columns.size() << " " << amount << "\n";
+                    for(const auto& name : rows) {
+                        out << name << "\n";
+                    }
+                    for(const auto& name : columns) {
+                        out << name << "\n";
+                    }
+                    out << entries.str();
+                }
+            });
+        }
+
+        std::string TrainingCache::path(const std::string& key) const {
+            return (boost::filesystem::path(m_directory) / (key + ".counts")).string();
+        }
+    }
+}
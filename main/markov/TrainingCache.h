@@ -0,0 +1,111 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+#ifndef AUTOPLAY_TRAININGCACHE_H
+#define AUTOPLAY_TRAININGCACHE_H
+
+#include "NamedMatrix.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The TrainingCache class remembers the counts of every file that has been used for training, so that a
+         * later training only has to read the files that are new or have been changed. The counts of a file are
+         * found by a key that is made from its content (see key()), so renaming or touching a file does not make
+         * it read again.
+         *
+         * Every entry is stored as a text file '<key>.counts' in the directory of the cache: a line
+         * 'autoplay-counts 1' and, for each of the pitch, rhythm and chord matrices, a line 'matrix rows columns
+         * entries', the names of the rows and columns (one per line) and a line 'row column count' for each count
+         * that is not 0.
+         */
+        class TrainingCache
+        {
+        public:
+            /// The version of the counts. It is part of every key, so changing the way files are counted (or the
+            /// format of an entry) makes all entries stale.
+            static constexpr uint32_t VERSION = 1;
+
+            /**
+             * Constructor
+             * @param directory The directory to keep the entries in. It is created when it does not exist.
+             *
+             * @throws std::runtime_error When the directory cannot be created.
+             */
+            explicit TrainingCache(std::string directory);
+
+            /**
+             * Hash the content of a file with 64-bit FNV-1a.
+             * @param filename  The file to hash.
+             * @return The hash.
+             *
+             * @throws std::runtime_error When the file cannot be read.
+             */
+            static uint64_t hash(const std::string& filename);
+
+            /**
+             * The key of the counts of a file. It depends on the content of the file, the order of the training,
+             * whether the file is read as a Standard MIDI File and the VERSION.
+             * @param filename  The file that is trained on.
+             * @param order     The amount of previous events that decide the next one.
+             * @return The key, as 16 hexadecimal digits.
+             *
+             * @throws std::runtime_error When the file cannot be read.
+             */
+            static std::string key(const std::string& filename, unsigned int order);
+
+            /**
+             * Read the counts of a file.
+             * @param key       The key of the file (see key()).
+             * @param counts    The pitch, rhythm and chord matrices to fill.
+             * @return Whether the entry exists. An entry that cannot be read is reported and treated as missing.
+             */
+            bool load(const std::string& key, std::vector<NamedMatrix>& counts) const;
+
+            /**
+             * Write the counts of a file. The entry is replaced atomically.
+             * @param key       The key of the file (see key()).
+             * @param counts    The pitch, rhythm and chord matrices.
+             *
+             * @throws std::runtime_error When the entry cannot be written.
+             */
+            void store(const std::string& key, const std::vector<NamedMatrix>& counts) const;
+
+            /**
+             * Get the directory of the cache.
+             * @return The directory.
+             */
+            inline const std::string& directory() const { return m_directory; }
+
+        private:
+            /**
+             * Get the file of an entry.
+             * @param key   The key of the entry.
+             * @return The path of the file.
+             */
+            std::string path(const std::string& key) const;
+
+        private:
+            std::string m_directory; ///< The directory of the entries
+        };
+    }
+}
+
+#endif // AUTOPLAY_TRAININGCACHE_H
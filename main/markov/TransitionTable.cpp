@@ -0,0 +1,693 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "TransitionTable.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace bi = boost::interprocess;
+
+namespace autoplay {
+    namespace markov {
+        constexpr TransitionTable::Id   TransitionTable::NONE;
+        constexpr TransitionTable::Row  TransitionTable::NO_ROW;
+        constexpr char                  TransitionTable::SEPARATOR;
+        constexpr char                  TransitionTable::MAGIC[8];
+        constexpr uint32_t              TransitionTable::VERSION;
+
+        /**
+         * The arrays of a TransitionTable. A table that has been created from a matrix owns them; a table that has
+         * been loaded only owns the names of its States, and points into the mapped file for everything else.
+         */
+        struct TransitionTable::Storage {
+            std::vector<std::string> names;           ///< The name of each State
+            std::vector<Id>          sorted;          ///< The ids of all States, sorted by name
+            std::vector<uint64_t>    offsets;         ///< The start of each row in targets
+            std::vector<Id>          targets;         ///< The States each row can go to
+            std::vector<double>      cumulative;      ///< The cumulative chance of each target
+            std::vector<uint64_t>    context_offsets; ///< The start of the context of each row in contexts
+            std::vector<Id>          contexts;        ///< The ids of the contexts of all rows
+            std::vector<Slot>        slots;           ///< The hash table
+            bi::mapped_region        region;          ///< The mapped model file, if any
+        };
+
+        /**
+         * The mask of a view that has been created with TransitionTable::filter. It refers to the ids and rows of
+         * the arrays the view shares with its table.
+         */
+        struct TransitionTable::Mask {
+            /// How a row of the view goes to the next State
+            enum Kind : uint8_t {
+                KEEP,    ///< Like the table; none of its targets are removed
+                SCALE,   ///< Like the table, without the removed targets, divided by the total of the others
+                UNIFORM, ///< To each kept column with the same chance, as none of its targets are kept
+                HIDE     ///< Not at all; its context contains a removed State
+            };
+
+            std::vector<char>   states;  ///< For each State, whether it is kept
+            std::vector<Kind>   rows;    ///< For each row, how it goes to the next State
+            std::vector<double> totals;  ///< For each row, the chance of going to a kept State
+            std::vector<Id>     columns; ///< The ids of the kept columns, in order
+        };
+
+        static_assert(sizeof(TransitionTable::Id) == 4, "The binary model format stores 32-bit ids.");
+
+        namespace {
+            constexpr uint32_t ENDIAN = 0x01020304; ///< The byte order mark of a binary model
+
+            /**
+             * The positions of the sections of a binary model, in bytes from the start of the file.
+             */
+            struct Layout {
+                std::size_t name_offsets;    ///< The offsets of the State names
+                std::size_t names;           ///< The name data
+                std::size_t sorted;          ///< The ids sorted by name
+                std::size_t offsets;         ///< The offsets of the rows
+                std::size_t targets;         ///< The targets
+                std::size_t cumulative;      ///< The cumulative chances
+                std::size_t context_offsets; ///< The offsets of the contexts
+                std::size_t contexts;        ///< The contexts
+                std::size_t slots;           ///< The hash table
+                std::size_t size;            ///< The size of the file
+            };
+
+            /**
+             * Compute the positions of the sections of a binary model.
+             * @param header    The size of the header.
+             * @param states    The amount of States.
+             * @param names     The total length of the State names.
+             * @param rows      The amount of rows.
+             * @param trans     The amount of transitions.
+             * @param contexts  The total length of the contexts.
+             * @param slots     The size of the hash table.
+             * @param slot      The size of a slot.
+             * @return The layout of the file.
+             */
+            Layout layout(std::size_t header, uint64_t states, uint64_t names, uint64_t rows, uint64_t trans,
+                          uint64_t contexts, uint64_t slots, std::size_t slot) {
+                std::size_t pos     = header;
+                auto        section = [&pos](uint64_t count, std::size_t size) {
+                    auto start = pos;
+                    pos += (std::size_t)count * size;
+                    pos = (pos + 7) & ~(std::size_t)7;
+                    return start;
+                };
+                Layout l{};
+                l.name_offsets    = section(states + 1, sizeof(uint64_t));
+                l.names           = section(names, sizeof(char));
+                l.sorted          = section(states, sizeof(uint32_t));
+                l.offsets         = section(rows + 1, sizeof(uint64_t));
+                l.targets         = section(trans, sizeof(uint32_t));
+                l.cumulative      = section(trans, sizeof(double));
+                l.context_offsets = section(rows + 1, sizeof(uint64_t));
+                l.contexts        = section(contexts, sizeof(uint32_t));
+                l.slots           = section(slots, slot);
+                l.size            = pos;
+                return l;
+            }
+        }
+
+        TransitionTable::TransitionTable()
+            : m_storage(), m_mask(), m_states(0), m_columns(0), m_order(0), m_rows(0), m_size(0), m_names(nullptr),
+              m_sorted(nullptr), m_offsets(nullptr), m_targets(nullptr), m_cumulative(nullptr),
+              m_context_offsets(nullptr), m_contexts(nullptr), m_slots(nullptr) {
+            auto storage = std::make_shared<Storage>();
+            storage->offsets.assign(1, 0);
+            storage->context_offsets.assign(1, 0);
+            m_storage = storage;
+            view();
+        }
+
+        TransitionTable::TransitionTable(const NamedMatrix& matrix) : TransitionTable() {
+            auto storage = std::make_shared<Storage>();
+            storage->offsets.assign(1, 0);
+            storage->context_offsets.assign(1, 0);
+            auto& names = storage->names;
+
+            // The columns get the lowest ids, so the targets of each row are sorted by name
+            std::map<std::string, Id> ids;
+            auto                      columns = matrix.getColumns();
+            for(const auto& name : columns) {
+                ids.emplace(name, (Id)names.size());
+                names.emplace_back(name);
+            }
+
+            auto rows = matrix.getRows();
+            for(const auto& name : rows) {
+                auto states = context(name);
+                for(const auto& state : states) {
+                    if(ids.emplace(state, (Id)names.size()).second) {
+                        names.emplace_back(state);
+                    }
+                    storage->contexts.emplace_back(ids.at(state));
+                }
+                storage->context_offsets.emplace_back(storage->contexts.size());
+                m_order = std::max(m_order, states.size());
+
+                auto&  targets    = storage->targets;
+                auto&  cumulative = storage->cumulative;
+                double sum        = 0.0;
+                auto   begin      = targets.size();
+                for(Id c = 0; c < (Id)columns.size(); ++c) {
+                    double w = matrix.at(name, columns[c]);
+                    if(w > 0.0) {
+                        sum += w;
+                        targets.emplace_back(c);
+                        cumulative.emplace_back(sum);
+                    }
+                }
+                if(targets.size() == begin) {
+                    for(Id c = 0; c < (Id)columns.size(); ++c) {
+                        sum += 1.0;
+                        targets.emplace_back(c);
+                        cumulative.emplace_back(sum);
+                    }
+                }
+                for(auto i = begin; i < targets.size(); ++i) {
+                    cumulative[i] /= sum;
+                }
+                if(targets.size() > begin) {
+                    cumulative.back() = 1.0;
+                }
+                storage->offsets.emplace_back(targets.size());
+            }
+            for(const auto& kv : ids) {
+                storage->sorted.emplace_back(kv.second);
+            }
+
+            // Keep the hash table at most half full, so the probe sequences stay short
+            std::size_t capacity = 2;
+            while(capacity < 2 * rows.size()) {
+                capacity *= 2;
+            }
+            storage->slots.assign(capacity, {0, NO_ROW, 0});
+            for(Row r = 0; r < (Row)rows.size(); ++r) {
+                const Id* context = storage->contexts.data() + storage->context_offsets[r];
+                auto      length  = (std::size_t)(storage->context_offsets[r + 1] - storage->context_offsets[r]);
+                auto      h       = hash(context, length);
+                for(auto s = h & (capacity - 1);; s = (s + 1) & (capacity - 1)) {
+                    if(storage->slots[s].row == NO_ROW) {
+                        storage->slots[s] = {h, r, 0};
+                        break;
+                    }
+                }
+            }
+
+            m_storage = storage;
+            m_columns = columns.size();
+            view();
+        }
+
+        TransitionTable TransitionTable::load(const std::string& filename) {
+            auto storage = std::make_shared<Storage>();
+            try {
+                bi::file_mapping  mapping(filename.c_str(), bi::read_only);
+                bi::mapped_region region(mapping, bi::read_only);
+                storage->region.swap(region);
+            } catch(const bi::interprocess_exception& e) {
+                throw std::runtime_error("Could not map the model '" + filename + "': " + e.what());
+            }
+
+            const auto* data = static_cast<const char*>(storage->region.get_address());
+            auto        size = storage->region.get_size();
+            auto        fail = [&filename](const std::string& reason) {
+                throw std::runtime_error("Invalid model '" + filename + "': " + reason + ".");
+            };
+
+            Header header{};
+            if(size < sizeof(Header)) {
+                fail("the file is too small");
+            }
+            std::memcpy(&header, data, sizeof(Header));
+            if(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+                fail("it is no binary Markov model");
+            }
+            if(header.version != VERSION) {
+                fail("version " + std::to_string(header.version) + " is not supported");
+            }
+            if(header.endian != ENDIAN) {
+                fail("it has been saved with another byte order");
+            }
+            if(header.columns > header.states || header.states >= NONE || header.rows >= NO_ROW ||
+               (header.slots & (header.slots - 1)) != 0 || header.slots < std::max<uint64_t>(2 * header.rows, 2)) {
+                fail("the header is inconsistent");
+            }
+            auto l = layout(sizeof(Header), header.states, header.names, header.rows, header.transitions,
+                            header.contexts, header.slots, sizeof(Slot));
+            if(l.size != size) {
+                fail("the size of the file does not match its header");
+            }
+
+            TransitionTable table;
+            table.m_states          = (std::size_t)header.states;
+            table.m_columns         = (std::size_t)header.columns;
+            table.m_order           = (std::size_t)header.order;
+            table.m_rows            = (std::size_t)header.rows;
+            table.m_size            = (std::size_t)header.slots;
+            table.m_sorted          = reinterpret_cast<const Id*>(data + l.sorted);
+            table.m_offsets         = reinterpret_cast<const uint64_t*>(data + l.offsets);
+            table.m_targets         = reinterpret_cast<const Id*>(data + l.targets);
+            table.m_cumulative      = reinterpret_cast<const double*>(data + l.cumulative);
+            table.m_context_offsets = reinterpret_cast<const uint64_t*>(data + l.context_offsets);
+            table.m_contexts        = reinterpret_cast<const Id*>(data + l.contexts);
+            table.m_slots           = reinterpret_cast<const Slot*>(data + l.slots);
+            if(table.m_offsets[0] != 0 || table.m_offsets[table.m_rows] != header.transitions ||
+               table.m_context_offsets[0] != 0 || table.m_context_offsets[table.m_rows] != header.contexts) {
+                fail("the offsets do not match the header");
+            }
+
+            // The arrays are used in place, so every index in them is checked once here
+            for(std::size_t r = 0; r < table.m_rows; ++r) {
+                if(table.m_offsets[r] > table.m_offsets[r + 1] ||
+                   table.m_context_offsets[r] > table.m_context_offsets[r + 1]) {
+                    fail("the offsets are not increasing");
+                }
+            }
+            for(uint64_t i = 0; i < header.transitions; ++i) {
+                if(table.m_targets[i] >= table.m_columns) {
+                    fail("a transition goes to an unknown State");
+                }
+            }
+            for(uint64_t i = 0; i < header.contexts; ++i) {
+                if(table.m_contexts[i] >= table.m_states) {
+                    fail("a context contains an unknown State");
+                }
+            }
+            for(std::size_t i = 0; i < table.m_states; ++i) {
+                if(table.m_sorted[i] >= table.m_states) {
+                    fail("the sorted States contain an unknown State");
+                }
+            }
+            // A probe only stops at an empty slot, so there must be one
+            std::size_t used = 0;
+            for(std::size_t s = 0; s < table.m_size; ++s) {
+                auto row = table.m_slots[s].row;
+                if(row != NO_ROW && (row >= table.m_rows || ++used > table.m_rows)) {
+                    fail("the hash table is inconsistent");
+                }
+            }
+
+            // The names are the only part that is copied
+            const auto* name_offsets = reinterpret_cast<const uint64_t*>(data + l.name_offsets);
+            const auto* names        = data + l.names;
+            storage->names.reserve(table.m_states);
+            for(std::size_t i = 0; i < table.m_states; ++i) {
+                if(name_offsets[i] > name_offsets[i + 1] || name_offsets[i + 1] > header.names) {
+                    fail("the names do not match the header");
+                }
+                storage->names.emplace_back(names + name_offsets[i], names + name_offsets[i + 1]);
+            }
+            table.m_names   = storage->names.data();
+            table.m_storage = storage;
+            return table;
+        }
+
+        bool TransitionTable::isModel(const std::string& filename) {
+            std::ifstream file{filename, std::ios::binary};
+            char          magic[sizeof(MAGIC)];
+            return file.read(magic, sizeof(MAGIC)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+        }
+
+        void TransitionTable::save(const std::string& filename) const {
+            static_assert(sizeof(Header) == 80 && sizeof(Slot) == 16, "The binary model format has a fixed layout.");
+            if(m_mask) {
+                TransitionTable{matrix()}.save(filename);
+                return;
+            }
+
+            std::ofstream file{filename, std::ios::binary};
+            if(!file) {
+                throw std::runtime_error("Could not open '" + filename + "' for writing.");
+            }
+
+            std::vector<uint64_t> name_offsets{0};
+            std::string           names;
+            for(std::size_t i = 0; i < m_states; ++i) {
+                names += m_names[i];
+                name_offsets.emplace_back(names.size());
+            }
+
+            Header header{};
+            std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version     = VERSION;
+            header.endian      = ENDIAN;
+            header.states      = m_states;
+            header.columns     = m_columns;
+            header.order       = m_order;
+            header.rows        = m_rows;
+            header.transitions = m_offsets[m_rows];
+            header.contexts    = m_context_offsets[m_rows];
+            header.slots       = m_size;
+            header.names       = names.size();
+            auto l = layout(sizeof(Header), header.states, header.names, header.rows, header.transitions,
+                            header.contexts, header.slots, sizeof(Slot));
+
+            // Write a section and pad it up to the start of the next one
+            std::size_t pos     = 0;
+            auto        section = [&file, &pos](std::size_t start, const void* data, std::size_t bytes) {
+                static const char zeros[8] = {};
+                file.write(zeros, (std::streamsize)(start - pos));
+                file.write(static_cast<const char*>(data), (std::streamsize)bytes);
+                pos = start + bytes;
+            };
+            section(0, &header, sizeof(Header));
+            section(l.name_offsets, name_offsets.data(), name_offsets.size() * sizeof(uint64_t));
+            section(l.names, names.data(), names.size());
+            section(l.sorted, m_sorted, m_states * sizeof(Id));
+            section(l.offsets, m_offsets, (m_rows + 1) * sizeof(uint64_t));
+            section(l.targets, m_targets, header.transitions * sizeof(Id));
+            section(l.cumulative, m_cumulative, header.transitions * sizeof(double));
+            section(l.context_offsets, m_context_offsets, (m_rows + 1) * sizeof(uint64_t));
+            section(l.contexts, m_contexts, header.contexts * sizeof(Id));
+            section(l.slots, m_slots, m_size * sizeof(Slot));
+            section(l.size, nullptr, 0);
+            if(!file) {
+                throw std::runtime_error("Could not write the model '" + filename + "'.");
+            }
+        }
+
+        NamedMatrix TransitionTable::matrix() const {
+            std::vector<std::string> columns;
+            for(Id c = 0; c < m_columns; ++c) {
+                if(!m_mask || m_mask->states[c]) {
+                    columns.emplace_back(m_names[c]);
+                }
+            }
+            std::vector<std::string> rows;
+            std::vector<Row>         kept;
+            for(Row r = 0; r < m_rows; ++r) {
+                if(m_mask && m_mask->rows[r] == Mask::HIDE) {
+                    continue;
+                }
+                std::string name;
+                for(auto i = m_context_offsets[r]; i < m_context_offsets[r + 1]; ++i) {
+                    name += (name.empty() ? "" : std::string(1, SEPARATOR)) + m_names[m_contexts[i]];
+                }
+                rows.emplace_back(name);
+                kept.emplace_back(r);
+            }
+            NamedMatrix res{rows, columns};
+            for(std::size_t k = 0; k < kept.size(); ++k) {
+                auto r = kept[k];
+                if(m_mask && m_mask->rows[r] == Mask::UNIFORM) {
+                    for(const auto& c : m_mask->columns) {
+                        res.at(rows[k], m_names[c]) = 1.0 / (double)m_mask->columns.size();
+                    }
+                    continue;
+                }
+                for(auto i = m_offsets[r]; i < m_offsets[r + 1]; ++i) {
+                    if(m_mask && !m_mask->states[m_targets[i]]) {
+                        continue;
+                    }
+                    auto previous = i == m_offsets[r] ? 0.0 : m_cumulative[i - 1];
+                    auto chance   = m_cumulative[i] - previous;
+                    res.at(rows[k], m_names[m_targets[i]]) = m_mask ? chance / m_mask->totals[r] : chance;
+                }
+            }
+            return res;
+        }
+
+        TransitionTable TransitionTable::filter(const std::vector<std::string>& keep) const {
+            auto mask = std::make_shared<Mask>();
+            mask->states.assign(m_states, 1);
+            for(Id c = 0; c < m_columns; ++c) {
+                mask->states[c] = 0;
+            }
+            for(const auto& name : keep) {
+                auto id = find(name);
+                if(id != NONE && id < m_columns && (!m_mask || m_mask->states[id])) {
+                    mask->states[id] = 1;
+                }
+            }
+            for(Id c = 0; c < m_columns; ++c) {
+                if(mask->states[c]) {
+                    mask->columns.emplace_back(c);
+                }
+            }
+
+            // The totals are sums of the same chances as in a table created from the filtered matrix
+            mask->rows.assign(m_rows, Mask::KEEP);
+            mask->totals.assign(m_rows, 1.0);
+            for(Row r = 0; r < m_rows; ++r) {
+                bool hidden = false;
+                for(auto i = m_context_offsets[r]; i < m_context_offsets[r + 1]; ++i) {
+                    hidden = hidden || !mask->states[m_contexts[i]];
+                }
+                if(hidden) {
+                    mask->rows[r] = Mask::HIDE;
+                    continue;
+                }
+
+                double total    = 0.0;
+                bool   removed  = false;
+                double previous = 0.0;
+                for(auto i = m_offsets[r]; i < m_offsets[r + 1]; ++i) {
+                    if(mask->states[m_targets[i]]) {
+                        total += m_cumulative[i] - previous;
+                    } else {
+                        removed = true;
+                    }
+                    previous = m_cumulative[i];
+                }
+                if(removed) {
+                    mask->rows[r]   = total > 0.0 ? Mask::SCALE : Mask::UNIFORM;
+                    mask->totals[r] = total;
+                }
+            }
+
+            TransitionTable view = *this;
+            view.m_mask          = mask;
+            return view;
+        }
+
+        TransitionTable::Row TransitionTable::row(const Id* context, std::size_t length) const {
+            for(auto l = std::min(length, m_order); l > 0; --l) {
+                auto r = lookup(context + (length - l), l);
+                if(r != NO_ROW && !(m_mask && m_mask->rows[r] == Mask::HIDE)) {
+                    return r;
+                }
+            }
+            return NO_ROW;
+        }
+
+        TransitionTable::Id TransitionTable::next(Row row, double u) const {
+            if(row >= m_rows) {
+                throw std::out_of_range("Unknown context in the TransitionTable.");
+            }
+            if(m_mask && m_mask->rows[row] != Mask::KEEP) {
+                return masked(row, u);
+            }
+            auto begin = m_cumulative + m_offsets[row];
+            auto end   = m_cumulative + m_offsets[row + 1];
+            if(begin == end) {
+                throw std::out_of_range("A context of the TransitionTable has no transitions.");
+            }
+            auto it = std::upper_bound(begin, end, u);
+            if(it == end) {
+                --it;
+            }
+            return m_targets[it - m_cumulative];
+        }
+
+        void TransitionTable::next(const Row* rows, const double* u, Id* out, std::size_t n) const {
+            // The lanes are searched in chunks, so the state of the searches stays on the stack
+            constexpr std::size_t LANES = 64;
+            uint64_t              base[LANES];
+            uint64_t              length[LANES];
+            bool                  masks[LANES];
+
+            for(std::size_t first = 0; first < n; first += LANES) {
+                const auto lanes   = std::min(LANES, n - first);
+                uint64_t   longest = 1;
+                for(std::size_t i = 0; i < lanes; ++i) {
+                    auto r = rows[first + i];
+                    if(r >= m_rows) {
+                        throw std::out_of_range("Unknown context in the TransitionTable.");
+                    }
+                    base[i]   = m_offsets[r];
+                    length[i] = m_offsets[r + 1] - base[i];
+                    masks[i]  = m_mask && m_mask->rows[r] != Mask::KEEP;
+                    if(masks[i]) {
+                        // Masked rows walk their own chances; their search below is a no-op
+                        out[first + i] = masked(r, u[first + i]);
+                        length[i]      = 1;
+                    } else if(length[i] == 0) {
+                        throw std::out_of_range("A context of the TransitionTable has no transitions.");
+                    }
+                    longest = std::max(longest, length[i]);
+                }
+
+                // Each round halves the range of every lane; the first element after it is the upper bound of u
+                for(; longest > 1; longest -= longest / 2) {
+                    for(std::size_t i = 0; i < lanes; ++i) {
+                        auto half = length[i] / 2;
+                        base[i] += m_cumulative[base[i] + half] <= u[first + i] ? half : 0;
+                        length[i] -= half;
+                    }
+                }
+                for(std::size_t i = 0; i < lanes; ++i) {
+                    if(!masks[i]) {
+                        auto last      = m_offsets[rows[first + i] + 1] - 1;
+                        auto at        = std::min<uint64_t>(base[i] + (m_cumulative[base[i]] <= u[first + i]), last);
+                        out[first + i] = m_targets[at];
+                    }
+                }
+            }
+        }
+
+        TransitionTable::Id TransitionTable::masked(Row row, double u) const {
+            const auto& columns = m_mask->columns;
+            switch(m_mask->rows[row]) {
+            case Mask::HIDE: throw std::out_of_range("A context of the TransitionTable has been filtered out.");
+            case Mask::UNIFORM:
+                if(columns.empty()) {
+                    throw std::out_of_range("A context of the TransitionTable has no transitions.");
+                }
+                return columns[std::min((std::size_t)(u * (double)columns.size()), columns.size() - 1)];
+            default: break;
+            }
+
+            // Walk the row like the cumulative chances of the kept targets only
+            double target   = u * m_mask->totals[row];
+            double sum      = 0.0;
+            double previous = 0.0;
+            Id     last     = NONE;
+            for(auto i = m_offsets[row]; i < m_offsets[row + 1]; ++i) {
+                if(m_mask->states[m_targets[i]]) {
+                    sum += m_cumulative[i] - previous;
+                    last = m_targets[i];
+                    if(sum > target) {
+                        return last;
+                    }
+                }
+                previous = m_cumulative[i];
+            }
+            return last;
+        }
+
+        double TransitionTable::chance(Row row, Id to) const {
+            if(row >= m_rows) {
+                throw std::out_of_range("Unknown context in the TransitionTable.");
+            }
+            if(m_mask) {
+                if(m_mask->rows[row] == Mask::HIDE || to >= m_states || !m_mask->states[to]) {
+                    return 0.0;
+                }
+                if(m_mask->rows[row] == Mask::UNIFORM) {
+                    return to < m_columns ? 1.0 / (double)m_mask->columns.size() : 0.0;
+                }
+            }
+            auto begin = m_targets + m_offsets[row];
+            auto end   = m_targets + m_offsets[row + 1];
+            auto it    = std::lower_bound(begin, end, to);
+            if(it == end || *it != to) {
+                return 0.0;
+            }
+            auto idx    = it - m_targets;
+            auto chance = m_cumulative[idx] - (it == begin ? 0.0 : m_cumulative[idx - 1]);
+            return m_mask ? chance / m_mask->totals[row] : chance;
+        }
+
+        std::size_t TransitionTable::degree(Row row) const {
+            if(row >= m_rows) {
+                throw std::out_of_range("Unknown context in the TransitionTable.");
+            }
+            if(!m_mask || m_mask->rows[row] == Mask::KEEP) {
+                return (std::size_t)(m_offsets[row + 1] - m_offsets[row]);
+            }
+            switch(m_mask->rows[row]) {
+            case Mask::HIDE: return 0;
+            case Mask::UNIFORM: return m_mask->columns.size();
+            default:
+                return (std::size_t)std::count_if(m_targets + m_offsets[row], m_targets + m_offsets[row + 1],
+                                                  [this](Id id) { return m_mask->states[id] != 0; });
+            }
+        }
+
+        TransitionTable::Id TransitionTable::find(const std::string& name) const {
+            auto end = m_sorted + m_states;
+            auto it  = std::lower_bound(m_sorted, end, name,
+                                       [this](Id id, const std::string& n) { return m_names[id] < n; });
+            return (it != end && m_names[*it] == name) ? *it : NONE;
+        }
+        std::vector<std::string> TransitionTable::context(const std::string& row) {
+            std::vector<std::string> res;
+            std::string::size_type   begin = 0;
+            while(true) {
+                auto end = row.find(SEPARATOR, begin);
+                res.emplace_back(row.substr(begin, end - begin));
+                if(end == std::string::npos) {
+                    return res;
+                }
+                begin = end + 1;
+            }
+        }
+
+        uint64_t TransitionTable::hash(const Id* context, std::size_t length) {
+            // FNV-1a over the ids, followed by a final mix so the low bits depend on all ids
+            uint64_t h = 14695981039346656037ull ^ length;
+            for(std::size_t i = 0; i < length; ++i) {
+                h = (h ^ context[i]) * 1099511628211ull;
+            }
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        void TransitionTable::view() {
+            const auto& s     = *m_storage;
+            m_states          = s.names.size();
+            m_rows            = s.offsets.size() - 1;
+            m_size            = s.slots.size();
+            m_names           = s.names.data();
+            m_sorted          = s.sorted.data();
+            m_offsets         = s.offsets.data();
+            m_targets         = s.targets.data();
+            m_cumulative      = s.cumulative.data();
+            m_context_offsets = s.context_offsets.data();
+            m_contexts        = s.contexts.data();
+            m_slots           = s.slots.data();
+        }
+
+        TransitionTable::Row TransitionTable::lookup(const Id* context, std::size_t length) const {
+            if(m_size == 0) {
+                return NO_ROW;
+            }
+            auto mask = m_size - 1;
+            auto h    = hash(context, length);
+            for(auto s = h & mask;; s = (s + 1) & mask) {
+                const auto& slot = m_slots[s];
+                if(slot.row == NO_ROW) {
+                    return NO_ROW;
+                }
+                if(slot.hash == h) {
+                    auto begin = m_contexts + m_context_offsets[slot.row];
+                    auto end   = m_contexts + m_context_offsets[slot.row + 1];
+                    if((std::size_t)(end - begin) == length && std::equal(begin, end, context)) {
+                        return slot.row;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,316 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_TRANSITIONTABLE_H
+#define AUTOPLAY_TRANSITIONTABLE_H
+
+#include "NamedMatrix.h"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        /**
+         * The TransitionTable class is a compact, read-only form of a transition matrix. All States are interned to
+         * integer ids once, and each row only stores its non-zero transitions (in compressed sparse row form), as
+         * cumulative chances. Going to the next State is a hash lookup and a binary search in a single row, and does
+         * not allocate.
+         *
+         * A row of the matrix may be named after a context of multiple States, joined by SEPARATOR from the oldest
+         * to the newest State (e.g. "C4|E4"). The order of the table is the length of its longest context. The rows
+         * are found through an open-addressing hash table on the ids of their context, so only the contexts that
+         * actually occur are stored.
+         *
+         * A table can be restricted to a subset of its States with filter(). The result is a view that shares all
+         * arrays with the table, and only adds a mask of the States that are kept and a renormalization per row.
+         *
+         * The arrays of a table are immutable and shared between its copies. They can be saved to a binary model
+         * file (see save()), which load() maps into memory and uses in place. Only the names of the States are
+         * copied, but load() validates every section once, so loading still takes time linear in the size of the
+         * model.
+         *
+         * The binary model starts with a Header, followed by these sections (in native byte order, each one aligned
+         * to 8 bytes):
+         *  - the offsets of the State names in the name data (uint64, states + 1)
+         *  - the name data (char, names)
+         *  - the ids of all States, sorted by name (Id, states)
+         *  - the offsets of the rows in the targets (uint64, rows + 1)
+         *  - the targets of all rows (Id, transitions)
+         *  - the cumulative chance of each target (double, transitions)
+         *  - the offsets of the contexts of the rows (uint64, rows + 1)
+         *  - the ids of the contexts of all rows (Id, contexts)
+         *  - the hash table (Slot, slots)
+         */
+        class TransitionTable
+        {
+        public:
+            using Id  = uint32_t;
+            using Row = uint32_t;
+
+            static constexpr Id   NONE      = std::numeric_limits<Id>::max();  ///< The id of an unknown State
+            static constexpr Row  NO_ROW    = std::numeric_limits<Row>::max(); ///< The index of an unknown context
+            static constexpr char SEPARATOR = '|'; ///< Separates the States of a context in a row name
+
+            static constexpr char     MAGIC[8] = {'A', 'P', 'M', 'A', 'R', 'K', 'O', 'V'}; ///< Starts a binary model
+            static constexpr uint32_t VERSION  = 1; ///< The version of the binary model format
+
+            /**
+             * Default constructor, creates an empty table.
+             */
+            TransitionTable();
+
+            /**
+             * Constructor
+             * @param matrix    The transition matrix. Its rows do not have to be normalized. A row without any
+             *                  positive element goes to each column with the same chance.
+             */
+            explicit TransitionTable(const NamedMatrix& matrix);
+
+            /**
+             * Load a binary model file. The file is mapped into memory and stays mapped as long as the table (or one
+             * of its copies) exists. The header and the sizes of the sections are checked, and a single pass over
+             * the offsets, ids and slots makes sure no lookup can read outside of the file.
+             * @param filename  The file to load.
+             * @return The table.
+             *
+             * @throws std::runtime_error When the file cannot be mapped, or is no valid model of this version.
+             */
+            static TransitionTable load(const std::string& filename);
+
+            /**
+             * Check if a file is a binary model, by looking at its first bytes.
+             * @param filename  The file to check.
+             * @return True if it starts with MAGIC.
+             */
+            static bool isModel(const std::string& filename);
+
+            /**
+             * Save the table as a binary model file. A view is saved as a table without the removed States.
+             * @param filename  The file to write.
+             *
+             * @throws std::runtime_error When the file cannot be written.
+             */
+            void save(const std::string& filename) const;
+
+            /**
+             * Create a transition matrix with the chances of the table. The columns are the first columns() States
+             * and the rows are the contexts. For a view, only the States and rows that are kept are used.
+             * @return The (normalized) matrix.
+             */
+            NamedMatrix matrix() const;
+
+            /**
+             * Create a view of the table that can only go to a subset of its States. The chances of each row are
+             * renormalized over the States that are kept, and the rows of contexts that contain a removed State are
+             * hidden, so row() falls back to a shorter context. A row that cannot go to any of the kept States goes
+             * to each of them with the same chance. This is the same as creating a table from the matrix without the
+             * removed columns (and rows), but the ids of the States do not change.
+             * @param keep  The States that can be gone to. States that are not columns are always kept; a filter of
+             *              a view keeps the States that are in both.
+             * @return The view.
+             */
+            TransitionTable filter(const std::vector<std::string>& keep) const;
+
+            /**
+             * Checks if the table is a view that has been created with filter().
+             * @return True if some States or rows are masked.
+             */
+            inline bool filtered() const { return (bool)m_mask; }
+
+            /**
+             * Find the row of the longest known suffix of a context; e.g. for an order 2 table and the context
+             * (A, B, C), the row of "B|C" is returned if it exists, otherwise the row of "C".
+             * @param context   The ids of the context, from the oldest to the newest State.
+             * @param length    The amount of ids in the context.
+             * @return The index of the row, or NO_ROW if none of the suffixes is known.
+             */
+            Row row(const Id* context, std::size_t length) const;
+
+            /**
+             * Go to the next State, for a uniform number that has already been drawn.
+             * @param row   The row of the current context.
+             * @param u     A uniformly distributed number in [0, 1).
+             * @return The id of the next State.
+             *
+             * @throws std::out_of_range When the row does not exist or has no transitions.
+             */
+            Id next(Row row, double u) const;
+
+            /**
+             * Go to the next State from many rows at once; this is the same as next(rows[i], u[i]) for each i.
+             * The cumulative chances of all rows are searched in lockstep with a binary search without branches, so
+             * the loads of the different rows overlap instead of waiting on each other.
+             * @param rows  The rows of the current contexts.
+             * @param u     A uniformly distributed number in [0, 1) for each row.
+             * @param out   The buffer for the ids of the next States, of at least n elements.
+             * @param n     The amount of rows.
+             *
+             * @throws std::out_of_range When a row does not exist or has no transitions.
+             */
+            void next(const Row* rows, const double* u, Id* out, std::size_t n) const;
+
+            /**
+             * Get the chance to go from a context to a State.
+             * @param row   The row of the context.
+             * @param to    The id of the next State.
+             * @return The chance, in [0, 1].
+             */
+            double chance(Row row, Id to) const;
+
+            /**
+             * Find the id of a State.
+             * @param name  The name of the State.
+             * @return The id, or NONE if the State is unknown.
+             */
+            Id find(const std::string& name) const;
+
+            /**
+             * Get the name of a State.
+             * @param id    The id of the State.
+             * @return The name of the State.
+             */
+            inline const std::string& name(Id id) const {
+                if(id >= m_states) {
+                    throw std::out_of_range("Unknown State id in the TransitionTable.");
+                }
+                return m_names[id];
+            }
+
+            /**
+             * Get the amount of non-zero transitions of a row.
+             * @param row   The index of the row.
+             * @return The amount of States that can follow.
+             */
+            std::size_t degree(Row row) const;
+
+            /**
+             * Get the amount of States.
+             * @return The amount of States.
+             */
+            inline std::size_t size() const { return m_states; }
+
+            /**
+             * Get the amount of States that can be gone to; they have the ids 0 to columns() - 1.
+             * @return The amount of columns of the matrix the table was created from.
+             */
+            inline std::size_t columns() const { return m_columns; }
+
+            /**
+             * Get the amount of rows (i.e. known contexts).
+             * @return The amount of rows.
+             */
+            inline std::size_t rows() const { return m_rows; }
+
+            /**
+             * Get the length of the longest context.
+             * @return The order of the table; 1 for a first-order Markov Chain.
+             */
+            inline std::size_t order() const { return m_order; }
+
+            /**
+             * Split the name of a row into the States of its context.
+             * @param row   The name of the row.
+             * @return The States, from the oldest to the newest.
+             */
+            static std::vector<std::string> context(const std::string& row);
+
+        private:
+            /**
+             * Hash the ids of a context.
+             * @param context   The ids of the context.
+             * @param length    The amount of ids in the context.
+             * @return The hash of the context.
+             */
+            static uint64_t hash(const Id* context, std::size_t length);
+
+            /**
+             * Find the row of a context with an exact length.
+             * @param context   The ids of the context.
+             * @param length    The amount of ids in the context.
+             * @return The index of the row, or NO_ROW if the context is unknown.
+             */
+            Row lookup(const Id* context, std::size_t length) const;
+
+            /**
+             * Go to the next State from a row that is renormalized or replaced by the mask of a view.
+             * @param row   The row of the current context.
+             * @param u     A uniformly distributed number in [0, 1).
+             * @return The id of the next State.
+             */
+            Id masked(Row row, double u) const;
+
+            /**
+             * Point the arrays of the table to the storage.
+             */
+            void view();
+
+            /**
+             * A slot of the open-addressing hash table.
+             */
+            struct Slot {
+                uint64_t hash;   ///< The hash of the context
+                Row      row;    ///< The row of the context, or NO_ROW if the slot is empty
+                uint32_t unused; ///< Padding, so the layout in a binary model is fixed
+            };
+
+            /**
+             * The first bytes of a binary model.
+             */
+            struct Header {
+                char     magic[8];    ///< MAGIC
+                uint32_t version;     ///< VERSION
+                uint32_t endian;      ///< 0x01020304, to detect files of another byte order
+                uint64_t states;      ///< The amount of States
+                uint64_t columns;     ///< The amount of columns
+                uint64_t order;       ///< The length of the longest context
+                uint64_t rows;        ///< The amount of rows
+                uint64_t transitions; ///< The amount of non-zero transitions
+                uint64_t contexts;    ///< The total length of all contexts
+                uint64_t slots;       ///< The size of the hash table
+                uint64_t names;       ///< The total length of all State names
+            };
+
+            struct Storage;
+            struct Mask;
+
+            std::shared_ptr<const Storage> m_storage; ///< The arrays, or the mapped model file
+            std::shared_ptr<const Mask>    m_mask;    ///< The States and rows that are kept by filter(), if any
+
+            std::size_t m_states;  ///< The amount of States
+            std::size_t m_columns; ///< The amount of States that can be gone to
+            std::size_t m_order;   ///< The length of the longest context
+            std::size_t m_rows;    ///< The amount of rows
+            std::size_t m_size;    ///< The size of the hash table; a power of 2 (or 0)
+
+            const std::string* m_names;           ///< The name of each State
+            const Id*          m_sorted;          ///< The ids of all States, sorted by name
+            const uint64_t*    m_offsets;         ///< The start of each row in m_targets; has rows() + 1 elements
+            const Id*          m_targets;         ///< The States each row can go to
+            const double*      m_cumulative;      ///< The cumulative chance of each target, ending at 1 per row
+            const uint64_t*    m_context_offsets; ///< The start of the context of each row in m_contexts
+            const Id*          m_contexts;        ///< The ids of the contexts of all rows
+            const Slot*        m_slots;           ///< The hash table
+        };
+    }
+}
+
+#endif // AUTOPLAY_TRANSITIONTABLE_H
@@ -427,6 +427,10 @@ namespace autoplay {
                     notes.emplace_back(n);
                 }
             }
+            // Only octaves of the same note
+            if(notes.size() < 2) {
+                return notes.front();
+            }
             // Discard pitch names
             std::vector<unsigned int> remapping;
             std::string               root;
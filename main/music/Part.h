@@ -20,13 +20,18 @@
 
 #include "Instrument.h"
 #include "Measure.h"
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace autoplay {
     namespace music {
         /**
          * The Part class is a container that links an instrument to a set of measures.
+         *
+         * To allow fast lookups, a Part keeps an index of the timing of all its Chords. This index is rebuilt each
+         * time the Measures are set. When the Chords of a Measure are changed afterwards, reindex() must be called.
          */
         class Part
         {
@@ -38,7 +43,9 @@ namespace autoplay {
              * objects.
              */
             explicit Part(std::shared_ptr<Instrument> instrument, const MeasureList& measures = {})
-                : m_measures(measures), m_instruments({std::move(instrument)}), m_instrument_name(""), m_lines(5) {}
+                : m_measures(measures), m_instruments({std::move(instrument)}), m_instrument_name(""), m_lines(5) {
+                reindex();
+            }
 
             /**
              * Constructor of Part
@@ -47,7 +54,9 @@ namespace autoplay {
              * objects.
              */
             explicit Part(const std::vector<std::shared_ptr<Instrument>>& instruments, const MeasureList& measures = {})
-                : m_measures(measures), m_instruments(instruments), m_instrument_name(""), m_lines(5) {}
+                : m_measures(measures), m_instruments(instruments), m_instrument_name(""), m_lines(5) {
+                reindex();
+            }
 
             /**
              * Adds an Instrument
@@ -59,14 +68,20 @@ namespace autoplay {
              * Sets a series of Measure pointers
              * @param m A vector of shared pointers to the Measure pointers
              */
-            inline void setMeasures(const MeasureList& m) { m_measures = m; }
+            inline void setMeasures(const MeasureList& m) {
+                m_measures = m;
+                reindex();
+            }
 
             /**
              * Sets a series of Measure pointers via a single (usually overflowing)
              * Measure
              * @param m Measure that can be measurized.
              */
-            inline void setMeasures(const Measure& m) { m_measures = m.measurize(); }
+            inline void setMeasures(const Measure& m) {
+                m_measures = m.measurize();
+                reindex();
+            }
 
             /**
              * Gets the Instrument vector of this Part
@@ -127,45 +142,67 @@ namespace autoplay {
              */
             inline uint8_t getLines() const { return m_lines; }
 
+            /**
+             * Rebuild the timing index of this Part. This needs to be called when the Chords of one of the Measures
+             * have been changed, added or removed.
+             */
+            void reindex() {
+                m_measure_ends.clear();
+                m_chord_offsets.assign(1, 0);
+                m_chord_ends.clear();
+
+                unsigned int c   = 0;
+                unsigned int len = 0;
+                for(const auto& m : m_measures) {
+                    if(m->hasAttributes()) {
+                        len = m->max_length();
+                    }
+                    unsigned int rel = 0;
+                    for(const Chord& chord : m->getNotes()) {
+                        rel += chord.getDuration();
+                        m_chord_ends.emplace_back(rel);
+                    }
+                    c += len;
+                    m_measure_ends.emplace_back(c);
+                    m_chord_offsets.emplace_back(m_chord_ends.size());
+                }
+            }
+
             /**
              * Compute the Chord that is playing at a certain time
              * @param timestamp The time to look
              * @return A pointer to the Chord that is playing, or nullptr if no Chord has
              * been found.
+             *
+             * @note A Chord is playing at time t if it starts before t and ends at or after t. At time 0, the first
+             *       Chord is playing.
              */
             Chord* at(unsigned int timestamp) const {
-                unsigned int c  = 0;
-                unsigned int mi = 0;
-                auto         m  = m_measures.at(mi);
-                if(!m->hasAttributes()) {
+                if(m_measures.empty()) {
+                    return nullptr;
+                }
+                if(!m_measures.front()->hasAttributes()) {
                     throw std::invalid_argument("First measure of part has no time signature.");
                 }
 
                 // Find the right Measure
-                auto len = m->max_length();
-                while(c + len < timestamp && mi < m_measures.size()) {
-                    m = m_measures.at(mi++);
-                    if(m->hasAttributes()) {
-                        len = m->max_length();
-                    }
-                    c += len;
-                }
+                auto mit = std::lower_bound(m_measure_ends.begin(), m_measure_ends.end(), timestamp);
 
                 // Timestamp is too large
-                if(mi >= m_measures.size()) {
+                if(mit == m_measure_ends.end()) {
                     return nullptr;
                 }
+                auto         mi = (std::size_t)std::distance(m_measure_ends.begin(), mit);
+                unsigned int c  = mi == 0 ? 0 : m_measure_ends.at(mi - 1);
 
                 // Find the right Chord
-                for(Chord& chord : m_measures.at(mi)->getNotes()) {
-                    if(c + chord.getDuration() < timestamp) {
-                        c += chord.getDuration();
-                    } else {
-                        return &chord;
-                    }
+                auto first = m_chord_ends.begin() + m_chord_offsets.at(mi);
+                auto last  = m_chord_ends.begin() + m_chord_offsets.at(mi + 1);
+                auto cit   = std::lower_bound(first, last, timestamp - c);
+                if(cit == last) {
+                    return nullptr;
                 }
-
-                return nullptr;
+                return &m_measures.at(mi)->getNotes().at((std::size_t)std::distance(first, cit));
             }
 
             /**
@@ -178,19 +215,8 @@ namespace autoplay {
                     return nullptr;
                 }
 
-                // Find the correct Measure
-                unsigned int mi     = 0;
-                unsigned int curidx = 0;
-                while(curidx < n) {
-                    // curidx is the first index of the next Measure
-                    curidx += m_measures.at(mi++)->getNotes().size();
-                }
-                if(curidx == n) {
-                    return &m_measures.at(mi)->getNotes().at(0);
-                } else {
-                    curidx -= m_measures.at(--mi)->getNotes().size();
-                    return &m_measures.at(mi)->getNotes().at(n - curidx);
-                }
+                auto mi = measureOf(n);
+                return &m_measures.at(mi)->getNotes().at(n - m_chord_offsets.at(mi));
             }
 
             /**
@@ -203,27 +229,37 @@ namespace autoplay {
                     return false;
                 }
 
-                // Find the correct Measure
-                unsigned int mi     = 0;
-                unsigned int curidx = 0;
-                while(curidx < n) {
-                    // curidx is the first index of the next Measure
-                    curidx += m_measures.at(mi++)->getNotes().size();
-                }
-                if(curidx == n) {
-                    m_measures.at(mi)->getNotes().at(0).toPause();
-                } else {
-                    curidx -= m_measures.at(--mi)->getNotes().size();
-                    m_measures.at(mi)->getNotes().at(n - curidx).toPause();
-                }
+                auto mi = measureOf(n);
+                m_measures.at(mi)->getNotes().at(n - m_chord_offsets.at(mi)).toPause();
                 return true;
             }
 
+            /**
+             * Get the total amount of Chords in this Part
+             * @return The amount of Chords
+             */
+            inline std::size_t chordCount() const { return m_chord_ends.size(); }
+
+        private:
+            /**
+             * Find the index of the Measure that contains the nth Chord of the Part
+             * @param n The index of the Chord
+             * @return The index of the Measure.
+             */
+            inline std::size_t measureOf(unsigned int n) const {
+                auto it = std::upper_bound(m_chord_offsets.begin(), m_chord_offsets.end(), (std::size_t)n);
+                return (std::size_t)std::distance(m_chord_offsets.begin(), it) - 1;
+            }
+
         private:
             MeasureList                              m_measures;        ///< The Measure pointers of this Part
             std::vector<std::shared_ptr<Instrument>> m_instruments;     ///< The Instrument vector of this Part
             std::string                              m_instrument_name; ///< The Instrument Name
             uint8_t                                  m_lines;           ///< The amount of lines for a stave
+
+            std::vector<unsigned int> m_measure_ends;  ///< The end time of each Measure
+            std::vector<std::size_t>  m_chord_offsets; ///< The index of the first Chord of each Measure
+            std::vector<unsigned int> m_chord_ends;    ///< The end time of each Chord, relative to its Measure
         };
     }
 }
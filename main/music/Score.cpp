@@ -16,6 +16,7 @@
  */
 
 #include "Score.h"
+#include <algorithm>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/foreach.hpp>
 #include <zupply/src/zupply.hpp>
@@ -57,5 +58,18 @@ namespace autoplay {
 
             return result;
         }
+
+        std::vector<Chord*> Score::concurrent(unsigned int timestamp, std::size_t count) const {
+            std::vector<Chord*> res;
+            count = std::min(count, m_parts.size());
+            res.reserve(count);
+            for(std::size_t p = 0; p < count; ++p) {
+                Chord* n = m_parts[p]->at(timestamp);
+                if(n) {
+                    res.emplace_back(n);
+                }
+            }
+            return res;
+        }
     }
 }
\ No newline at end of file
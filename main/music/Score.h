@@ -53,7 +53,16 @@ namespace autoplay {
              * Get all the Parts of this Score.
              * @return A vector with shared ponters to parts.
              */
-            inline std::vector<std::shared_ptr<Part>> getParts() const { return m_parts; }
+            inline const std::vector<std::shared_ptr<Part>>& getParts() const { return m_parts; }
+
+            /**
+             * Compute the Chords that are playing at a certain time in the first Parts of this Score.
+             * @param timestamp The time to look
+             * @param count     The amount of Parts to look in, starting from the first one.
+             * @return A vector of pointers to all Chords that are playing. Parts without a Chord at that time are
+             *         skipped.
+             */
+            std::vector<Chord*> concurrent(unsigned int timestamp, std::size_t count) const;
 
             /**
              * Set the header data to
@@ -37,7 +37,7 @@ namespace autoplay {
             return true;
         }
 
-        Config::Config(int argc, char** argv) {
+        Config::Config(int argc, char** argv) : m_batch(1, 0) {
             // Setup System Logger
             zz::log::LogConfig::instance().set_format("[%datetime][%level]\t%msg");
             m_logger = zz::log::get_logger("system_logger");
@@ -90,6 +90,23 @@ namespace autoplay {
                                             "filename")
                 .set_once();
 
+            int jobs = 0;
+            parser
+                .add_opt_value<int>('j', "jobs", jobs, 0,
+                                    "the amount of threads to generate or train with (0 uses all hardware threads)",
+                                    "amount")
+                .set_once();
+
+            // Allow for batch generation
+            std::vector<std::string> batch;
+            parser
+                .add_opt_value<std::vector<std::string>>(
+                    'b', "batch", batch, {}, "Generate a Score for each seed in a range (bounds included)")
+                .set_type("first_seed\nlast_seed")
+                .set_min(2)
+                .set_max(2)
+                .set_once();
+
             // Allow for Markov Training
             std::vector<std::string> markov;
             parser
@@ -99,6 +116,50 @@ namespace autoplay {
                 .set_min(4)
                 .set_max(4)
                 .set_once();
+            int order = 1;
+            parser
+                .add_opt_value<int>('o', "order", order, 1,
+                                    "the amount of previous events that decide the next one in Markov training",
+                                    "amount")
+                .set_once();
+
+            std::string manifest;
+            parser
+                .add_opt_value<std::string>('u', "update", manifest, "",
+                                            "Only train on the files that are not in the manifest, and add their "
+                                            "counts to the existing files of the Markov training",
+                                            "manifest")
+                .set_once();
+
+            std::string cache;
+            parser
+                .add_opt_value<std::string>('C', "cache", cache, "",
+                                            "Keep the counts of every file of the Markov training in this directory, "
+                                            "so that unchanged files are not read again",
+                                            "directory")
+                .set_once();
+
+            // Allow for converting a Markov Chain to a binary model
+            std::vector<std::string> convert;
+            parser
+                .add_opt_value<std::vector<std::string>>('x', "convert", convert, {},
+                                                         "Convert a Markov Chain CSV file to a binary model")
+                .set_type("file_csv\nfile_model")
+                .set_min(2)
+                .set_max(2)
+                .set_once();
+
+            // Allow for analyzing a Markov Chain
+            std::vector<std::string> analyze;
+            parser
+                .add_opt_value<std::vector<std::string>>(
+                    'a', "analyze", analyze, {},
+                    "Print the stationary distribution of a Markov Chain, and the expected amount of times each state "
+                    "occurs in a sequence of a certain length (default 100)")
+                .set_type("file_chain\nlength")
+                .set_min(1)
+                .set_max(2)
+                .set_once();
 
             parser.parse(argc, argv);
 
@@ -108,7 +169,19 @@ namespace autoplay {
                 exit(EXIT_FAILURE);
             }
 
-            if(markov.empty()) {
+            if(!convert.empty()) {
+                m_convert = {convert.at(0), convert.at(1)};
+            } else if(!analyze.empty()) {
+                m_analyze = {analyze.at(0), 100};
+                if(analyze.size() == 2) {
+                    try {
+                        m_analyze.second = std::stoul(analyze.at(1));
+                    } catch(std::logic_error& e) {
+                        m_logger->fatal("Invalid length: it must be a positive number.");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+            } else if(markov.empty()) {
                 if(!filename.empty()) {
                     FileHandler fh;
                     try {
@@ -148,12 +221,41 @@ namespace autoplay {
                     m_logger->error("Invalid amount of 'clefs' attributes found!");
                 }
 
+                if(m_ptree.count("threads") == 1 && jobs == 0) {
+                    jobs = m_ptree.get<int>("threads");
+                } else if(m_ptree.count("threads") > 1) {
+                    m_logger->error("Invalid amount of 'threads' attributes found!");
+                }
+                if(jobs < 0) {
+                    m_logger->warn("The amount of threads is less than 0. Using all hardware threads instead.");
+                    jobs = 0;
+                }
+
+                if(batch.empty() && m_ptree.count("batch") == 1) {
+                    batch = {m_ptree.get<std::string>("batch.first"), m_ptree.get<std::string>("batch.last")};
+                } else if(m_ptree.count("batch") > 1) {
+                    m_logger->error("Invalid amount of 'batch' attributes found!");
+                }
+                if(!batch.empty()) {
+                    try {
+                        m_batch = {std::stoul(batch.at(0)), std::stoul(batch.at(1))};
+                    } catch(std::logic_error& e) {
+                        m_logger->fatal("Invalid batch: the seeds must be positive numbers.");
+                        exit(EXIT_FAILURE);
+                    }
+                    if(m_batch.first > m_batch.second) {
+                        m_logger->fatal("Invalid batch: the first seed must not be larger than the last one.");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+
                 if(!verbose) {
                     m_logger->set_level_mask(0x3c);
                 }
 
                 m_ptree.put("verbose", verbose);
                 m_ptree.put("play", play);
+                m_ptree.put("threads", jobs);
 
                 loadInstruments(instrument_file);
                 loadStyles(styles_file);
@@ -169,6 +271,18 @@ namespace autoplay {
                 m_markov["pitch"]     = markov.at(1);
                 m_markov["rhythm"]    = markov.at(2);
                 m_markov["chord"]     = markov.at(3);
+                if(order < 1) {
+                    m_logger->fatal("Invalid order: a Markov Chain must have an order of at least 1.");
+                    exit(EXIT_FAILURE);
+                }
+                m_markov["order"] = std::to_string(order);
+                if(jobs < 0) {
+                    m_logger->warn("The amount of threads is less than 0. Using all hardware threads instead.");
+                    jobs = 0;
+                }
+                m_markov["threads"] = std::to_string(jobs);
+                m_markov["manifest"] = manifest;
+                m_markov["cache"]    = cache;
             }
         }
 
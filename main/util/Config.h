@@ -149,10 +149,48 @@ namespace autoplay {
 
             /**
              * Fetches the values for the Markov Chains
-             * @return A map, containing 4 keys: (directory, pitch, rhythm and chord)
+             * @return A map, containing 8 keys: (directory, pitch, rhythm, chord, order, threads, manifest and
+             *         cache). The manifest is empty when all files are trained on, the cache when no TrainingCache is
+             *         used.
              */
             inline std::map<std::string, std::string> getMarkov() const { return m_markov; }
 
+            /**
+             * Check if a batch of Scores must be generated.
+             * @return True if it is.
+             */
+            inline bool isBatch() const { return m_batch.first <= m_batch.second; }
+
+            /**
+             * Fetches the range of seeds of the batch
+             * @return The first and last seed (both included)
+             */
+            inline std::pair<unsigned long, unsigned long> getBatch() const { return m_batch; }
+
+            /**
+             * Check if a Markov Chain must be converted to a binary model.
+             * @return True if it must.
+             */
+            inline bool isConvert() const { return !m_convert.first.empty(); }
+
+            /**
+             * Fetches the files of the conversion
+             * @return The CSV file and the binary model to write
+             */
+            inline std::pair<std::string, std::string> getConvert() const { return m_convert; }
+
+            /**
+             * Check if a Markov Chain must be analyzed.
+             * @return True if it must.
+             */
+            inline bool isAnalyze() const { return !m_analyze.first.empty(); }
+
+            /**
+             * Fetches the options of the analysis
+             * @return The Markov Chain to analyze and the length of the sequence to compute the histogram of
+             */
+            inline std::pair<std::string, unsigned long> getAnalyze() const { return m_analyze; }
+
         private:
             pt::ptree          m_ptree;       ///< The ptree that holds all configuration data
             pt::ptree          m_instruments; ///< The ptree that holds all Instruments
@@ -160,7 +198,10 @@ namespace autoplay {
             pt::ptree          m_clefs;       ///< The ptree that holds all Clefs
             zz::log::LoggerPtr m_logger;      ///< The system logger that's used everywhere
 
-            std::map<std::string, std::string> m_markov; ///< Stores the markov data
+            std::map<std::string, std::string>      m_markov;  ///< Stores the markov data
+            std::pair<unsigned long, unsigned long> m_batch;   ///< The range of seeds to generate, if first <= last
+            std::pair<std::string, std::string>     m_convert; ///< The CSV file and binary model to convert, if any
+            std::pair<std::string, unsigned long>   m_analyze; ///< The Markov Chain to analyze and a length, if any
         };
 
         template <typename T>
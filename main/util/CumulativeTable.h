@@ -0,0 +1,87 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_CUMULATIVETABLE_H
+#define AUTOPLAY_CUMULATIVETABLE_H
+
+#include <algorithm>
+#include <vector>
+
+namespace autoplay {
+    namespace util {
+        /**
+         * The CumulativeTable class stores the running sums of a set of weights, so that a weighted element can be
+         * found with a binary search instead of evaluating all weights again (see Randomizer::pick_cumulative).
+         */
+        class CumulativeTable
+        {
+        public:
+            /**
+             * Default constructor, creates an empty table.
+             */
+            CumulativeTable() : m_cumulative() {}
+
+            /**
+             * Constructor
+             * @param weights   The weight of each element. The weights are summed in order.
+             */
+            explicit CumulativeTable(const std::vector<float>& weights) : m_cumulative(weights.size()) {
+                float sum = 0.0f;
+                for(std::size_t i = 0; i < weights.size(); ++i) {
+                    sum += weights[i];
+                    m_cumulative[i] = sum;
+                }
+            }
+
+            /**
+             * Find the first element whose running sum reaches a certain weight.
+             * @param rw    The weight to look for, in [0, total()].
+             * @return The index of the element, or size() if none is found (e.g. when a weight is not a number).
+             */
+            inline std::size_t find(float rw) const {
+                if(!(rw <= total())) {
+                    return m_cumulative.size();
+                }
+                return (std::size_t)std::distance(
+                    m_cumulative.begin(), std::lower_bound(m_cumulative.begin(), m_cumulative.end(), rw));
+            }
+
+            /**
+             * Get the sum of all weights.
+             * @return The total weight.
+             */
+            inline float total() const { return m_cumulative.empty() ? 0.0f : m_cumulative.back(); }
+
+            /**
+             * Get the amount of elements.
+             * @return The size of the table.
+             */
+            inline std::size_t size() const { return m_cumulative.size(); }
+
+            /**
+             * Checks if the table is empty.
+             * @return True if empty.
+             */
+            inline bool empty() const { return m_cumulative.empty(); }
+
+        private:
+            std::vector<float> m_cumulative; ///< The running sums of the weights
+        };
+    }
+}
+
+#endif // AUTOPLAY_CUMULATIVETABLE_H
@@ -0,0 +1,108 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "DiscreteSampler.h"
+#include "Randomizer.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace autoplay {
+    namespace util {
+        DiscreteSampler::DiscreteSampler(const std::vector<double>& weights)
+            : m_prob(weights.size(), 1.0), m_alias(weights.size()) {
+            auto   n   = weights.size();
+            double sum = 0.0;
+            for(const auto& w : weights) {
+                if(!(w >= 0.0) || std::isinf(w)) {
+                    throw std::invalid_argument("Invalid weight " + std::to_string(w) + " for a DiscreteSampler.");
+                }
+                sum += w;
+            }
+            for(std::size_t i = 0; i < n; ++i) {
+                m_alias[i] = (uint32_t)i;
+            }
+            if(sum == 0.0) {
+                return;
+            }
+
+            // Scale the weights so that the average is 1, and split them in columns that are too small or too large
+            std::vector<double>   scaled(n);
+            std::vector<uint32_t> small;
+            std::vector<uint32_t> large;
+            for(std::size_t i = 0; i < n; ++i) {
+                scaled[i] = weights[i] * (double)n / sum;
+                if(scaled[i] < 1.0) {
+                    small.emplace_back((uint32_t)i);
+                } else {
+                    large.emplace_back((uint32_t)i);
+                }
+            }
+
+            // Fill each small column with a part of a large one
+            while(!small.empty() && !large.empty()) {
+                auto s = small.back();
+                auto l = large.back();
+                small.pop_back();
+                large.pop_back();
+
+                m_prob[s]  = scaled[s];
+                m_alias[s] = l;
+                scaled[l]  = (scaled[l] + scaled[s]) - 1.0;
+                if(scaled[l] < 1.0) {
+                    small.emplace_back(l);
+                } else {
+                    large.emplace_back(l);
+                }
+            }
+
+            // The remaining columns are (up to rounding errors) full
+            for(const auto& l : large) {
+                m_prob[l] = 1.0;
+            }
+            for(const auto& s : small) {
+                m_prob[s] = 1.0;
+            }
+        }
+
+        std::size_t DiscreteSampler::sample(double u) const {
+            if(m_prob.empty()) {
+                throw std::out_of_range("Cannot sample from an empty DiscreteSampler.");
+            }
+            double x   = u * (double)m_prob.size();
+            auto   col = (std::size_t)x;
+            if(col >= m_prob.size()) {
+                col = m_prob.size() - 1;
+            }
+            return x - (double)col < m_prob[col] ? col : m_alias[col];
+        }
+
+        std::size_t DiscreteSampler::sample(RNEngine& gen) const {
+            return sample(Randomizer::pick_uniform<double>(gen, 0.0, 1.0));
+        }
+
+        double DiscreteSampler::probability(std::size_t idx) const {
+            double p = m_prob.at(idx);
+            for(std::size_t i = 0; i < m_alias.size(); ++i) {
+                if(m_alias[i] == idx && i != idx) {
+                    p += 1.0 - m_prob[i];
+                }
+            }
+            return p / (double)m_prob.size();
+        }
+    }
+}
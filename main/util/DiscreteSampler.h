@@ -0,0 +1,94 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_DISCRETESAMPLER_H
+#define AUTOPLAY_DISCRETESAMPLER_H
+
+#include "RNEngine.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace autoplay {
+    namespace util {
+        /**
+         * The DiscreteSampler class picks an index according to a fixed set of weights in constant time. The weights
+         * are turned into an alias table (Vose's method) once, after which each pick takes a single uniform number,
+         * a multiplication and one comparison.
+         */
+        class DiscreteSampler
+        {
+        public:
+            /**
+             * Default constructor, creates an empty sampler.
+             */
+            DiscreteSampler() : m_prob(), m_alias() {}
+
+            /**
+             * Constructor
+             * @param weights   The (unnormalized) weight of each index. When all weights are 0, each index is
+             *                  equally likely.
+             *
+             * @throws std::invalid_argument When a weight is negative or not a number.
+             */
+            explicit DiscreteSampler(const std::vector<double>& weights);
+
+            /**
+             * Pick an index for a uniform number that has already been drawn (e.g. from a UniformBlock).
+             * @param u A uniformly distributed number in [0, 1)
+             * @return The picked index.
+             *
+             * @throws std::out_of_range When the sampler is empty.
+             */
+            std::size_t sample(double u) const;
+
+            /**
+             * Pick an index.
+             * @param gen   A random engine generator
+             * @return The picked index.
+             *
+             * @throws std::out_of_range When the sampler is empty.
+             */
+            std::size_t sample(RNEngine& gen) const;
+
+            /**
+             * Compute the chance that an index is picked, from the alias table.
+             * @param idx   The index.
+             * @return The chance, in [0, 1].
+             */
+            double probability(std::size_t idx) const;
+
+            /**
+             * Get the amount of indices.
+             * @return The size of the sampler.
+             */
+            inline std::size_t size() const { return m_prob.size(); }
+
+            /**
+             * Checks if the sampler is empty.
+             * @return True if empty.
+             */
+            inline bool empty() const { return m_prob.empty(); }
+
+        private:
+            std::vector<double>   m_prob;  ///< The chance to keep each column of the table
+            std::vector<uint32_t> m_alias; ///< The index to pick instead, for each column of the table
+        };
+    }
+}
+
+#endif // AUTOPLAY_DISCRETESAMPLER_H
@@ -19,14 +19,35 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <cmath>
 #include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream>
 #include <list>
+#include <unistd.h>
 
 namespace autoplay {
     namespace util {
+        namespace {
+            /**
+             * Flush a file (or directory) that has been written to disk.
+             * @param filename  The file to flush.
+             * @return Whether it has been flushed.
+             */
+            bool sync(const std::string& filename) {
+                int fd = ::open(filename.c_str(), O_RDONLY);
+                if(fd < 0) {
+                    return false;
+                }
+                bool synced = ::fsync(fd) == 0;
+                ::close(fd);
+                return synced;
+            }
+        }
+
         void FileHandler::setRoot(pt::ptree& pt) { m_root = pt; }
 
         void FileHandler::clearRoot() { m_root.clear(); }
@@ -67,6 +88,58 @@ namespace autoplay {
             }
         }
 
+        std::string FileHandler::suffixed(const std::string& filename, const std::string& suffix) {
+            auto lio = filename.find_last_of('.');
+            auto sep = filename.find_last_of("/\\");
+            if(lio == std::string::npos || (sep != std::string::npos && lio < sep)) {
+                return filename + "-" + suffix;
+            }
+            return filename.substr(0, lio) + "-" + suffix + filename.substr(lio);
+        }
+
+        void FileHandler::writeAtomic(const std::string& filename, const std::function<void(std::ostream&)>& write) {
+            boost::filesystem::path target{filename};
+            auto                    tmp =
+                target.parent_path() / boost::filesystem::unique_path(target.filename().string() + ".%%%%%%.tmp");
+            try {
+                std::ofstream file(tmp.string());
+                if(!file.is_open()) {
+                    throw std::runtime_error("Unable to open file with filename '" + tmp.string() + "'");
+                }
+                write(file);
+                file.close();
+                if(!file || !sync(tmp.string())) {
+                    throw std::runtime_error("Unable to write file with filename '" + tmp.string() + "'");
+                }
+                boost::filesystem::rename(tmp, target);
+
+                // Make the rename itself durable; not all file systems allow this, so it is not required
+                sync(target.parent_path().empty() ? "." : target.parent_path().string());
+            } catch(...) {
+                boost::system::error_code ec;
+                boost::filesystem::remove(tmp, ec);
+                throw;
+            }
+        }
+
+        uint64_t FileHandler::hash(const std::string& filename) {
+            std::ifstream file(filename, std::ios::binary);
+            if(!file.is_open()) {
+                throw std::runtime_error("Unable to open file with filename '" + filename + "'");
+            }
+            uint64_t h = 14695981039346656037ull;
+            char     buffer[1 << 16];
+            while(file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+                for(std::streamsize i = 0; i < file.gcount(); ++i) {
+                    h = (h ^ (unsigned char)buffer[i]) * 1099511628211ull;
+                }
+            }
+            if(file.bad()) {
+                throw std::runtime_error("Unable to read file with filename '" + filename + "'");
+            }
+            return h;
+        }
+
         void FileHandler::writeMusicXML(std::string filename, const music::Score& score) {
             // Set the valid extension
             auto        lio = filename.find_last_of('.');
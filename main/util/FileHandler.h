@@ -18,6 +18,8 @@
 #ifndef AUTOPLAY_FILEHANDLER_H
 #define AUTOPLAY_FILEHANDLER_H
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <string>
 
@@ -107,6 +109,34 @@ namespace autoplay {
              */
             static void writeMusicXML(std::string filename, const music::Score& score);
 
+            /**
+             * Add a suffix to a filename, in front of its extension; e.g. 'music.xml' becomes 'music-12.xml'.
+             * @param filename  The filename.
+             * @param suffix    The suffix to add (without separator).
+             * @return The new filename.
+             */
+            static std::string suffixed(const std::string& filename, const std::string& suffix);
+
+            /**
+             * Write a file atomically: the content is written to a temporary file in the same directory, which is
+             * flushed to disk and then replaces the file. Readers see either the old or the new file, and a failed
+             * write (or a power loss) leaves it untouched.
+             * @param filename  The file to write.
+             * @param write     The function that writes the content.
+             *
+             * @throws std::runtime_error When the file cannot be written.
+             */
+            static void writeAtomic(const std::string& filename, const std::function<void(std::ostream&)>& write);
+
+            /**
+             * Hash the content of a file with 64-bit FNV-1a.
+             * @param filename  The file to hash.
+             * @return The hash.
+             *
+             * @throws std::runtime_error When the file cannot be read.
+             */
+            static uint64_t hash(const std::string& filename);
+
         private:
             pt::ptree m_root;
         };
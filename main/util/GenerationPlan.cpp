@@ -0,0 +1,167 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "GenerationPlan.h"
+#include "../music/Note.h"
+
+#include <boost/foreach.hpp>
+#include <algorithm>
+
+namespace autoplay {
+    namespace util {
+        bool is_number(const std::string& s) {
+            return !s.empty() && std::find_if(s.begin(), s.end(), [](char c) { return !std::isdigit(c); }) == s.end();
+        }
+
+        /**
+         * Find the exponent of a named duration in the options.
+         * @param options   The options ptree.
+         * @param path      The path of the duration.
+         * @param def       The default duration name.
+         * @return The exponent of 2 (in whole notes) of the duration.
+         */
+        int duration_exponent(const pt::ptree& options, const std::string& path, const std::string& def) {
+            auto name = options.get<std::string>(path, def);
+            auto it   = music::Note::DURATION.find(name);
+            if(it == music::Note::DURATION.end()) {
+                throw std::invalid_argument("Invalid duration '" + name + "' for option '" + path + "'.");
+            }
+            return (int)std::log2(it->second);
+        }
+
+        GenerationPlan::GenerationPlan(const pt::ptree& generation, unsigned int stave,
+                                       const std::pair<uint8_t, uint8_t>& range, unsigned int divisions,
+                                       const std::string& root, const zz::log::LoggerPtr& logger)
+            : stave(stave), range(range), root(root), chance(0.0f),
+              rest_ratio(generation.get<float>("rest-ratio", 0.0f)), length(0), time({4, 4}), chord_progression() {
+            pt::ptree options;
+            if(generation.count("options") == 1) {
+                options = generation.get_child("options");
+            }
+
+            if(rest_ratio < 0.0f) {
+                logger->warn("The rest-ratio is less than 0. Changing it to 0.");
+                rest_ratio = std::fabs(rest_ratio);
+            }
+
+            /// Pitch
+            pitch.algorithm   = generation.get<std::string>("pitch", "random");
+            pitch.min         = options.get<long>("pitch.min", -3);
+            pitch.max         = options.get<long>("pitch.max", 3);
+            pitch.schematic   = options.get<std::string>("pitch.schematic", "");
+            pitch.chain       = options.get<std::string>("pitch.chain", "");
+            pitch.constrained = options.get<bool>("pitch.constrained", false);
+
+            if(pitch.algorithm == "accompaniment" && !pitch.schematic.empty()) {
+                auto sl = (unsigned int)pitch.schematic.length();
+                if((sl & (sl - 1)) != 0) {
+                    throw std::invalid_argument(
+                        "The schematic for the accompaniment has an invalid length. A power of 2 was expected, " +
+                        std::to_string(sl) + " was obtained.");
+                }
+            }
+            if(pitch.algorithm == "markov-chain" && pitch.chain.empty()) {
+                throw std::invalid_argument("The pitch Markov Chain requires the 'pitch.chain' option.");
+            }
+            if(pitch.algorithm != "markov-chain") {
+                // The Generator warns about this once, for the Parts that set the option themselves
+                pitch.constrained = false;
+            }
+
+            /// Rhythm
+            rhythm.algorithm = generation.get<std::string>("rhythm", "constant");
+            rhythm.divisions = divisions;
+            rhythm.smallest  = duration_exponent(options, "rhythm.smallest", "256th");
+            rhythm.largest   = duration_exponent(options, "rhythm.largest", "long");
+            rhythm.min       = options.get<int>("rhythm.min", -3);
+            rhythm.max       = options.get<int>("rhythm.max", 3);
+            rhythm.chain     = options.get<std::string>("rhythm.chain", "");
+
+            auto duration = options.get<std::string>("rhythm.duration", "quarter");
+            if(music::Note::DURATION.count(duration) == 1) {
+                rhythm.duration = rhythm.ticks((int)std::log2(music::Note::DURATION.at(duration)));
+            } else {
+                logger->warn("Invalid duration '{}' for option 'rhythm.duration'. Using a quarter note.", duration);
+                rhythm.duration = rhythm.ticks(-2);
+            }
+
+            if(rhythm.smallest > rhythm.largest) {
+                throw std::invalid_argument("The option 'rhythm.smallest' must not be larger than 'rhythm.largest'.");
+            }
+            if(rhythm.algorithm == "markov-chain" && rhythm.chain.empty()) {
+                throw std::invalid_argument("The rhythm Markov Chain requires the 'rhythm.chain' option.");
+            }
+
+            /// Chord
+            chord.algorithm = generation.get<std::string>("chord", "constant");
+            chord.min       = options.get<int>("chord.min", 1);
+            chord.max       = options.get<int>("chord.max", 1);
+            chord.amount    = options.get<int>("chord.amount", 1);
+            chord.chain     = options.get<std::string>("chord.chain", "");
+
+            if(chord.algorithm == "weighted") {
+                float sum = 0.0f;
+                if(options.count("chord") == 1) {
+                    BOOST_FOREACH(const auto& var, options.get_child("chord")) {
+                        if(is_number(var.first)) {
+                            auto s = var.second.get<float>("");
+                            sum += s;
+                            chord.weights.insert({std::stoi(var.first), s});
+                        }
+                    }
+                }
+
+                int min = chord.weights.empty() ? 1 : chord.weights.begin()->first;
+
+                // Fix chances if required
+                if(sum > 1.0f) { // Normalize
+                    logger->warn("Sum of all weighted elements exceeds 1! Normalizing the values...");
+                    for(auto& kv : chord.weights) {
+                        kv.second /= sum;
+                    }
+                    logger->warn("New values:");
+                    for(const auto& kv : chord.weights) {
+                        logger->warn("\t{} --> {}", kv.first, kv.second);
+                    }
+                } else if(sum < 1.0f) {
+                    float one = 1.0f - sum;
+                    if(chord.weights.count(1) == 1) {
+                        one += chord.weights.at(1);
+                        logger->warn("Invalid sum of {}. Changing chance that a single note occurs from {} to {}.",
+                                     sum, chord.weights.at(1), one);
+                    }
+                    chord.weights[1] = one;
+                    if(min != 1) {
+                        for(int j = 2; j < min; ++j) {
+                            chord.weights[j] = 0.0f;
+                        }
+                    }
+                }
+
+                std::vector<double> ws;
+                for(const auto& kv : chord.weights) {
+                    chord.amounts.emplace_back(kv.first);
+                    ws.emplace_back(kv.second);
+                }
+                chord.sampler = DiscreteSampler(ws);
+            }
+            if(chord.algorithm == "markov-chain" && chord.chain.empty()) {
+                throw std::invalid_argument("The chord Markov Chain requires the 'chord.chain' option.");
+            }
+        }
+    }
+}
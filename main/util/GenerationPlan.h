@@ -0,0 +1,167 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_GENERATIONPLAN_H
+#define AUTOPLAY_GENERATIONPLAN_H
+
+#include "Config.h"
+#include "CumulativeTable.h"
+#include "DiscreteSampler.h"
+#include "PitchTable.h"
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoplay {
+    namespace markov {
+        class MarkovChain;
+    }
+
+    namespace util {
+        /**
+         * The GenerationPlan struct holds all generation options of a single Part. It is resolved and validated
+         * once from the (merged) 'generation' config of that Part, so the algorithms never have to look anything
+         * up in a ptree while generating Notes.
+         */
+        struct GenerationPlan {
+            /**
+             * All options that are used by the pitch algorithms.
+             */
+            struct Pitch {
+                std::string algorithm;   ///< The name of the pitch algorithm
+                long        min;         ///< The lowest step for brownian motion (pitch.min)
+                long        max;         ///< The highest step for brownian motion (pitch.max)
+                std::string schematic;   ///< The accompaniment schematic (pitch.schematic), may be empty
+                std::string chain;       ///< The Markov Chain CSV (pitch.chain), may be empty
+                bool        constrained; ///< Plan the pitch Markov Chain to the chord roots (pitch.constrained)
+            };
+
+            /**
+             * All options that are used by the rhythm algorithms.
+             * Durations are expressed as exponents of 2 (in whole notes); e.g. -2 is a quarter note.
+             */
+            struct Rhythm {
+                std::string  algorithm; ///< The name of the rhythm algorithm
+                unsigned int divisions; ///< The amount of ticks a quarter note takes
+                int          smallest;  ///< The exponent of the smallest duration (rhythm.smallest)
+                int          largest;   ///< The exponent of the largest duration (rhythm.largest)
+                unsigned int duration;  ///< The constant duration in ticks (rhythm.duration)
+                int          min;       ///< The lowest step for brownian motion (rhythm.min)
+                int          max;       ///< The highest step for brownian motion (rhythm.max)
+                std::string  chain;     ///< The Markov Chain CSV (rhythm.chain), may be empty
+
+                /**
+                 * Convert a duration exponent to ticks.
+                 * @param exponent  The exponent of 2 (in whole notes).
+                 * @return The amount of ticks.
+                 */
+                inline unsigned int ticks(int exponent) const {
+                    return (unsigned int)(divisions * 4 * (float)std::pow(2.0f, exponent));
+                }
+            };
+
+            /**
+             * All options that are used by the chord note count algorithms.
+             */
+            struct Chord {
+                std::string          algorithm; ///< The name of the chord algorithm
+                int                  min;       ///< The smallest amount of Notes (chord.min)
+                int                  max;       ///< The largest amount of Notes (chord.max)
+                int                  amount;    ///< The constant amount of Notes (chord.amount)
+                std::map<int, float> weights;   ///< The normalized chances per amount of Notes
+                std::vector<int>     amounts;   ///< The keys of weights, in order
+                DiscreteSampler      sampler;   ///< Picks an index in amounts according to weights
+                std::string          chain;     ///< The Markov Chain CSV (chord.chain), may be empty
+            };
+
+            /**
+             * Resolve a GenerationPlan from a config.
+             * @param generation    The 'generation' ptree of the Part, merged with the global one.
+             * @param stave         The index of the Part.
+             * @param range         The range of the Clef of the Part.
+             * @param divisions     The amount of ticks a quarter note takes.
+             * @param root          The root note of the style (style.root).
+             * @param logger        The logger to report normalizations to.
+             *
+             * @throws std::invalid_argument when an option has an invalid value.
+             */
+            GenerationPlan(const pt::ptree& generation, unsigned int stave, const std::pair<uint8_t, uint8_t>& range,
+                           unsigned int divisions, const std::string& root, const zz::log::LoggerPtr& logger);
+
+            unsigned int                stave;      ///< The index of the Part
+            std::pair<uint8_t, uint8_t> range;      ///< The range of the stave, as <min, max>
+            std::string                 root;       ///< The root note of the style
+            float                       chance;     ///< The chance that a pitch is remapped to a root (style.chance)
+            float                       rest_ratio; ///< The ratio of Notes that become rests
+            PitchTable                  pitches;    ///< The pitches the pitch algorithm may choose from
+
+            unsigned int                length;            ///< The amount of Measures to generate
+            std::pair<uint8_t, uint8_t> time;              ///< The time signature, as <beats, beat type>
+            std::vector<std::string>    chord_progression; ///< The chord progression (style.chord-progression)
+
+            Pitch  pitch;  ///< The pitch options
+            Rhythm rhythm; ///< The rhythm options
+            Chord  chord;  ///< The chord note count options
+        };
+
+        /**
+         * The NoiseState struct holds the dice of a 1/f noise algorithm.
+         */
+        struct NoiseState {
+            NoiseState() : state(0), dice() {}
+
+            uint8_t                          state; ///< The amount of rolls since the last roll of all dice
+            std::vector<std::pair<int, int>> dice;  ///< The dice, as <value, highest value>
+        };
+
+        /**
+         * The GenerationContext struct contains a GenerationPlan together with all values that change while a
+         * Part is being generated. This includes the state of the algorithms, so that no state is shared between
+         * Parts and multiple Parts (or Scores) can be generated at the same time.
+         */
+        struct GenerationContext {
+            /**
+             * Constructor
+             * @param plan The plan of the Part to generate.
+             */
+            explicit GenerationContext(GenerationPlan plan)
+                : plan(std::move(plan)), tick(0), measure_length(0), chord_name(), reinit(true), rest(false), pitch_chain(),
+                  rhythm_chain(), chord_chain(), pitch_noise(), rhythm_noise(), pitch_weights() {}
+
+            GenerationPlan plan;           ///< The (immutable) plan of the Part
+            unsigned int   tick;           ///< The current timestamp
+            unsigned int   measure_length; ///< The length of a Measure in ticks
+            std::string    chord_name;     ///< The current chord of the chord progression, may be empty
+            bool           reinit;         ///< True when the first Chord of the Part is being generated
+            bool           rest;           ///< Set by a pitch algorithm when the Note must become a rest
+
+            std::shared_ptr<markov::MarkovChain> pitch_chain;   ///< The Markov Chain of the pitch algorithm
+            std::shared_ptr<markov::MarkovChain> rhythm_chain;  ///< The Markov Chain of the rhythm algorithm
+            std::shared_ptr<markov::MarkovChain> chord_chain;   ///< The Markov Chain of the chord algorithm
+            NoiseState                           pitch_noise;   ///< The dice of the 1/f noise pitch algorithm
+            NoiseState                           rhythm_noise;  ///< The dice of the 1/f noise rhythm algorithm
+            CumulativeTable                      pitch_weights; ///< The weights of the gaussian pitch algorithms
+        };
+    }
+}
+
+#endif // AUTOPLAY_GENERATIONPLAN_H
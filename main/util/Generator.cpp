@@ -17,12 +17,19 @@
 
 #include "Generator.h"
 #include "../markov/MarkovChain.h"
+#include "../markov/ModelRegistry.h"
+#include "PartGenerator.h"
 #include "Randomizer.h"
+#include "ThreadPool.h"
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/foreach.hpp>
 #include <bitset>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <set>
 #include <sstream>
 
 namespace autoplay {
@@ -31,218 +38,309 @@ namespace autoplay {
             : m_config(config), m_logger(logger) {
             // Set engine
             auto engine_name = m_config.conf<std::string>("engine");
-            auto seed        = m_config.conf<unsigned long>("seed", 0);
-            m_rnengine(engine_name, seed);
+            m_seed           = m_config.conf<unsigned long>("seed", 0);
+            m_rnengine(engine_name, m_seed);
+
+            // A global 'pitch.constrained' only applies to the Parts with a pitch Markov Chain, so only the Parts that
+            // set it themselves are reported
+            if(m_config.hasPath("parts")) {
+                auto parts     = m_config.conf_child("parts");
+                auto algorithm = m_config.conf<std::string>("generation.pitch", "random");
+                for(unsigned int i = 0; i < parts.size(); ++i) {
+                    auto pt_part = ptree_at(parts, i);
+                    if(pt_part.get<bool>("generation.options.pitch.constrained", false) &&
+                       pt_part.get<std::string>("generation.pitch", algorithm) != "markov-chain") {
+                        m_logger->warn("The option 'pitch.constrained' of Part {} only applies to the 'markov-chain' "
+                                       "pitch algorithm.",
+                                       i);
+                    }
+                }
+            }
         }
 
         music::Score Generator::generate() {
-            // Setup default values
-            auto          length     = (unsigned)m_config.conf<int>("length", 10); // Total amount of measures
-            auto          parts      = m_config.conf_child("parts");
-            unsigned long part_count = parts.size(); // Number of parts
-            int           divisions  = 64;           // Amount of 'ticks' each quarter note takes
+            return generate(m_seed, (unsigned int)std::max(0, m_config.conf<int>("threads", 0)));
+        }
 
-            std::pair<uint8_t, uint8_t> time = {(uint8_t)m_config.conf<int>("style.time.beats", 4),
-                                                (uint8_t)m_config.conf<int>("style.time.type", 4)};
+        /**
+         * Create the function that finds the Chords of the Parts before a Part.
+         * @param generators    The generators of all Parts.
+         * @param i             The index of the Part.
+         * @return The function, or an empty function if the Part does not look at the other Parts.
+         */
+        PartGenerator::Concurrent concurrent(std::vector<PartGenerator>& generators, unsigned int i) {
+            if(!generators.at(i).usesConcurrent()) {
+                return nullptr;
+            }
+            return [&generators, i](unsigned int tick) {
+                std::vector<music::Chord*> res;
+                res.reserve(i);
+                for(unsigned int p = 0; p < i; ++p) {
+                    music::Chord* c = generators.at(p).at(tick);
+                    if(c) {
+                        res.emplace_back(c);
+                    }
+                }
+                return res;
+            };
+        }
 
-            // Get Logger
-            auto logger = m_config.getLogger();
+        music::Score Generator::generate(unsigned long seed, unsigned int threads) const {
+            music::Score                   score{m_config.conf_child("export")};
+            std::vector<GenerationContext> contexts;
+            auto                           generators = start(seed, score, contexts);
+            auto                           part_count = (unsigned int)generators.size();
 
-            std::vector<std::string> chord_progression;
-            auto chord_progression_string = m_config.conf<std::string>("style.chord-progression", "");
-            if(!chord_progression_string.empty()) {
-                chord_progression = markov::split_on(chord_progression_string, '-');
+            if(threads == 0) {
+                threads = ThreadPool::hardware();
             }
+            threads = std::min(threads, part_count);
 
-            music::Score score{m_config.conf_child("export")};
+            auto                                   deps = dependencies(contexts);
+            std::vector<std::size_t>               waiting(part_count);
+            std::vector<std::size_t>               readers(part_count);
+            std::vector<std::vector<unsigned int>> dependents(part_count);
             for(unsigned int i = 0; i < part_count; ++i) {
-                auto pt_part = ptree_at(parts, i);
-                if(pt_part.count("generation") == 0) {
-                    pt_part.put_child("generation", m_config.conf_child("generation"));
-                } else {
-                    merge(pt_part.get_child("generation"), m_config.conf_child("generation"));
+                waiting.at(i) = deps.at(i).size();
+                for(const auto& d : deps.at(i)) {
+                    dependents.at(d).emplace_back(i);
+                    ++readers.at(d);
                 }
+            }
 
-                pt::ptree options;
-                options.put("stave", i);
-                options.put("_reinit", true);
-                if(pt_part.count("generation") == 0) {
-                    if(m_config.conf_child("generation").count("options") == 1) {
-                        BOOST_FOREACH(auto& var, m_config.conf_child("generation.options")) {
-                            options.put_child(var.first, var.second);
-                        }
+            // Generate a Part completely. The Chords of a Part are kept until all Parts that look at them are done.
+            auto generate_part = [&](unsigned int i) {
+                auto               conc = concurrent(generators, i);
+                music::MeasureList measures;
+                while(auto measure = generators.at(i).next(conc)) {
+                    measures.emplace_back(measure);
+                }
+                score.getParts().at(i)->setMeasures(measures);
+            };
+            // Once a Part is done, forget the Chords of the Parts that no other Part has to look at anymore
+            auto done_reading = [&](unsigned int i) {
+                for(const auto& d : deps.at(i)) {
+                    if(--readers.at(d) == 0) {
+                        generators.at(d).forget(std::numeric_limits<unsigned int>::max());
                     }
-                } else if(pt_part.get_child("generation").count("options") == 1) {
-                    BOOST_FOREACH(auto& var, pt_part.get_child("generation.options")) {
-                        options.put_child(var.first, var.second);
+                }
+            };
+
+            if(threads <= 1) {
+                for(unsigned int i = 0; i < part_count; ++i) {
+                    generate_part(i);
+                    done_reading(i);
+                }
+                return score;
+            }
+
+            // Generate a Part as soon as all Parts it depends on have been generated
+            std::mutex                        mutex;
+            std::function<void(unsigned int)> run;
+            ThreadPool                        pool{threads};
+            run = [&](unsigned int i) {
+                generate_part(i);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                done_reading(i);
+                for(const auto& d : dependents.at(i)) {
+                    if(--waiting.at(d) == 0) {
+                        pool.enqueue([&run, d]() { run(d); });
                     }
                 }
+            };
+            m_logger->debug("Generating {} parts on {} threads.", part_count, threads);
 
-                auto pitch_algo  = getPitchAlgorithm(pt_part.get<std::string>("generation.pitch", ""));
-                auto rhythm_algo = getRhythmAlgorithm(pt_part.get<std::string>("generation.rhythm", ""));
-                auto chord_algo  = getChordNoteCountAlgorithm(pt_part.get<std::string>("generation.chord", ""));
+            // Collect the roots first; once a task runs, it may already release (and enqueue) its dependents
+            std::vector<unsigned int> roots;
+            for(unsigned int i = 0; i < part_count; ++i) {
+                if(waiting.at(i) == 0) {
+                    roots.emplace_back(i);
+                }
+            }
+            for(const auto& i : roots) {
+                pool.enqueue([&run, i]() { run(i); });
+            }
+            pool.wait();
 
-                // Set Instrument(s)
-                bool percussion;
+            return score;
+        }
 
-                std::vector<std::shared_ptr<music::Instrument>> instruments = {};
-                std::map<std::string, std::string>                        repr_to_head;
-                std::map<std::string, std::shared_ptr<music::Instrument>> repr_to_inst;
-                if(pt_part.count("instrument") == 0) {
-                    percussion = false;
-                    BOOST_FOREACH(auto& inst, pt_part.get_child("instruments")) {
-                        auto instrument = m_config.getInstrument(inst.second.get<std::string>("instrument"));
-                        instrument->setChannel(10);
-                        instruments.emplace_back(instrument);
+        void Generator::stream(unsigned long seed, const MeasureSink& sink) const {
+            music::Score                   score{m_config.conf_child("export")};
+            std::vector<GenerationContext> contexts;
+            auto                           generators = start(seed, score, contexts);
 
-                        auto display = inst.second.get<std::string>("display", "C4");
-                        repr_to_head.insert(std::make_pair(display, inst.second.get<std::string>("symbol", "normal")));
-                        repr_to_inst.insert(std::make_pair(display, instrument));
-                    }
-                } else {
-                    auto instrument = m_config.getInstrument(pt_part.get<std::string>("instrument"));
-                    percussion      = instrument->isPercussion();
-                    instrument->setChannel((uint8_t)(i + 1));
-                    if(percussion) {
-                        instrument->setChannel(10);
-
-                        auto display = pt_part.get<std::string>("display", "C4");
-                        repr_to_head.insert(std::make_pair(display, pt_part.get<std::string>("symbol", "normal")));
-                        repr_to_inst.insert(std::make_pair(display, instrument));
-                    }
-                    instruments.emplace_back(instrument);
-                }
+            std::vector<PartGenerator::Concurrent> conc;
+            for(unsigned int i = 0; i < generators.size(); ++i) {
+                conc.emplace_back(concurrent(generators, i));
+            }
 
-                // Generate Notes
-                music::Clef clef = music::Clef::Treble();
-                if(percussion) {
-                    clef.setPercussion(true);
-                } else {
-                    clef = music::Clef{(unsigned char)pt_part.get<char>("clef.sign", 'G'),
-                                       (uint8_t)pt_part.get<int>("clef.line", 2),
-                                       pt_part.get<int>("clef.octave-change", 0)};
+            // All Parts have the same amount of Measures
+            music::MeasureList measures(generators.size());
+            for(unsigned int m = 0; !generators.empty(); ++m) {
+                for(unsigned int i = 0; i < generators.size(); ++i) {
+                    measures.at(i) = generators.at(i).next(conc.at(i));
+                }
+                if(!measures.front()) {
+                    break;
+                }
+                if(sink) {
+                    sink(score, m, measures);
                 }
-                music::Measure measure{clef, time, divisions, m_config.conf<int>("style.fifths")};
 
-                measure.setBPM(m_config.conf<int>("style.bpm", 80));
+                // Nothing before the next barline will be looked up anymore
+                for(auto& g : generators) {
+                    g.forget((m + 1) * g.measureLength());
+                }
+            }
+        }
 
-                options.put("rhythm._divs", divisions);
+        std::vector<std::vector<unsigned int>> Generator::dependencies() const {
+            std::vector<GenerationContext> contexts;
+            std::vector<pt::ptree>         pt_parts;
+            plans(contexts, pt_parts);
+            return dependencies(contexts);
+        }
 
-                std::shared_ptr<music::Part> part = std::make_shared<music::Part>(instruments);
-                part->setLines((uint8_t)pt_part.get<int>("lines", 5));
+        void Generator::plans(std::vector<GenerationContext>& contexts, std::vector<pt::ptree>& pt_parts) const {
+            // Setup default values
+            auto          parts      = m_config.conf_child("parts");
+            unsigned long part_count = parts.size(); // Number of parts
+            int           divisions  = 64;           // Amount of 'ticks' each quarter note takes
 
-                part->setInstrumentName(pt_part.get<std::string>("name", ""));
+            contexts.clear();
+            pt_parts.clear();
+            for(unsigned int i = 0; i < part_count; ++i) {
+                auto pt_part = ptree_at(parts, i);
+                if(pt_part.count("generation") == 0) {
+                    pt_part.put_child("generation", m_config.conf_child("generation"));
+                } else {
+                    merge(pt_part.get_child("generation"), m_config.conf_child("generation"));
+                }
 
-                std::shared_ptr<music::Chord> prev;
-                auto                          mlen = measure.max_length();
-                for(unsigned int j = 0; j < length * mlen;) {
-                    std::vector<music::Chord*> conc = {};
-                    for(unsigned int p = 0; p < i; ++p) {
-                        music::Chord* n = score.getParts().at(p)->at(j);
-                        if(n) {
-                            conc.emplace_back(n);
-                        }
-                    }
+                contexts.emplace_back(plan(i, pt_part, (unsigned)divisions));
+                pt_parts.emplace_back(pt_part);
+            }
+        }
 
-                    // Set Rhythm
-                    auto rh       = rhythm_algo(m_rnengine, prev.get(), conc, options);
-                    auto duration = (unsigned)(divisions * 4 * rh);
+        std::vector<PartGenerator> Generator::start(unsigned long seed, music::Score& score,
+                                                    std::vector<GenerationContext>& contexts) const {
+            // Resolve the plans of all Parts
+            std::vector<pt::ptree> pt_parts;
+            plans(contexts, pt_parts);
+            auto part_count = pt_parts.size();
 
-                    // Prevent overflowing over final measure
-                    if(j + duration > length * mlen) {
-                        duration = length * mlen - j;
-                    }
+            // Each Part has its own substream, so the result does not depend on the order of generation
+            RNEngine root{m_rnengine};
+            root.seed(seed);
 
-                    // Ability to do chords
-                    int num_notes = chord_algo(m_rnengine, prev.get(), conc, options);
+            std::vector<PartGenerator> generators;
+            generators.reserve(part_count);
+            for(unsigned int i = 0; i < part_count; ++i) {
+                generators.emplace_back(*this, m_config, contexts.at(i), pt_parts.at(i),
+                                        root.substream((unsigned int)part_count, i));
+                score.addPart(generators.back().part());
+            }
 
-                    music::Chord chord;
-                    if(!chord_progression.empty()) {
-                        options.put("_currchord", chord_progression.at((j / mlen) % chord_progression.size()));
-                    }
-                    options.put("j", j);
-                    options.put("mlen", mlen);
-                    for(int nn = 0; nn < num_notes; ++nn) {
-                        uint8_t pitch = pitch_algo(m_rnengine, prev.get(), conc, options);
-
-                        // Remap the percussion depending on the chord progression
-                        if(!percussion && !chord_progression.empty() && j % mlen == 0) {
-                            std::string value = chord_progression.at((j / mlen) % chord_progression.size());
-                            if(value.at(value.length() - 1) == 'm') {
-                                value = value.substr(0, value.length() - 1);
-                            }
-                            pitch = remapPitch(pitch, value, clef.range());
-                        }
+            // Only keep the Chords of the Parts that other Parts look at
+            for(const auto& deps : dependencies(contexts)) {
+                for(const auto& d : deps) {
+                    generators.at(d).setObserved(true);
+                }
+            }
+            return generators;
+        }
 
-                        if(chord.in(pitch)) {
-                            // --nn; ///< Infinite loop possible!
-                            continue;
-                        }
+        std::vector<Generator::BatchResult> Generator::batch(const std::vector<unsigned long>& seeds,
+                                                             const BatchSink& sink, unsigned int threads) const {
+            std::vector<BatchResult> results(seeds.size());
+            if(seeds.empty()) {
+                return results;
+            }
+            if(threads == 0) {
+                threads = ThreadPool::hardware();
+            }
+            threads = (unsigned int)std::min<std::size_t>(threads, seeds.size());
 
-                        music::Note note{pitch, duration};
+            // Each job is generated on a single thread; the jobs themselves run in parallel
+            ThreadPool pool{threads};
+            for(std::size_t k = 0; k < seeds.size(); ++k) {
+                pool.enqueue([this, &seeds, &sink, &results, k]() {
+                    auto& result  = results.at(k);
+                    result.seed   = seeds.at(k);
+                    result.chords = 0;
 
-                        if(options.get<bool>("pitch._rest", false)) {
-                            note.toPause();
-                            options.put("pitch._rest", false);
+                    auto start = std::chrono::steady_clock::now();
+                    try {
+                        auto score = generate(result.seed, 1);
+                        for(const auto& part : score.getParts()) {
+                            result.chords += part->chordCount();
                         }
-
-                        auto prepr = music::Note::pitchRepr(pitch);
-                        if(pt_part.count("instrument") == 0 || percussion) {
-                            note.setHead(repr_to_head.at(prepr));
-                            note.setInstrument(repr_to_inst.at(prepr));
+                        if(sink) {
+                            sink(result.seed, score);
                         }
+                    } catch(std::exception& e) { result.error = e.what(); }
+                    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+                    result.seconds                  = d.count();
+                });
+            }
+            pool.wait();
 
-                        chord.append(note);
-                    }
+            return results;
+        }
 
-                    prev = std::make_shared<music::Chord>(chord);
+        std::shared_ptr<const markov::MarkovChain> Generator::model(const std::string&              filename,
+                                                                    const std::vector<std::string>& keep) const {
+            auto& registry = markov::ModelRegistry::instance();
+            return keep.empty() ? registry.model(filename) : registry.model(filename, keep);
+        }
 
-                    measure.append(chord);
-                    j += duration;
+        std::vector<std::vector<unsigned int>> Generator::dependencies(const std::vector<GenerationContext>& contexts) {
+            std::vector<std::vector<unsigned int>> deps(contexts.size());
 
-                    options.put("_reinit", false);
+            for(unsigned int i = 0; i < contexts.size(); ++i) {
+                const auto& plan = contexts.at(i).plan;
+                if(plan.pitch.algorithm == "accompaniment" && plan.pitch.schematic.empty()) {
+                    // Looks at the concurrent Chords of all previous Parts
+                    for(unsigned int j = 0; j < i; ++j) {
+                        deps.at(i).emplace_back(j);
+                    }
                 }
+            }
 
-                part->setMeasures(measure);
+            return deps;
+        }
 
-                // Change the last Note to the root note with a chance of style.chance
-                if(!percussion) {
-                    auto c = part->back()->back().bottom()->getPitch();
-                    if(!part->back()->back().bottom()->getTieEnd()) {
-                        part->back()->back().bottom()->setPitch(
-                            remapPitch(c, m_config.conf<std::string>("style.root"), clef.range()));
-                    }
-                }
+        GenerationPlan Generator::plan(unsigned int stave, const pt::ptree& pt_part, unsigned int divisions) const {
+            GenerationPlan ret{pt_part.get_child("generation"), stave, staveRange((int)stave), divisions,
+                               m_config.conf<std::string>("style.root", "C"), m_logger};
 
-                // Generate random rests (for this part)
-                auto rests = pt_part.get<float>("generation.rest-ratio", 0.0f);
-                // if(pt_part.count("generation.rest-ratio") != 0) {
-                //     rests = pt_part.get<float>("generation.rest-ratio", 0.0f);
-                // }
-                if(rests < 0.0f) {
-                    logger->warn("The rest-ratio is less than 0. Changing it to 0.");
-                    rests = std::fabs(rests);
-                }
-                unsigned int ntcnt = 0;
-                for(const auto& _m : part->getMeasures()) {
-                    ntcnt += _m->getNotes().size();
-                }
-                auto amount = (unsigned int)std::round(ntcnt * rests);
-                for(unsigned int w = 0; w < amount; ++w) {
-                    auto idx = (unsigned)Randomizer::pick_uniform(m_rnengine, 0, ntcnt - 1);
-                    if(part->noteAt(idx)->getTieStart() || part->noteAt(idx)->getTieEnd()) {
-                        continue;
-                    }
-                    part->toPause(idx);
-                }
-                score.addPart(part);
+            ret.chance = m_config.conf<float>("style.chance");
+            ret.length = (unsigned)m_config.conf<int>("length", 10);
+            ret.time   = {(uint8_t)m_config.conf<int>("style.time.beats", 4),
+                        (uint8_t)m_config.conf<int>("style.time.type", 4)};
+
+            auto chord_progression = m_config.conf<std::string>("style.chord-progression", "");
+            if(!chord_progression.empty()) {
+                ret.chord_progression = markov::split_on(chord_progression, '-');
             }
 
-            return score;
+            // Build the pitch table once, instead of for every Note
+            static const std::set<std::string> in_range = {"contain-stave", "brownian-motion", "1/f-noise",
+                                                           "centralized",   "accompaniment",   "markov-chain",
+                                                           "gaussian-voicing"};
+            if(ret.pitch.algorithm == "random-piano") {
+                ret.pitches = PitchTable{getPitches(21, 108, (int)stave)};
+            } else if(in_range.count(ret.pitch.algorithm) == 1) {
+                ret.pitches = PitchTable{getPitches(ret.range.first, ret.range.second, (int)stave)};
+            } else {
+                ret.pitches = PitchTable{getPitches(0, 128, (int)stave)};
+            }
+            return ret;
         }
 
-        std::function<uint8_t(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt)>
-        Generator::getPitchAlgorithm(std::string algo) const {
+        Generator::PitchAlgorithm Generator::getPitchAlgorithm(std::string algo) const {
             // Get algorithm variables
             if(algo.empty()) {
                 algo = m_config.conf<std::string>("generation.pitch", "random");
@@ -252,48 +350,40 @@ namespace autoplay {
 
             if(algo == "random-piano") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    auto stave = pt.get<int>("stave");
-                    return (uint8_t)Randomizer::pick_uniform(gen, getPitches(21, 108, stave));
+                              GenerationContext& ctx) -> uint8_t {
+                    return Randomizer::pick_uniform(gen, ctx.plan.pitches.pitches());
                 };
             } else if(algo == "contain-stave") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    auto stave = pt.get<int>("stave");
-                    auto range = staveRange(stave);
-
-                    return (uint8_t)Randomizer::pick_uniform(gen, getPitches(range.first, range.second, stave));
+                              GenerationContext& ctx) -> uint8_t {
+                    return Randomizer::pick_uniform(gen, ctx.plan.pitches.pitches());
                 };
             } else if(algo == "brownian-motion") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t { return pitchBrownianMotion(gen, prev, conc, pt); };
+                              GenerationContext& ctx) -> uint8_t { return pitchBrownianMotion(gen, prev, conc, ctx); };
             } else if(algo == "1/f-noise") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    auto res = pitch1FNoise(gen, pt);
-                    return res;
-                };
+                              GenerationContext& ctx) -> uint8_t { return pitch1FNoise(gen, ctx); };
             } else if(algo == "centralized") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    auto stave = pt.get<int>("stave");
-                    auto range = staveRange(stave);
-                    auto p     = getPitches(range.first, range.second, stave);
-
-                    std::vector<float> p2;
-                    for(const auto& v : p) {
-                        p2.push_back((int)v);
+                              GenerationContext& ctx) -> uint8_t {
+                    const auto& p = ctx.plan.pitches.pitches();
+                    if(ctx.pitch_weights.empty()) {
+                        std::vector<float> p2;
+                        for(const auto& v : p) {
+                            p2.push_back((int)v);
+                        }
+                        ctx.pitch_weights = Randomizer::gaussian_table(p2);
                     }
-                    return (uint8_t)Randomizer::gaussian(gen, p2);
+                    auto idx = Randomizer::pick_cumulative(gen, ctx.pitch_weights);
+                    return idx < p.size() ? p.at(idx) : p.back();
                 };
             } else if(algo == "accompaniment") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    auto schematic = pt.get<std::string>("pitch.schematic", "");
-                    auto stave     = pt.get<int>("stave");
-                    auto range     = staveRange(stave);
-                    if(schematic.empty()) {
-                        auto chord = m_config.conf<std::string>("style.root", "C");
+                              GenerationContext& ctx) -> uint8_t {
+                    const auto& plan = ctx.plan;
+                    if(plan.pitch.schematic.empty()) {
+                        auto chord = plan.root;
                         if(!conc.empty()) {
                             // TODO: Use *all* simultaneous chords instead of a random one.
                             chord =
@@ -301,68 +391,50 @@ namespace autoplay {
                         }
                         return pitchAccompanimentSchematic(
                             std::string("ABC").substr((unsigned long)Randomizer::pick_uniform(gen, 0, 3), 1), chord, 0,
-                            1, range, stave);
+                            1, plan.pitches);
                     } else {
-                        auto j     = pt.get<unsigned int>("j");
-                        auto mlen  = pt.get<unsigned int>("mlen");
-                        auto chord = pt.get<std::string>("_currchord", m_config.conf<std::string>("style.root", "C"));
-
-                        return pitchAccompanimentSchematic(schematic, chord, j, mlen, range, stave);
+                        auto chord = ctx.chord_name.empty() ? plan.root : ctx.chord_name;
+                        return pitchAccompanimentSchematic(plan.pitch.schematic, chord, ctx.tick, ctx.measure_length,
+                                                           plan.pitches);
                     }
                 };
             } else if(algo == "markov-chain") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    static std::shared_ptr<markov::MarkovChain> mc;
-                    if(!mc) {
-                        mc = std::make_shared<markov::MarkovChain>(pt.get<std::string>("pitch.chain"), gen);
-
-                        // Remove all states that cannot be reached in our algorithm
-                        auto stave = pt.get<int>("stave");
-                        auto range = staveRange(stave);
-                        auto p     = getPitches(range.first, range.second, stave);
-
-                        std::vector<std::string> non_erasables;
-                        for(const auto& v : p) {
-                            non_erasables.emplace_back(music::Note::pitchRepr(v));
-                        }
-
-                        mc->keep(non_erasables);
-                    }
-                    if(pt.get<bool>("_reinit", false)) {
+                              GenerationContext& ctx) -> uint8_t {
+                    auto mc = pitchChain(gen, ctx);
+                    if(ctx.reinit) {
                         mc->reset();
                     }
-                    markov::MarkovChain::State next = mc->next();
+                    const auto& next = mc->state(mc->next());
                     if(next == "rest") {
-                        pt.put("pitch._rest", true);
-                        next = "C-1";
+                        ctx.rest = true;
+                        return music::Note::pitch("C-1");
                     }
                     return music::Note::pitch(next);
                 };
             } else if(algo == "gaussian-voicing") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    auto stave = pt.get<int>("stave");
-                    auto range = staveRange(stave);
-                    auto p     = getPitches(range.first, range.second, stave);
-
-                    std::vector<float> p2;
-                    for(const auto& v : p) {
-                        p2.push_back((float)((int)v));
+                              GenerationContext& ctx) -> uint8_t {
+                    const auto& p = ctx.plan.pitches.pitches();
+                    if(ctx.pitch_weights.empty()) {
+                        std::vector<float> p2;
+                        for(const auto& v : p) {
+                            p2.push_back((float)((int)v));
+                        }
+                        ctx.pitch_weights = Randomizer::gaussian_table(p2, -3.0f, 3.0f, true);
                     }
-                    return (uint8_t)Randomizer::gaussian(gen, p2, -3.0f, 3.0f, true);
+                    auto idx = Randomizer::pick_cumulative(gen, ctx.pitch_weights);
+                    return idx < p.size() ? p.at(idx) : p.back();
                 };
             } else {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> uint8_t {
-                    auto stave = pt.get<int>("stave");
-                    return (uint8_t)Randomizer::pick_uniform(gen, getPitches(0, 128, stave));
+                              GenerationContext& ctx) -> uint8_t {
+                    return Randomizer::pick_uniform(gen, ctx.plan.pitches.pitches());
                 };
             }
         }
 
-        std::function<float(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt)>
-        Generator::getRhythmAlgorithm(std::string algo) const {
+        Generator::RhythmAlgorithm Generator::getRhythmAlgorithm(std::string algo) const {
             // Get algorithm variables
             if(algo.empty()) {
                 algo = m_config.conf<std::string>("generation.rhythm", "constant");
@@ -371,50 +443,40 @@ namespace autoplay {
             m_config.getLogger()->debug("Using Rhythm Algorithm '{}'", algo);
 
             if(algo == "random") {
-                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt) -> float {
-                    auto smallest =
-                        (int)std::log2(music::Note::DURATION.at(pt.get<std::string>("rhythm.smallest", "256th")));
-                    auto largest =
-                        (int)std::log2(music::Note::DURATION.at(pt.get<std::string>("rhythm.largest", "long")));
-                    smallest += 8;
-                    largest += 8;
-                    auto rh = (float)std::pow(2.0f, Randomizer::pick_uniform(gen, smallest, largest) - 8);
-                    return rh;
+                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                          GenerationContext& ctx) -> unsigned int {
+                    const auto& rhythm = ctx.plan.rhythm;
+                    return rhythm.ticks(Randomizer::pick_uniform(gen, rhythm.smallest + 8, rhythm.largest + 8) - 8);
                 };
             } else if(algo == "brownian-motion") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> float { return rhythmBrownianMotion(gen, prev, conc, pt); };
+                              GenerationContext& ctx) -> unsigned int {
+                    return rhythmBrownianMotion(gen, prev, conc, ctx);
+                };
             } else if(algo == "1/f-noise") {
                 return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> float { return rhythm1FNoise(gen, pt); };
+                              GenerationContext& ctx) -> unsigned int { return rhythm1FNoise(gen, ctx); };
             } else if(algo == "markov-chain") {
-                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt) -> float {
-                    static std::shared_ptr<markov::MarkovChain> mc;
+                return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                              GenerationContext& ctx) -> unsigned int {
+                    auto& mc = ctx.rhythm_chain;
                     if(!mc) {
-                        mc = std::make_shared<markov::MarkovChain>(pt.get<std::string>("rhythm.chain"), gen);
+                        mc = std::make_shared<markov::MarkovChain>(*model(ctx.plan.rhythm.chain), gen);
                     }
-                    if(pt.get<bool>("_reinit", false)) {
+                    if(ctx.reinit) {
                         mc->reset();
                     }
-                    markov::MarkovChain::State next = mc->next();
-                    return std::stof(next) / (4 * 64);
+                    // The chains are learned with 64 divisions
+                    const auto& next = mc->state(mc->next());
+                    return (unsigned int)(std::stof(next) * ctx.plan.rhythm.divisions / 64);
                 };
             } else {
-                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt) -> float {
-                    auto rh = pt.get<std::string>("rhythm.duration", "quarter");
-                    try {
-                        return music::Note::DURATION.at(rh);
-                    } catch(std::exception& e) { return 0.25f; }
-                };
+                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                          GenerationContext& ctx) -> unsigned int { return ctx.plan.rhythm.duration; };
             }
         }
 
-        bool is_number(const std::string& s) {
-            return !s.empty() && std::find_if(s.begin(), s.end(), [](char c) { return !std::isdigit(c); }) == s.end();
-        }
-
-        std::function<int(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt)>
-        Generator::getChordNoteCountAlgorithm(std::string algo) const {
+        Generator::ChordAlgorithm Generator::getChordNoteCountAlgorithm(std::string algo) const {
             // Get algorithm variables
             if(algo.empty()) {
                 algo = m_config.conf<std::string>("generation.chord", "constant");
@@ -423,83 +485,32 @@ namespace autoplay {
             m_config.getLogger()->debug("Using Chord Note Count Algorithm '{}'", algo);
 
             if(algo == "random") {
-                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt) -> int {
-                    auto min = pt.get<int>("chord.min", 1);
-                    auto max = pt.get<int>("chord.max", 1);
-                    return Randomizer::pick_uniform(gen, min, max + 1);
+                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                          GenerationContext& ctx) -> int {
+                    return Randomizer::pick_uniform(gen, ctx.plan.chord.min, ctx.plan.chord.max + 1);
                 };
             } else if(algo == "weighted") {
-                return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                              pt::ptree& pt) -> int {
-                    static std::map<int, float> mapping;
-                    if(pt.get<bool>("_reinit", false)) {
-                        mapping.clear();
-                    }
-                    if(mapping.empty()) {
-                        float sum = 0.0f;
-                        BOOST_FOREACH(const auto& var, pt.get_child("chord")) {
-                            if(is_number(var.first)) {
-                                auto s = var.second.get<float>("");
-                                sum += s;
-                                mapping.insert({std::stoi(var.first), s});
-                            }
-                        }
-
-                        int min = mapping.begin()->first;
-
-                        // Fix chances if required
-                        if(sum > 1.0f) { // Normalize
-                            m_logger->warn("Sum of all weighted elements exceeds 1! Normalizing the values...");
-                            for(auto& kv : mapping) {
-                                kv.second /= sum;
-                            }
-                            m_logger->warn("New values:");
-                            for(const auto& kv : mapping) {
-                                m_logger->warn("\t{} --> {}", kv.first, kv.second);
-                            }
-                        } else if(sum < 1.0f) {
-                            float one = 1.0f - sum;
-                            if(mapping.count(1) == 1) {
-                                one += mapping.at(1);
-                                m_logger->warn(
-                                    "Invalid sum of {}. Changing chance that a single note occurs from {} to {}.", sum,
-                                    mapping.at(1), one);
-                            }
-                            mapping[1] = one;
-                            if(min != 1) {
-                                for(int j = 2; j < min; ++j) {
-                                    mapping[j] = 0.0f;
-                                }
-                            }
-                        }
-                    }
-
-                    std::map<int, float> map_ref{mapping};
-
-                    std::function<float(const int&)> func = [&map_ref](const int& val) -> float {
-                        if(map_ref.count(val) == 1) {
-                            return map_ref.at(val);
-                        }
-                        return 0.0f;
-                    };
-                    return Randomizer::pick_weighted(gen, mapping.begin()->first, mapping.rbegin()->first + 1, 1, func);
+                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                          GenerationContext& ctx) -> int {
+                    const auto& chord = ctx.plan.chord;
+                    return chord.amounts.at(chord.sampler.sample(gen));
                 };
             } else if(algo == "markov-chain") {
-                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt) -> int {
-                    static std::shared_ptr<markov::MarkovChain> mc;
+                return [this](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                              GenerationContext& ctx) -> int {
+                    auto& mc = ctx.chord_chain;
                     if(!mc) {
-                        mc = std::make_shared<markov::MarkovChain>(pt.get<std::string>("chord.chain"), gen);
+                        mc = std::make_shared<markov::MarkovChain>(*model(ctx.plan.chord.chain), gen);
                     }
-                    if(pt.get<bool>("_reinit", false)) {
+                    if(ctx.reinit) {
                         mc->reset();
                     }
-                    markov::MarkovChain::State next = mc->next();
+                    const auto& next = mc->state(mc->next());
                     return std::stoi(next);
                 };
             } else {
-                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt) -> int {
-                    return pt.get<int>("chord.amount", 1);
-                };
+                return [](RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                          GenerationContext& ctx) -> int { return ctx.plan.chord.amount; };
             }
         }
 
@@ -576,10 +587,24 @@ namespace autoplay {
             return clef.range();
         }
 
-        uint8_t Generator::remapPitch(uint8_t pitch, const std::string& to, const std::pair<uint8_t, uint8_t>& range) {
-            auto picked = Randomizer::pick_uniform<float>(m_rnengine, 0.0f, 1.0f);
+        std::shared_ptr<markov::MarkovChain> Generator::pitchChain(RNEngine& gen, GenerationContext& ctx) const {
+            auto& mc = ctx.pitch_chain;
+            if(!mc) {
+                // Only go to the states that can be reached in our algorithm
+                std::vector<std::string> non_erasables;
+                for(const auto& v : ctx.plan.pitches.pitches()) {
+                    non_erasables.emplace_back(music::Note::pitchRepr(v));
+                }
+                mc = std::make_shared<markov::MarkovChain>(*model(ctx.plan.pitch.chain, non_erasables), gen);
+            }
+            return mc;
+        }
 
-            if(picked <= m_config.conf<float>("style.chance")) {
+        uint8_t Generator::remapPitch(RNEngine& gen, uint8_t pitch, const std::string& to,
+                                      const std::pair<uint8_t, uint8_t>& range, float chance) const {
+            auto picked = Randomizer::pick_uniform<float>(gen, 0.0f, 1.0f);
+
+            if(picked <= chance) {
                 music::Note::Semitone s;
 
                 auto r = music::Note::pitchRepr(pitch);
@@ -610,30 +635,29 @@ namespace autoplay {
         }
 
         uint8_t Generator::pitchBrownianMotion(autoplay::util::RNEngine& gen, autoplay::music::Chord* prev,
-                                               std::vector<autoplay::music::Chord*>& conc, const pt::ptree& pt) const {
-            auto stave = pt.get<int>("stave", 0);
-            auto range = staveRange(stave);
-
-            auto pitches = getPitches(range.first, range.second, stave);
+                                               std::vector<autoplay::music::Chord*>& conc,
+                                               const GenerationContext& ctx) const {
+            const auto& table   = ctx.plan.pitches;
+            const auto& pitches = table.pitches();
 
             if(prev) {
                 uint8_t pitch = prev->getNotes()
                                     .at((unsigned long)Randomizer::pick_uniform(gen, 0, (int)prev->getNotes().size()))
                                     ->getPitch();
-                auto it = std::find(pitches.begin(), pitches.end(), pitch);
+                long idx = table.index(pitch);
 
                 /// Don't test if the pitch is out of range!
                 /// It shouldn't be, but the chord does not take the pitches into a count.
                 // TODO: chord algorithm should take pitches into a count.
                 //  -> Should be solved by default!
 
-                // if(it == pitches.end()) {
-                //     throw std::invalid_argument("Note '" + std::to_string(pitch) + "' not in scale!");
-                // }
+                // An unknown pitch is treated as if it was one past the highest pitch
+                if(idx == -1) {
+                    idx = (long)pitches.size();
+                }
 
-                auto idx = std::distance(pitches.begin(), it);
-                auto min = pt.get<long>("pitch.min", -3);
-                auto max = pt.get<long>("pitch.max", 3);
+                auto min = ctx.plan.pitch.min;
+                auto max = ctx.plan.pitch.max;
                 if(idx + min < 0) {
                     min = -idx;
                 }
@@ -649,31 +673,28 @@ namespace autoplay {
             }
         }
 
-        uint8_t Generator::pitch1FNoise(autoplay::util::RNEngine& gen, const pt::ptree& pt) const {
+        uint8_t Generator::pitch1FNoise(autoplay::util::RNEngine& gen, GenerationContext& ctx) const {
             // Constants through function
             uint8_t num_dice   = 3;
             auto    num_states = (uint8_t)std::pow((int)2, (int)num_dice);
 
-            auto stave = pt.get<int>("stave", 0);
-            auto range = staveRange(stave);
-
-            auto pitches = getPitches(range.first, range.second, stave);
+            const auto& pitches = ctx.plan.pitches.pitches();
 
             // (Re)init table
-            static uint8_t state = 0;
-            static std::vector<std::pair<uint8_t, uint8_t>> dice{num_dice, {0, 0}};
+            auto& state = ctx.pitch_noise.state;
+            auto& dice  = ctx.pitch_noise.dice;
 
-            if(pt.get<bool>("_reinit", false)) {
+            if(ctx.reinit) {
                 state = 0;
                 dice.assign(num_dice, {0, 0});
 
                 // Fill dice_ranges uniformly
-                auto all = (uint8_t)((int)(pitches.size() - 1) / num_dice);
+                auto all = (int)(pitches.size() - 1) / num_dice;
                 for(auto& die : dice) {
                     die.second = all;
                 }
-                all = (uint8_t)((pitches.size() - 1) - (all * num_dice));
-                for(unsigned int i = 0; i < all; ++i) {
+                all = (int)(pitches.size() - 1) - (all * num_dice);
+                for(unsigned int i = 0; i < (unsigned)all; ++i) {
                     dice.at(i % num_dice).second += 1;
                 }
             }
@@ -682,12 +703,12 @@ namespace autoplay {
             unsigned int sum = 0;
             for(unsigned int i = 0; i < dice.size(); ++i) {
                 if(state == 0) {
-                    dice.at(i).first = (uint8_t)Randomizer::pick_uniform(gen, 0, dice.at(i).second + 1);
+                    dice.at(i).first = Randomizer::pick_uniform(gen, 0, dice.at(i).second + 1);
                     sum += dice.at(i).first;
                 } else {
                     std::bitset<16> bs{(unsigned long long)((state - 1) ^ state)};
                     if(bs.test(i)) {
-                        dice.at(i).first = (uint8_t)Randomizer::pick_uniform(gen, 0, dice.at(i).second + 1);
+                        dice.at(i).first = Randomizer::pick_uniform(gen, 0, dice.at(i).second + 1);
                         sum += dice.at(i).first;
                     }
                 }
@@ -700,52 +721,26 @@ namespace autoplay {
 
         uint8_t Generator::pitchAccompanimentSchematic(const std::string& schematic, std::string chordname,
                                                        unsigned int timestep, unsigned int measure_length,
-                                                       const std::pair<uint8_t, uint8_t>& range, int stave) const {
+                                                       const PitchTable& pitches) const {
             bool minor = false;
             if(chordname.at(chordname.length() - 1) == 'm') {
                 minor     = true;
                 chordname = chordname.substr(0, chordname.length() - 1);
             }
 
-            // Check the length of the schematic
-            auto  sl = (unsigned int)schematic.length();
-            float sm = std::log2((float)sl);
-            if(std::floor(sm) - sm < 0.0f) {
-                throw std::invalid_argument(
-                    "The schematic for the accompaniment has an invalid length. A power of 2 was expected, " +
-                    std::to_string(sl) + " was obtained.");
-            }
-
             // Find the separation/group point of each new "note"
+            // (the length of the schematic has been validated by the GenerationPlan)
+            auto         sl    = (unsigned int)schematic.length();
             unsigned int group = measure_length / sl;
             timestep %= measure_length;
             auto idx = (unsigned int)std::floor((float)timestep / group);
 
-            auto pitches = getPitches(range.first, range.second, stave);
-
-            uint8_t min   = pitches.at(0);
-            bool    found = false;
-            for(const auto& p : pitches) {
-                music::Note::Semitone s;
-
-                std::string repr;
-                repr += music::Note::splitPitch(music::Note::pitchRepr(p), s).first;
-                if(s == music::Note::Semitone::SHARP) {
-                    repr += '#';
-                } else if(s == music::Note::Semitone::FLAT) {
-                    repr += 'b';
-                }
-
-                // Cast to a pitch in the first octave to check comparison between flats and sharps
-                if(music::Note::pitch(repr + std::to_string(1)) == music::Note::pitch(chordname + std::to_string(1))) {
-                    min   = p;
-                    found = true;
-                    break;
-                }
-            }
-            if(!found) {
+            // Find the lowest pitch of the chord (flats and sharps share a pitch class)
+            auto lowest = pitches.lowest((uint8_t)(music::Note::pitch(chordname + std::to_string(1)) % 12));
+            if(lowest == -1) {
                 throw std::invalid_argument("Impossible to find the chord " + chordname + " in the range.");
             }
+            uint8_t min = pitches.at((unsigned)lowest);
 
             char    letter = schematic.at(idx);
             uint8_t nxt    = min;
@@ -758,7 +753,7 @@ namespace autoplay {
                 } else {
                     nxt += (uint8_t)4;
                 }
-                if(std::find(pitches.begin(), pitches.end(), nxt) == pitches.end()) {
+                if(!pitches.contains(nxt)) {
                     std::string err =
                         "The letter 'B' in the schematic falls outside of the possibilities. Returning as 'A' in '";
                     err += chordname;
@@ -773,7 +768,7 @@ namespace autoplay {
 
             case 'C':
                 nxt += (uint8_t)7;
-                if(std::find(pitches.begin(), pitches.end(), nxt) == pitches.end()) {
+                if(!pitches.contains(nxt)) {
                     std::string err =
                         "The letter 'C' in the schematic falls outside of the possibilities. Returning as 'A' in '";
                     err += chordname;
@@ -792,18 +787,17 @@ namespace autoplay {
             }
         }
 
-        float Generator::rhythmBrownianMotion(autoplay::util::RNEngine& gen, autoplay::music::Chord* prev,
-                                              std::vector<autoplay::music::Chord*>& conc, const pt::ptree& pt) const {
-            auto divisions = pt.get<unsigned int>("rhythm._divs");
-            auto smallest  = (int)std::log2(music::Note::DURATION.at(pt.get<std::string>("rhythm.smallest", "256th")));
-            auto largest   = (int)std::log2(music::Note::DURATION.at(pt.get<std::string>("rhythm.largest", "long")));
-            smallest += 8;
-            largest += 8;
+        unsigned int Generator::rhythmBrownianMotion(autoplay::util::RNEngine& gen, autoplay::music::Chord* prev,
+                                                     std::vector<autoplay::music::Chord*>& conc,
+                                                     const GenerationContext& ctx) const {
+            const auto& rhythm   = ctx.plan.rhythm;
+            auto        smallest = rhythm.smallest + 8;
+            auto        largest  = rhythm.largest + 8;
             if(prev) {
-                float prev_type = (float)prev->getDuration() / (4.0f * divisions);
+                float prev_type = (float)prev->getDuration() / (4.0f * rhythm.divisions);
                 auto  prev_n    = (int)(std::log2(prev_type) + 8);
-                auto  min       = pt.get<int>("rhythm.min", -3);
-                auto  max       = pt.get<int>("rhythm.max", 3);
+                auto  min       = rhythm.min;
+                auto  max       = rhythm.max;
                 if(prev_n + min < smallest) {
                     min = prev_n - smallest;
                 }
@@ -812,25 +806,25 @@ namespace autoplay {
                 } else if(prev_n + max < smallest) {
                     max = prev_n - smallest;
                 }
-                return (float)std::pow(2.0f, Randomizer::pick_uniform(gen, prev_n + min, prev_n + max) - 8);
+                return rhythm.ticks(Randomizer::pick_uniform(gen, prev_n + min, prev_n + max) - 8);
             } else {
-                return (float)std::pow(2.0f, Randomizer::pick_uniform(gen, smallest, largest) - 8);
+                return rhythm.ticks(Randomizer::pick_uniform(gen, smallest, largest) - 8);
             }
         }
 
-        float Generator::rhythm1FNoise(autoplay::util::RNEngine& gen, const pt::ptree& pt) const {
+        unsigned int Generator::rhythm1FNoise(autoplay::util::RNEngine& gen, GenerationContext& ctx) const {
             // Constants through function
             uint8_t num_dice   = 3;
             auto    num_states = (uint8_t)std::pow((int)2, (int)num_dice);
 
-            auto smallest = (int)std::log2(music::Note::DURATION.at(pt.get<std::string>("rhythm.smallest", "256th")));
-            auto largest  = (int)std::log2(music::Note::DURATION.at(pt.get<std::string>("rhythm.largest", "long")));
+            auto smallest = ctx.plan.rhythm.smallest;
+            auto largest  = ctx.plan.rhythm.largest;
 
             // (Re)init table
-            static uint8_t state = 0;
-            static std::vector<std::pair<int, int>> dice{num_dice, {0, 0}};
+            auto& state = ctx.rhythm_noise.state;
+            auto& dice  = ctx.rhythm_noise.dice;
 
-            if(pt.get<bool>("_reinit", false)) {
+            if(ctx.reinit) {
                 state = 0;
                 dice.assign(num_dice, {0, 0});
 
@@ -862,8 +856,7 @@ namespace autoplay {
 
             state = (uint8_t)((state + 1) % num_states);
 
-            auto r = (float)std::pow(2.0f, smallest + sum);
-            return r;
+            return ctx.plan.rhythm.ticks(smallest + sum);
         }
     }
 }
\ No newline at end of file
@@ -18,18 +18,56 @@
 #ifndef AUTOPLAY_GENERATOR_H
 #define AUTOPLAY_GENERATOR_H
 
+#include "../markov/NamedMatrix.h"
 #include "../music/Score.h"
 #include "Config.h"
+#include "GenerationPlan.h"
 #include "Randomizer.h"
 
+#include <functional>
+#include <map>
+#include <memory>
+
 namespace autoplay {
     namespace util {
+        class PartGenerator;
+
         /**
          * The Generator class is the class that handles all generation of random music.
          */
         class Generator
         {
         public:
+            /// The signature of a pitch algorithm
+            using PitchAlgorithm = std::function<uint8_t(RNEngine& gen, music::Chord* prev,
+                                                         std::vector<music::Chord*>& conc, GenerationContext& ctx)>;
+
+            /// The signature of a rhythm algorithm, which returns a duration in ticks
+            using RhythmAlgorithm = std::function<unsigned int(RNEngine& gen, music::Chord* prev,
+                                                               std::vector<music::Chord*>& conc, GenerationContext& ctx)>;
+
+            /// The signature of a chord note count algorithm
+            using ChordAlgorithm = std::function<int(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                                                     GenerationContext& ctx)>;
+
+            /**
+             * The summary of a single job of a batch.
+             */
+            struct BatchResult {
+                unsigned long seed;    ///< The seed of the job
+                double        seconds; ///< The time it took to generate (and output) the Score
+                std::size_t   chords;  ///< The amount of Chords in the Score
+                std::string   error;   ///< The error message if the job failed, empty otherwise
+            };
+
+            /// The signature of a function that handles a Score of a batch (e.g. to export it)
+            using BatchSink = std::function<void(unsigned long seed, const music::Score& score)>;
+
+            /// The signature of a function that handles the next Measure of each Part, while a Score is streamed. The
+            /// Score contains the Parts (without Measures) and the Measures are given in the same order.
+            using MeasureSink = std::function<void(const music::Score& score, unsigned int index,
+                                                   const music::MeasureList& measures)>;
+
             /**
              * Default Constructor
              * @param config    The Config that has been initialized with the system
@@ -40,35 +78,145 @@ namespace autoplay {
             /**
              * Generates a random Score
              * @return The randomized score
+             *
+             * @note Parts that do not depend on one another are generated in parallel, on the amount of threads
+             *       given by the 'threads' config value (0 means all hardware threads). Each Part uses its own
+             *       substream of the seeded engine (see RNEngine::substream), so the result does not depend on the
+             *       amount of threads.
              */
             music::Score generate();
 
+            /**
+             * Generates a random Score one Measure at a time. All Parts are generated in lockstep and as soon as each
+             * Part has crossed a barline, the Measures before it are given to the sink and forgotten. This way, the
+             * memory that is used does not depend on the length of the Score.
+             * @param seed  The seed to generate the Score with.
+             * @param sink  The function that is called with the Measures of each Part, in order.
+             *
+             * @note The Measures are the same as the ones generate() would return for the same seed.
+             */
+            void stream(unsigned long seed, const MeasureSink& sink) const;
+
+            /**
+             * Generates a random Score for a specific seed. This function does not change the Generator, so it can
+             * be called from multiple threads at the same time.
+             * @param seed      The seed to generate the Score with.
+             * @param threads   The amount of threads to generate the Parts on. When 0, all hardware threads are used.
+             * @return The randomized score
+             */
+            music::Score generate(unsigned long seed, unsigned int threads) const;
+
+            /**
+             * Generates a random Score for each seed, in parallel. The Config and all Markov Chains are shared
+             * between the jobs.
+             * @param seeds     The seeds to generate a Score for.
+             * @param sink      The function that is called (from a worker thread) with each generated Score. It
+             *                  must be safe to call this function concurrently.
+             * @param threads   The amount of jobs that run at the same time. When 0, all hardware threads are used.
+             * @return A summary of each job, in the order of the seeds.
+             *
+             * @note Each job is generate(seed, 1), so its Markov Chains are advanced one by one (markov::ChainBatch is
+             *       not used) and each Score is the same as when it is generated on its own.
+             */
+            std::vector<BatchResult> batch(const std::vector<unsigned long>& seeds, const BatchSink& sink,
+                                           unsigned int threads = 0) const;
+
+            /**
+             * Find the Parts each Part of the Config depends on; i.e. the Parts that must have been generated before
+             * it can be generated.
+             * @return For each Part, the (sorted) indices of the Parts it depends on.
+             */
+            std::vector<std::vector<unsigned int>> dependencies() const;
+
+            /**
+             * Set up the generation of all Parts of a Score, to generate them one Measure at a time (see stream()).
+             * @param seed      The seed to generate the Score with.
+             * @param score     The Score to add the (empty) Parts to.
+             * @param contexts  The vector to store the contexts of all Parts in.
+             * @return A PartGenerator for each Part, in order.
+             */
+            std::vector<PartGenerator> start(unsigned long seed, music::Score& score,
+                                             std::vector<GenerationContext>& contexts) const;
+
         public:
+            /**
+             * Generate a new pitch according to its chance of occurring and map it to a certain Chord name
+             * @param gen       The generator object.
+             * @param pitch     The pitch to change
+             * @param to        The letter of the Chord to change the pitch to; e.g. C, A#...
+             * @param range     The range to comply with the remapping.
+             * @param chance    The chance that the pitch is remapped (see GenerationPlan::chance).
+             * @return A new pitch to map.
+             */
+            uint8_t remapPitch(RNEngine& gen, uint8_t pitch, const std::string& to,
+                               const std::pair<uint8_t, uint8_t>& range, float chance) const;
+
             /**
              * Get the randomization algorithm for the pitch
              * @param algo  If not empty, it will use this algorithm to check, instead of the generation.pitch value
              * @return A lambda function that implements the algorithm
              */
-            std::function<uint8_t(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt)>
-            getPitchAlgorithm(std::string algo = "") const;
+            PitchAlgorithm getPitchAlgorithm(std::string algo = "") const;
+
+            /**
+             * Get the Markov Chain of the pitch algorithm of a Part, and create it when the Part does not have one
+             * yet. The chain can only go to the pitches of the plan.
+             * @param gen   The generator object, of which the chain gets a copy.
+             * @param ctx   The context of the Part, that holds the chain.
+             * @return The chain of the Part.
+             */
+            std::shared_ptr<markov::MarkovChain> pitchChain(RNEngine& gen, GenerationContext& ctx) const;
 
             /**
              * Get the randomization algorithm for the rhythm
              * @param algo  If not empty, it will use this algorithm to check, instead of the generation.rhythm value
              * @return A lambda function that implements the algorithm
              */
-            std::function<float(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt)>
-            getRhythmAlgorithm(std::string algo = "") const;
+            RhythmAlgorithm getRhythmAlgorithm(std::string algo = "") const;
 
             /**
              * Get the randomization algorithm for the Chord Note count
              * @param algo  If not empty, it will use this algorithm to check, instead of the generation.chord value
              * @return A lambda function that implements the algorithm
              */
-            std::function<int(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc, pt::ptree& pt)>
-            getChordNoteCountAlgorithm(std::string algo = "") const;
+            ChordAlgorithm getChordNoteCountAlgorithm(std::string algo = "") const;
 
         private:
+            /**
+             * Resolve the GenerationPlan of a Part.
+             * @param stave     The index of the Part.
+             * @param pt_part   The config of the Part, with its 'generation' merged with the global one.
+             * @param divisions The amount of ticks a quarter note takes.
+             * @return The GenerationPlan of the Part.
+             */
+            GenerationPlan plan(unsigned int stave, const pt::ptree& pt_part, unsigned int divisions) const;
+
+            /**
+             * Resolve the plans of all Parts of the Config.
+             * @param contexts  The vector to store the contexts of all Parts in.
+             * @param pt_parts  The vector to store the config of all Parts in, with their 'generation' merged with the
+             *                  global one.
+             */
+            void plans(std::vector<GenerationContext>& contexts, std::vector<pt::ptree>& pt_parts) const;
+
+            /**
+             * Find the Parts each Part depends on; i.e. the Parts that must have been generated before it can be
+             * generated.
+             * @param contexts  The contexts of all Parts, in order.
+             * @return For each Part, the (sorted) indices of the Parts it depends on.
+             */
+            static std::vector<std::vector<unsigned int>> dependencies(const std::vector<GenerationContext>& contexts);
+
+            /**
+             * Get the model of a Markov Chain from the ModelRegistry. Each file is only loaded once and then shared
+             * by all Generators; a chain for a Part is created from it with its own random engine.
+             * @param filename  The CSV file or binary model of the Markov Chain.
+             * @param keep      When not empty, the model is restricted to these States.
+             * @return The chain that holds the model.
+             */
+            std::shared_ptr<const markov::MarkovChain> model(const std::string&              filename,
+                                                             const std::vector<std::string>& keep = {}) const;
+
             /**
              * Get all the possible pitches within a range, according to the given scale.
              * @param min   The lowest possible pitch to find. When it is not part of the scale, it will take the first
@@ -86,15 +234,6 @@ namespace autoplay {
              */
             std::pair<uint8_t, uint8_t> staveRange(int stave) const;
 
-            /**
-             * Generate a new pitch according to its chance of occurring and map it to a certain Chord name
-             * @param pitch The pitch to change
-             * @param to    The letter of the Chord to change the pitch to; e.g. C, A#...
-             * @param range The range to comply with the remapping.
-             * @return A new pitch to map.
-             */
-            uint8_t remapPitch(uint8_t pitch, const std::string& to, const std::pair<uint8_t, uint8_t>& range);
-
         private:
             /**
              * A pitch generation algorithm, based upon the movements of small particles that are randomly bombarded by
@@ -102,23 +241,21 @@ namespace autoplay {
              * @param gen   The generator object.
              * @param prev  The previous note that is played
              * @param conc  A vector of all concurrent notes that are being played
-             * @param pt    A ptree with additional options. This algorithm expects pitch.min and pitch.max to be set
-             *              in this ptree. When missing, -3 and 3 will be chosen respectively. 'stave' is the stave
-             * index.
+             * @param ctx   The context of the Part. This algorithm uses the pitch.min and pitch.max steps of the plan.
              * @return A new pitch.
              */
             uint8_t pitchBrownianMotion(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                                        const pt::ptree& pt) const;
+                                        const GenerationContext& ctx) const;
 
             /**
              * A pitch generation algorithm, based upon the 1/f relationship, occuring in the strangest places of
              * nature.
              * @param gen       The generator object.
-             * @param pt        A ptree with additional options. 'stave' is the stave index. "_reinit" must be
-             *                  set to (re)initialize the algorithm.
+             * @param ctx       The context of the Part. The algorithm is (re)initialized when ctx.reinit is set and
+             *                  keeps its dice in ctx.pitch_noise.
              * @return A new pitch.
              */
-            uint8_t pitch1FNoise(RNEngine& gen, const pt::ptree& pt) const;
+            uint8_t pitch1FNoise(RNEngine& gen, GenerationContext& ctx) const;
 
             /**
              * A pitch generation algorithm that tries to generate a good-sounding accompaniment of the played music.
@@ -127,13 +264,12 @@ namespace autoplay {
              *                          progression.
              * @param timestep          The moment when the Chord needs to be played.
              * @param measure_length    The duration of a current measure.
-             * @param range             The range in which the notes must be played.
-             * @param stave             The stave for which the rotes must be played.
+             * @param pitches           The pitches of the stave for which the notes must be played.
              * @return  The new pitch to be played.
              */
             uint8_t pitchAccompanimentSchematic(const std::string& schematic, std::string chordname,
                                                 unsigned int timestep, unsigned int measure_length,
-                                                const std::pair<uint8_t, uint8_t>& range, int stave) const;
+                                                const PitchTable& pitches) const;
 
             /**
              * A rhythm generation algorithm, based upon the movements of small particles that are randomly bombarded by
@@ -141,27 +277,26 @@ namespace autoplay {
              * @param gen   The generator object.
              * @param prev  The previous note that is played
              * @param conc  A vector of all concurrent notes that are being played
-             * @param pt    A ptree with additional options. This algorithm expects rhythm.min and rhythm.max to be set
-             *              in this ptree. When missing, -3 and 3 will be chosen respectively.
-             * index.
-             * @return A new rhythm.
+             * @param ctx   The context of the Part. This algorithm uses the rhythm.min and rhythm.max steps of the plan.
+             * @return A new duration in ticks.
              */
-            float rhythmBrownianMotion(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
-                                       const pt::ptree& pt) const;
+            unsigned int rhythmBrownianMotion(RNEngine& gen, music::Chord* prev, std::vector<music::Chord*>& conc,
+                                              const GenerationContext& ctx) const;
 
             /**
              * A rhythm generation algorithm, based upon the 1/f relationship, occuring in the strangest places of
              * nature.
              * @param gen       The generator object.
-             * @param pt        A ptree with additional options. 'stave' is the stave index. "_reinit" must be
-             *                  set to (re)initialize the algorithm.
-             * @return A new rhythm.
+             * @param ctx       The context of the Part. The algorithm is (re)initialized when ctx.reinit is set and
+             *                  keeps its dice in ctx.rhythm_noise.
+             * @return A new duration in ticks.
              */
-            float rhythm1FNoise(RNEngine& gen, const pt::ptree& pt) const;
+            unsigned int rhythm1FNoise(RNEngine& gen, GenerationContext& ctx) const;
 
         private:
             Config             m_config;   ///< The Config of the system
             RNEngine           m_rnengine; ///< The Random Engine
+            unsigned long      m_seed;     ///< The seed of the Random Engine
             zz::log::LoggerPtr m_logger;   ///< The Logger Object
         };
     }
@@ -0,0 +1,346 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "PartGenerator.h"
+#include "../markov/MarkovChain.h"
+#include "Randomizer.h"
+
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <iterator>
+
+namespace autoplay {
+    namespace util {
+        PartGenerator::PartGenerator(const Generator& generator, const Config& config, GenerationContext ctx,
+                                     const pt::ptree& pt_part, const RNEngine& gen)
+            : m_generator(generator), m_config(config), m_ctx(std::move(ctx)), m_gen(gen), m_observed(false),
+              m_clef(music::Clef::Treble()), m_pending(), m_tick(0), m_prev(), m_window(), m_ready(), m_slots(),
+              m_instruments(), m_repr_to_head(), m_repr_to_inst() {
+            const auto& plan = m_ctx.plan;
+
+            m_pitch_algo  = generator.getPitchAlgorithm(plan.pitch.algorithm);
+            m_rhythm_algo = generator.getRhythmAlgorithm(plan.rhythm.algorithm);
+            m_chord_algo  = generator.getChordNoteCountAlgorithm(plan.chord.algorithm);
+            m_uses_conc   = plan.pitch.algorithm == "accompaniment" && plan.pitch.schematic.empty();
+
+            // Set Instrument(s)
+            if(pt_part.count("instrument") == 0) {
+                m_percussion = false;
+                BOOST_FOREACH(auto& inst, pt_part.get_child("instruments")) {
+                    auto instrument = m_config.getInstrument(inst.second.get<std::string>("instrument"));
+                    instrument->setChannel(10);
+                    m_instruments.emplace_back(instrument);
+
+                    auto display = inst.second.get<std::string>("display", "C4");
+                    m_repr_to_head.insert(std::make_pair(display, inst.second.get<std::string>("symbol", "normal")));
+                    m_repr_to_inst.insert(std::make_pair(display, instrument));
+                }
+            } else {
+                auto instrument = m_config.getInstrument(pt_part.get<std::string>("instrument"));
+                m_percussion    = instrument->isPercussion();
+                instrument->setChannel((uint8_t)(plan.stave + 1));
+                if(m_percussion) {
+                    instrument->setChannel(10);
+
+                    auto display = pt_part.get<std::string>("display", "C4");
+                    m_repr_to_head.insert(std::make_pair(display, pt_part.get<std::string>("symbol", "normal")));
+                    m_repr_to_inst.insert(std::make_pair(display, instrument));
+                }
+                m_instruments.emplace_back(instrument);
+            }
+            m_mapped      = pt_part.count("instrument") == 0 || m_percussion;
+            m_constrained = plan.pitch.constrained;
+
+            if(m_percussion) {
+                m_clef.setPercussion(true);
+            } else {
+                m_clef = music::Clef{(unsigned char)pt_part.get<char>("clef.sign", 'G'),
+                                     (uint8_t)pt_part.get<int>("clef.line", 2),
+                                     pt_part.get<int>("clef.octave-change", 0)};
+            }
+            m_fifths  = m_config.conf<int>("style.fifths");
+            m_bpm     = m_config.conf<int>("style.bpm", 80);
+            m_pending = music::Measure{m_clef, plan.time, (int)plan.rhythm.divisions, m_fifths};
+            m_pending.setBPM(m_bpm);
+
+            m_name  = pt_part.get<std::string>("name", "");
+            m_lines = (uint8_t)pt_part.get<int>("lines", 5);
+
+            m_mlen               = m_pending.max_length();
+            m_end                = plan.length * m_mlen;
+            m_ctx.measure_length = m_mlen;
+        }
+
+        std::shared_ptr<music::Part> PartGenerator::part() const {
+            auto part = std::make_shared<music::Part>(m_instruments);
+            part->setLines(m_lines);
+            part->setInstrumentName(m_name);
+            return part;
+        }
+
+        std::shared_ptr<music::Measure> PartGenerator::next(const Concurrent& conc) {
+            while(m_ready.empty() && m_tick < m_end) {
+                step(conc);
+            }
+            if(m_ready.empty()) {
+                return nullptr;
+            }
+            auto measure = m_ready.front();
+            m_ready.pop_front();
+            return measure;
+        }
+
+        music::Chord* PartGenerator::at(unsigned int tick) {
+            auto it = std::lower_bound(m_window.begin(), m_window.end(), tick,
+                                       [](const Entry& e, unsigned int t) { return e.end < t; });
+            if(it == m_window.end()) {
+                return nullptr;
+            }
+            return &it->chord;
+        }
+
+        void PartGenerator::forget(unsigned int tick) {
+            while(!m_window.empty() && m_window.front().end < tick) {
+                m_window.pop_front();
+            }
+        }
+
+        void PartGenerator::step(const Concurrent& conc) {
+            const auto&  chord_progression = m_ctx.plan.chord_progression;
+            unsigned int j                 = m_tick;
+
+            // Only look at the other Parts when this Part depends on them
+            std::vector<music::Chord*> concurrent = {};
+            if(m_uses_conc && conc) {
+                concurrent = conc(j);
+            }
+
+            unsigned int duration;
+            int          num_notes;
+            bool         fixed = false;
+            if(m_constrained) {
+                if(m_slots.empty()) {
+                    plan();
+                }
+                duration  = m_slots.front().duration;
+                num_notes = m_slots.front().notes;
+                fixed     = m_slots.front().fixed;
+                m_slots.pop_front();
+            } else {
+                // Set Rhythm
+                duration = m_rhythm_algo(m_gen, m_prev.get(), concurrent, m_ctx);
+
+                // Prevent overflowing over final measure
+                if(j + duration > m_end) {
+                    duration = m_end - j;
+                }
+
+                // Ability to do chords
+                num_notes = m_chord_algo(m_gen, m_prev.get(), concurrent, m_ctx);
+            }
+
+            music::Chord chord;
+            if(!chord_progression.empty()) {
+                m_ctx.chord_name = chord_progression.at((j / m_mlen) % chord_progression.size());
+            }
+            m_ctx.tick = j;
+            for(int nn = 0; nn < num_notes; ++nn) {
+                uint8_t pitch;
+                if(m_constrained) {
+                    // The planned chain already goes to the roots; it only has to avoid the pitches of the Chord
+                    auto&                                chain = m_ctx.pitch_chain;
+                    std::vector<markov::MarkovChain::Id> avoid;
+                    for(const auto& note : chord.getNotes()) {
+                        avoid.emplace_back(chain->table().find(music::Note::pitchRepr(note->getPitch())));
+                    }
+                    const auto& next = chain->state(chain->next(avoid));
+                    if(next == "rest") {
+                        m_ctx.rest = true;
+                        pitch      = music::Note::pitch("C-1");
+                    } else {
+                        pitch = music::Note::pitch(next);
+                    }
+                } else {
+                    pitch = m_pitch_algo(m_gen, m_prev.get(), concurrent, m_ctx);
+                }
+
+                // Remap the percussion depending on the chord progression
+                if(!m_constrained && !m_percussion && !chord_progression.empty() && j % m_mlen == 0) {
+                    std::string value = chord_progression.at((j / m_mlen) % chord_progression.size());
+                    if(value.at(value.length() - 1) == 'm') {
+                        value = value.substr(0, value.length() - 1);
+                    }
+                    pitch = m_generator.remapPitch(m_gen, pitch, value, m_clef.range(), m_ctx.plan.chance);
+                }
+
+                if(chord.in(pitch)) {
+                    // --nn; ///< Infinite loop possible!
+                    continue;
+                }
+
+                music::Note note{pitch, duration};
+
+                if(m_ctx.rest) {
+                    note.toPause();
+                    m_ctx.rest = false;
+                }
+
+                auto prepr = music::Note::pitchRepr(pitch);
+                if(m_mapped) {
+                    note.setHead(m_repr_to_head.at(prepr));
+                    note.setInstrument(m_repr_to_inst.at(prepr));
+                }
+
+                chord.append(note);
+            }
+
+            // Generate random rests, except for Chords that will be tied over a barline
+            auto rests = m_ctx.plan.rest_ratio;
+            if(rests > 0.0f && !fixed && !chord.empty() && j % m_mlen + duration <= m_mlen) {
+                if(Randomizer::pick_uniform<float>(m_gen, 0.0f, 1.0f) < rests) {
+                    chord.toPause();
+                }
+            }
+
+            m_prev = std::make_shared<music::Chord>(chord);
+            if(m_observed) {
+                m_window.push_back({j + duration, chord});
+            }
+
+            m_pending.append(chord);
+            m_tick += duration;
+
+            m_ctx.reinit = false;
+
+            if(m_pending.length() >= m_mlen || m_tick >= m_end) {
+                cut();
+            }
+
+            // Change the last Note to the root note with a chance of style.chance
+            if(m_tick >= m_end && !m_constrained && !m_percussion && !m_ready.empty()) {
+                auto bottom = m_ready.back()->back().bottom();
+                if(!bottom->getTieEnd()) {
+                    auto c = bottom->getPitch();
+                    bottom->setPitch(
+                        m_generator.remapPitch(m_gen, c, m_ctx.plan.root, m_clef.range(), m_ctx.plan.chance));
+                }
+            }
+        }
+
+        void PartGenerator::plan() {
+            const auto& chord_progression = m_ctx.plan.chord_progression;
+            const auto  chance            = m_ctx.plan.chance;
+            auto        chain             = m_generator.pitchChain(m_gen, m_ctx);
+            if(m_ctx.reinit) {
+                chain->reset();
+            }
+
+            // The rhythm algorithms only look at the duration of the previous Chord, and never at the other Parts
+            std::vector<music::Chord*>            concurrent = {};
+            std::vector<std::vector<std::string>> allowed;
+            auto                                  prev = m_prev;
+            unsigned int                          j    = m_tick;
+            while(true) {
+                auto duration = m_rhythm_algo(m_gen, prev.get(), concurrent, m_ctx);
+                if(j + duration > m_end) {
+                    duration = m_end - j;
+                }
+                int num_notes = m_chord_algo(m_gen, prev.get(), concurrent, m_ctx);
+                m_ctx.reinit  = false;
+
+                bool downbeat = !m_percussion && !chord_progression.empty() && j % m_mlen == 0;
+                bool last     = !m_percussion && j + duration >= m_end;
+
+                // Like remapPitch, each root only applies with a chance of style.chance
+                std::vector<std::string> fixed;
+                if(downbeat && Randomizer::pick_uniform<float>(m_gen, 0.0f, 1.0f) <= chance) {
+                    std::string value = chord_progression.at((j / m_mlen) % chord_progression.size());
+                    if(value.at(value.length() - 1) == 'm') {
+                        value = value.substr(0, value.length() - 1);
+                    }
+                    fixed = roots(value);
+                }
+                if(last && Randomizer::pick_uniform<float>(m_gen, 0.0f, 1.0f) <= chance) {
+                    // The root of the style wins when the last Chord cannot be both
+                    auto                     root = roots(m_ctx.plan.root);
+                    std::vector<std::string> both;
+                    std::copy_if(root.begin(), root.end(), std::back_inserter(both), [&fixed](const std::string& r) {
+                        return std::find(fixed.begin(), fixed.end(), r) != fixed.end();
+                    });
+                    fixed = both.empty() ? root : both;
+                }
+
+                if(num_notes > 0) {
+                    allowed.emplace_back(fixed);
+                    allowed.resize(allowed.size() + num_notes - 1);
+                }
+                m_slots.push_back({duration, num_notes, num_notes > 0 && !fixed.empty()});
+                prev = std::make_shared<music::Chord>(music::Note{duration});
+                j += duration;
+
+                if(downbeat || j >= m_end) {
+                    break;
+                }
+            }
+
+            while(!allowed.empty() && allowed.back().empty()) {
+                allowed.pop_back();
+            }
+            try {
+                chain->constrain(allowed);
+            } catch(const std::invalid_argument&) {
+                m_config.getLogger()->warn("The pitch Markov Chain of Part {} cannot go to the roots before tick {}. "
+                                           "Generating these pitches without constraints.",
+                                           m_ctx.plan.stave, j);
+                for(auto& slot : m_slots) {
+                    slot.fixed = false;
+                }
+            }
+        }
+
+        std::vector<std::string> PartGenerator::roots(const std::string& to) {
+            const auto               range = m_clef.range();
+            const int                note  = music::Note::pitch(to + "4") % 12;
+            std::vector<std::string> res;
+            for(const auto& p : m_ctx.plan.pitches.pitches()) {
+                if(p % 12 == note && p >= range.first && p <= range.second) {
+                    res.emplace_back(music::Note::pitchRepr(p));
+                }
+            }
+            return res;
+        }
+
+        void PartGenerator::cut() {
+            auto measures = m_pending.measurize();
+
+            // Keep the Chords after the last barline in the unfinished Measure
+            music::Measure pending{m_clef, m_ctx.plan.time, (int)m_ctx.plan.rhythm.divisions, m_fifths};
+            pending.setBPM(m_bpm);
+            if(measures.back()->length() < m_mlen && m_tick < m_end) {
+                for(const auto& c : measures.back()->getNotes()) {
+                    pending.append(c);
+                }
+                measures.pop_back();
+            }
+            m_pending = std::move(pending);
+
+            for(const auto& m : measures) {
+                m_ready.emplace_back(m);
+            }
+        }
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_PARTGENERATOR_H
+#define AUTOPLAY_PARTGENERATOR_H
+
+#include "../music/Part.h"
+#include "Generator.h"
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace autoplay {
+    namespace util {
+        /**
+         * The PartGenerator class generates a single Part, one Measure at a time. It only keeps the Chords that are
+         * needed to continue the generation (the previous Chord, the unfinished Measure and, when other Parts look at
+         * this Part, a window of recent Chords), so the memory it uses does not depend on the length of the Part.
+         */
+        class PartGenerator
+        {
+        public:
+            /// The signature of a function that returns the Chords of the other Parts that play at a certain time
+            using Concurrent = std::function<std::vector<music::Chord*>(unsigned int tick)>;
+
+            /**
+             * Constructor
+             * @param generator The Generator that provides the algorithms.
+             * @param config    The Config of the system.
+             * @param ctx       The context of the Part.
+             * @param pt_part   The config of the Part, with its 'generation' merged with the global one.
+             * @param gen       The random stream of the Part.
+             */
+            PartGenerator(const Generator& generator, const Config& config, GenerationContext ctx,
+                          const pt::ptree& pt_part, const RNEngine& gen);
+
+            /**
+             * Create an empty Part with the Instruments, name and lines of this Part.
+             * @return A Part without Measures.
+             */
+            std::shared_ptr<music::Part> part() const;
+
+            /**
+             * Generate the next Measure of the Part.
+             * @param conc  The function to find the concurrent Chords with. It is only called when usesConcurrent()
+             *              is true, and only for times before the end of the Measure that is generated.
+             * @return The next Measure, or nullptr when the Part has been generated completely.
+             */
+            std::shared_ptr<music::Measure> next(const Concurrent& conc);
+
+            /**
+             * Find the Chord that is playing at a certain time, with the same rules as Part::at.
+             * @param tick  The time to look.
+             * @return A pointer to the Chord, or nullptr if it has not been generated, has been forgotten or the Part
+             *         is not observed (see setObserved()).
+             *
+             * @note The pointer stays valid until forget() is called with a later time.
+             */
+            music::Chord* at(unsigned int tick);
+
+            /**
+             * Forget all Chords that end before a certain time; i.e. they can no longer be found with at().
+             * @param tick  The time before which nothing will be looked up anymore.
+             */
+            void forget(unsigned int tick);
+
+            /**
+             * Set whether Parts after this one look at its Chords. Only then are the Chords kept for at().
+             * @param observed  True if another Part calls at().
+             */
+            inline void setObserved(bool observed) { m_observed = observed; }
+
+            /**
+             * Checks if Parts after this one look at its Chords.
+             * @return True if the Chords are kept for at().
+             */
+            inline bool isObserved() const { return m_observed; }
+
+            /**
+             * Get the amount of Chords that can still be found with at().
+             * @return The size of the window of recent Chords.
+             */
+            inline std::size_t windowSize() const { return m_window.size(); }
+
+            /**
+             * Checks if the Part looks at the Chords of the Parts before it.
+             * @return True if next() uses its argument.
+             */
+            inline bool usesConcurrent() const { return m_uses_conc; }
+
+            /**
+             * Get the length of a Measure of this Part.
+             * @return The length of a Measure in ticks.
+             */
+            inline unsigned int measureLength() const { return m_mlen; }
+
+        private:
+            /**
+             * Generate a single Chord and append it to the unfinished Measure.
+             * @param conc  The function to find the concurrent Chords with.
+             */
+            void step(const Concurrent& conc);
+
+            /**
+             * Plan the Chords up to (and including) the next Chord that starts on a downbeat, or the final Chord, for
+             * a Part with a constrained pitch Markov Chain. The rhythm and the amount of Notes of these Chords are
+             * generated first, so the pitch chain can be constrained to go to the root of the chord progression at
+             * the downbeat (and to the root of the style at the end) in the right step.
+             */
+            void plan();
+
+            /**
+             * Find the pitches of the Part that are a certain note, in any octave within the range of the Clef.
+             * @param to    The letter of the note; e.g. C, A#...
+             * @return The representations of the pitches.
+             */
+            std::vector<std::string> roots(const std::string& to);
+
+            /**
+             * Move all complete Measures out of the unfinished Measure, splitting (and tying) the Chords that cross a
+             * barline.
+             */
+            void cut();
+
+        private:
+            /**
+             * A Chord of which the rhythm has been planned, but not the pitches.
+             */
+            struct Slot {
+                unsigned int duration; ///< The duration of the Chord in ticks
+                int          notes;    ///< The amount of Notes of the Chord
+                bool         fixed;    ///< True if the first Note is constrained to a root, so it cannot be a rest
+            };
+
+            /**
+             * A Chord that has been generated, together with the time at which it ends.
+             */
+            struct Entry {
+                unsigned int end;   ///< The end time of the Chord
+                music::Chord chord; ///< The Chord itself
+            };
+
+            const Generator&           m_generator;   ///< The Generator that provides the algorithms
+            const Config&              m_config;      ///< The Config of the system
+            GenerationContext          m_ctx;         ///< The context of the Part
+            RNEngine                   m_gen;         ///< The random stream of the Part
+            Generator::PitchAlgorithm  m_pitch_algo;  ///< The pitch algorithm
+            Generator::RhythmAlgorithm m_rhythm_algo; ///< The rhythm algorithm
+            Generator::ChordAlgorithm  m_chord_algo;  ///< The chord note count algorithm
+            bool                       m_uses_conc;   ///< True if the Part looks at the Parts before it
+            bool                       m_observed;    ///< True if a Part after this one looks at this Part
+            bool                       m_mapped;      ///< True if the display pitch decides the head and Instrument
+            bool                       m_percussion;  ///< True if the Part is played by percussion
+            bool                       m_constrained; ///< True if the pitch chain is planned (see plan())
+            music::Clef                m_clef;        ///< The Clef of the Part
+            music::Measure             m_pending;     ///< The unfinished Measure
+            int                        m_fifths;      ///< The key signature of each Measure
+            int                        m_bpm;         ///< The tempo of each Measure
+            unsigned int               m_mlen;        ///< The length of a Measure in ticks
+            unsigned int               m_end;         ///< The length of the Part in ticks
+            unsigned int               m_tick;        ///< The time at which the next Chord starts
+
+            std::shared_ptr<music::Chord>               m_prev;   ///< The previous Chord
+            std::deque<Entry>                           m_window; ///< The Chords that can still be found with at()
+            std::deque<std::shared_ptr<music::Measure>> m_ready;  ///< The Measures that are complete
+            std::deque<Slot>                            m_slots;  ///< The planned Chords that have not been generated
+
+            std::vector<std::shared_ptr<music::Instrument>>           m_instruments;  ///< The Instruments
+            std::map<std::string, std::string>                        m_repr_to_head; ///< Display pitch -> head
+            std::map<std::string, std::shared_ptr<music::Instrument>> m_repr_to_inst; ///< Display pitch -> Instrument
+            std::string                                               m_name;         ///< The name of the Part
+            uint8_t                                                   m_lines;        ///< The amount of lines
+        };
+    }
+}
+
+#endif // AUTOPLAY_PARTGENERATOR_H
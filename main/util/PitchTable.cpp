@@ -0,0 +1,44 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#include "PitchTable.h"
+
+namespace autoplay {
+    namespace util {
+        PitchTable::PitchTable() : m_set(), m_pitches() {
+            m_index.fill(-1);
+            m_lowest.fill(-1);
+        }
+
+        PitchTable::PitchTable(const std::vector<uint8_t>& pitches) : PitchTable() {
+            for(const auto& p : pitches) {
+                if(p < 128) {
+                    m_set.set(p);
+                }
+            }
+            for(uint8_t p = 0; p < 128; ++p) {
+                if(m_set.test(p)) {
+                    m_index[p] = (int16_t)m_pitches.size();
+                    if(m_lowest[p % 12] == -1) {
+                        m_lowest[p % 12] = m_index[p];
+                    }
+                    m_pitches.emplace_back(p);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_PITCHTABLE_H
+#define AUTOPLAY_PITCHTABLE_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+namespace autoplay {
+    namespace util {
+        /**
+         * The PitchTable class is a precomputed set of pitches (in the MIDI range 0..127) that can be queried in
+         * constant time. It is built once per Part, instead of recomputing the pitches of a scale for each Note.
+         */
+        class PitchTable
+        {
+        public:
+            /**
+             * Default constructor, creates an empty table.
+             */
+            PitchTable();
+
+            /**
+             * Constructor
+             * @param pitches A vector of pitches. Duplicates and values over 127 are ignored.
+             */
+            explicit PitchTable(const std::vector<uint8_t>& pitches);
+
+            /**
+             * Checks if a pitch is in the table.
+             * @param pitch The pitch to check.
+             * @return True if it is in the table.
+             */
+            inline bool contains(uint8_t pitch) const { return pitch < 128 && m_set.test(pitch); }
+
+            /**
+             * Find the index of a pitch in the sorted pitches.
+             * @param pitch The pitch to find.
+             * @return The index of the pitch, or -1 if it's not in the table.
+             */
+            inline int index(uint8_t pitch) const { return pitch < 128 ? m_index[pitch] : -1; }
+
+            /**
+             * Find the lowest pitch in the table with a certain pitch class.
+             * @param pitch_class The pitch class (0 = C, 1 = C#...)
+             * @return The index of that pitch, or -1 if there is no such pitch.
+             */
+            inline int lowest(uint8_t pitch_class) const { return m_lowest[pitch_class % 12]; }
+
+            /**
+             * Get the pitch at a certain index.
+             * @param idx The index of the pitch.
+             * @return The pitch.
+             */
+            inline uint8_t at(std::size_t idx) const { return m_pitches.at(idx); }
+
+            /**
+             * Get all pitches, sorted from low to high.
+             * @return A vector of pitches.
+             */
+            inline const std::vector<uint8_t>& pitches() const { return m_pitches; }
+
+            /**
+             * Get all pitches as a bitset.
+             * @return A bitset where bit p is set iff p is in the table.
+             */
+            inline const std::bitset<128>& bits() const { return m_set; }
+
+            /**
+             * Get the amount of pitches in the table.
+             * @return The size of the table.
+             */
+            inline std::size_t size() const { return m_pitches.size(); }
+
+            /**
+             * Checks if the table is empty.
+             * @return True if empty.
+             */
+            inline bool empty() const { return m_pitches.empty(); }
+
+        private:
+            std::bitset<128>         m_set;     ///< The set of pitches
+            std::vector<uint8_t>     m_pitches; ///< The dense, sorted array of pitches
+            std::array<int16_t, 128> m_index;   ///< Pitch -> index in m_pitches (or -1)
+            std::array<int16_t, 12>  m_lowest;  ///< Pitch class -> index of lowest pitch (or -1)
+        };
+    }
+}
+
+#endif // AUTOPLAY_PITCHTABLE_H
@@ -17,6 +17,12 @@
 
 #include "RNEngine.h"
 
+#include <trng/uniform_dist.hpp>
+#include <trng/uniform_int_dist.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
 namespace autoplay {
     namespace util {
         void RNEngine::operator()(const std::string& type) {
@@ -54,6 +60,7 @@ namespace autoplay {
         }
 
         void RNEngine::operator()(const std::string& type, unsigned long seed) {
+            m_seed = seed;
             if(type == "lcg64") {
                 m_engine = trng::lcg64{seed};
             } else if(type == "lcg64_shift") {
@@ -88,6 +95,7 @@ namespace autoplay {
         }
 
         void RNEngine::seed(unsigned long seed) {
+            m_seed = seed;
             switch(m_engine.which()) {
             case 0: boost::get<trng::lcg64>(m_engine).seed(seed); break;
             case 1: boost::get<trng::lcg64_shift>(m_engine).seed(seed); break;
@@ -106,5 +114,110 @@ namespace autoplay {
             default: {}
             }
         }
+
+        bool RNEngine::parallel() const {
+            auto w = m_engine.which();
+            return w != 7 && w != 8;
+        }
+
+        void RNEngine::split(unsigned int count, unsigned int index) {
+            if(index >= count) {
+                throw std::invalid_argument("Cannot take stream " + std::to_string(index) + " of " +
+                                            std::to_string(count) + " streams.");
+            }
+            if(count == 1) {
+                return;
+            }
+
+            // Derive the seed of the new stream (SplitMix64), used by the engines that cannot split
+            uint64_t z = (uint64_t)m_seed + ((((uint64_t)count << 32) | index) + 1) * 0x9E3779B97F4A7C15ULL;
+            z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z          = z ^ (z >> 31);
+
+            switch(m_engine.which()) {
+            case 0: boost::get<trng::lcg64>(m_engine).split(count, index); break;
+            case 1: boost::get<trng::lcg64_shift>(m_engine).split(count, index); break;
+            case 2: boost::get<trng::mrg2>(m_engine).split(count, index); break;
+            case 3: boost::get<trng::mrg3>(m_engine).split(count, index); break;
+            case 4: boost::get<trng::mrg4>(m_engine).split(count, index); break;
+            case 5: boost::get<trng::mrg5>(m_engine).split(count, index); break;
+            case 6: boost::get<trng::mrg5s>(m_engine).split(count, index); break;
+            case 7: boost::get<trng::mt19937>(m_engine).seed((unsigned long)z); break;
+            case 8: boost::get<trng::mt19937_64>(m_engine).seed((unsigned long)z); break;
+            case 9: boost::get<trng::yarn2>(m_engine).split(count, index); break;
+            case 10: boost::get<trng::yarn3>(m_engine).split(count, index); break;
+            case 11: boost::get<trng::yarn4>(m_engine).split(count, index); break;
+            case 12: boost::get<trng::yarn5>(m_engine).split(count, index); break;
+            case 13: boost::get<trng::yarn5s>(m_engine).split(count, index); break;
+            default: {}
+            }
+            m_seed = (unsigned long)z;
+        }
+
+        void RNEngine::jump(unsigned long long n) {
+            switch(m_engine.which()) {
+            case 0: boost::get<trng::lcg64>(m_engine).jump(n); break;
+            case 1: boost::get<trng::lcg64_shift>(m_engine).jump(n); break;
+            case 2: boost::get<trng::mrg2>(m_engine).jump(n); break;
+            case 3: boost::get<trng::mrg3>(m_engine).jump(n); break;
+            case 4: boost::get<trng::mrg4>(m_engine).jump(n); break;
+            case 5: boost::get<trng::mrg5>(m_engine).jump(n); break;
+            case 6: boost::get<trng::mrg5s>(m_engine).jump(n); break;
+            case 7: {
+                auto& e = boost::get<trng::mt19937>(m_engine);
+                for(unsigned long long i = 0; i < n; ++i) {
+                    e();
+                }
+                break;
+            }
+            case 8: {
+                auto& e = boost::get<trng::mt19937_64>(m_engine);
+                for(unsigned long long i = 0; i < n; ++i) {
+                    e();
+                }
+                break;
+            }
+            case 9: boost::get<trng::yarn2>(m_engine).jump(n); break;
+            case 10: boost::get<trng::yarn3>(m_engine).jump(n); break;
+            case 11: boost::get<trng::yarn4>(m_engine).jump(n); break;
+            case 12: boost::get<trng::yarn5>(m_engine).jump(n); break;
+            case 13: boost::get<trng::yarn5s>(m_engine).jump(n); break;
+            default: {}
+            }
+        }
+
+        RNEngine RNEngine::substream(unsigned int count, unsigned int index) const {
+            RNEngine sub{*this};
+            sub.split(count, index);
+            return sub;
+        }
+
+        void RNEngine::fill(int* out, std::size_t n, int min, int max) {
+            visit([out, n, min, max](auto& engine) {
+                trng::uniform_int_dist U(min, max);
+                for(std::size_t i = 0; i < n; ++i) {
+                    out[i] = U(engine);
+                }
+            });
+        }
+
+        void RNEngine::fill(float* out, std::size_t n, float min, float max) {
+            visit([out, n, min, max](auto& engine) {
+                trng::uniform_dist<float> U(min, max);
+                for(std::size_t i = 0; i < n; ++i) {
+                    out[i] = U(engine);
+                }
+            });
+        }
+
+        void RNEngine::fill(double* out, std::size_t n, double min, double max) {
+            visit([out, n, min, max](auto& engine) {
+                trng::uniform_dist<double> U(min, max);
+                for(std::size_t i = 0; i < n; ++i) {
+                    out[i] = U(engine);
+                }
+            });
+        }
     }
-}
\ No newline at end of file
+}
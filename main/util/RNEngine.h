@@ -33,12 +33,19 @@
 #include <trng/yarn4.hpp>
 #include <trng/yarn5.hpp>
 #include <trng/yarn5s.hpp>
+#include <cstddef>
+#include <utility>
 
 namespace autoplay {
     namespace util {
         class RNEngine
         {
         public:
+            /**
+             * Default constructor, uses an lcg64 engine.
+             */
+            RNEngine() : m_engine(), m_seed(0) {}
+
             /**
              * Set the type of the engine by string
              * @param type The type to set.
@@ -58,6 +65,74 @@ namespace autoplay {
              */
             void seed(unsigned long seed);
 
+            /**
+             * Checks if the engine natively supports split() and jump(). This holds for all engines, except for the
+             * Mersenne Twisters (mt19937 and mt19937_64).
+             * @return True if the engine is a parallel engine.
+             */
+            bool parallel() const;
+
+            /**
+             * Split the stream into a number of interleaved streams (leapfrogging) and continue with one of them.
+             * An engine that is not parallel() is reseeded instead, with a seed that is derived from its current seed
+             * and the arguments.
+             * @param count The amount of streams to split into.
+             * @param index The index of the stream to continue with.
+             *
+             * @throws std::invalid_argument When index is not smaller than count.
+             */
+            void split(unsigned int count, unsigned int index);
+
+            /**
+             * Advance the stream, as if n numbers were generated. An engine that is not parallel() generates and
+             * discards the numbers one by one.
+             * @param n The amount of numbers to skip.
+             */
+            void jump(unsigned long long n);
+
+            /**
+             * Get an independent substream of this engine, without changing the engine itself. The substream only
+             * depends on the state of this engine and the arguments, so it can be used to give each Part, Measure or
+             * job its own reproducible stream, no matter in which order (or on which thread) they are generated.
+             * Substreams can be split further, e.g. substream(parts, p).substream(measures, m).
+             * @param count The amount of substreams.
+             * @param index The index of the substream.
+             * @return A copy of this engine, split according to split(count, index).
+             *
+             * @throws std::invalid_argument When index is not smaller than count.
+             */
+            RNEngine substream(unsigned int count, unsigned int index) const;
+
+            /**
+             * Fill a buffer with uniformly distributed integers. The engine type is only resolved once and the
+             * numbers are the same as the ones n calls to Randomizer::pick_uniform(gen, min, max) would return.
+             * @param out   The buffer to fill, of at least n elements.
+             * @param n     The amount of numbers to generate.
+             * @param min   The minimum of the range
+             * @param max   The maximum of the range (exclusive)
+             */
+            void fill(int* out, std::size_t n, int min, int max);
+
+            /**
+             * Fill a buffer with uniformly distributed floats. The engine type is only resolved once and the numbers
+             * are the same as the ones n calls to Randomizer::pick_uniform<float>(gen, min, max) would return.
+             * @param out   The buffer to fill, of at least n elements.
+             * @param n     The amount of numbers to generate.
+             * @param min   The minimum of the range
+             * @param max   The maximum of the range
+             */
+            void fill(float* out, std::size_t n, float min, float max);
+
+            /**
+             * Fill a buffer with uniformly distributed doubles. The engine type is only resolved once and the numbers
+             * are the same as the ones n calls to Randomizer::pick_uniform<double>(gen, min, max) would return.
+             * @param out   The buffer to fill, of at least n elements.
+             * @param n     The amount of numbers to generate.
+             * @param min   The minimum of the range
+             * @param max   The maximum of the range
+             */
+            void fill(double* out, std::size_t n, double min, double max);
+
             /**
              * Call something that takes the engine as argument.
              * @tparam R    The return value type
@@ -86,12 +161,41 @@ namespace autoplay {
                 }
             }
 
+            /**
+             * Call a function once with the concrete engine. Unlike callOnMe, which is meant for a single draw, the
+             * engine type is only resolved once, so a (generic) lambda that draws many numbers from its argument is
+             * compiled for each engine type and its draws can be fully inlined.
+             * @tparam F    The function type. It must accept a reference to each of the engine types.
+             * @param f     The function
+             * @return The result of f(engine)
+             */
+            template <typename F>
+            auto visit(F&& f) -> decltype(f(std::declval<trng::lcg64&>())) {
+                switch(m_engine.which()) {
+                case 1: return f(boost::get<trng::lcg64_shift>(m_engine));
+                case 2: return f(boost::get<trng::mrg2>(m_engine));
+                case 3: return f(boost::get<trng::mrg3>(m_engine));
+                case 4: return f(boost::get<trng::mrg4>(m_engine));
+                case 5: return f(boost::get<trng::mrg5>(m_engine));
+                case 6: return f(boost::get<trng::mrg5s>(m_engine));
+                case 7: return f(boost::get<trng::mt19937>(m_engine));
+                case 8: return f(boost::get<trng::mt19937_64>(m_engine));
+                case 9: return f(boost::get<trng::yarn2>(m_engine));
+                case 10: return f(boost::get<trng::yarn3>(m_engine));
+                case 11: return f(boost::get<trng::yarn4>(m_engine));
+                case 12: return f(boost::get<trng::yarn5>(m_engine));
+                case 13: return f(boost::get<trng::yarn5s>(m_engine));
+                default: return f(boost::get<trng::lcg64>(m_engine));
+                }
+            }
+
         private:
             typedef boost::variant<trng::lcg64, trng::lcg64_shift, trng::mrg2, trng::mrg3, trng::mrg4, trng::mrg5,
                                    trng::mrg5s, trng::mt19937, trng::mt19937_64, trng::yarn2, trng::yarn3, trng::yarn4,
                                    trng::yarn5, trng::yarn5s>
-                        engine_type; ///< The engine set/union
-            engine_type m_engine;    ///< The engine
+                          engine_type; ///< The engine set/union
+            engine_type   m_engine;    ///< The engine
+            unsigned long m_seed;      ///< The seed of the engine, updated on each split()
         };
     }
 }
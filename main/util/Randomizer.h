@@ -21,9 +21,11 @@
 #include <trng/uniform_dist.hpp>
 #include <trng/uniform_int_dist.hpp>
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <random>
 
+#include "CumulativeTable.h"
 #include "RNEngine.h"
 
 namespace autoplay {
@@ -32,30 +34,61 @@ namespace autoplay {
          * The Randomizer struct is a container of all random/choice functions used
          */
         struct Randomizer {
+            /**
+             * Draw a value from a distribution, using an RNEngine. The engine type is resolved for each draw.
+             * @tparam R        The result type
+             * @tparam D        The distribution type
+             * @param gen       A random engine generator
+             * @param dist      The distribution
+             * @return One value of the distribution
+             */
+            template <typename R, typename D>
+            static R draw(RNEngine& gen, D& dist) {
+                return gen.callOnMe<R>(dist);
+            }
+
+            /**
+             * Draw a value from a distribution, using a concrete TRNG engine (e.g. from within RNEngine::visit).
+             * This call can be fully inlined.
+             * @tparam R        The result type
+             * @tparam E        The engine type
+             * @tparam D        The distribution type
+             * @param gen       A random engine generator
+             * @param dist      The distribution
+             * @return One value of the distribution
+             */
+            template <typename R, typename E, typename D>
+            static R draw(E& gen, D& dist) {
+                return dist(gen);
+            }
+
             /**
              * Choose an integer element uniformly from a range
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param min       The minimum of the range
              * @param max       The maximum of the range (exclusive)
              * @return One randomly selected element in a range
              */
-            static int pick_uniform(RNEngine& gen, const int& min, const int& max) {
+            template <typename E>
+            static int pick_uniform(E& gen, const int& min, const int& max) {
                 trng::uniform_int_dist U(min, max);
-                return gen.callOnMe<int>(U);
+                return draw<int>(gen, U);
             }
 
             /**
              * Choose an element uniformly from a range
              * @tparam T        element type
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param min       The minimum of the range
              * @param max       The maximum of the range
              * @return One randomly selected element in a range
              */
-            template <typename T>
-            static T pick_uniform(RNEngine& gen, const T& min, const T& max) {
+            template <typename T, typename E>
+            static T pick_uniform(E& gen, const T& min, const T& max) {
                 trng::uniform_dist<T> U(min, max);
-                return gen.callOnMe<T>(U);
+                return draw<T>(gen, U);
             }
 
             /**
@@ -63,19 +96,21 @@ namespace autoplay {
              * @tparam C        container type
              * @tparam T        element type
              * @tparam Ts       other template types
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param elements  container of elements
              * @return One randomly selected element
              */
-            template <template <typename...> class C, typename T, typename... Ts>
-            static T pick_uniform(RNEngine& gen, const C<T, Ts...>& elements) {
+            template <typename E, template <typename...> class C, typename T, typename... Ts>
+            static T pick_uniform(E& gen, const C<T, Ts...>& elements) {
                 trng::uniform_int_dist U(0, elements.size());
-                return elements.at(gen.callOnMe<T>(U));
+                return elements.at(draw<T>(gen, U));
             }
 
             /**
              * Picks a weighted element from a range.
              * @tparam T        element type
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param min       The minimum of the range
              * @param max       The maximum of the range (exclusive)
@@ -85,8 +120,8 @@ namespace autoplay {
              * @return One randomly selected element from a range. If none is found,
              * returns the max.
              */
-            template <typename T>
-            static T pick_weighted(RNEngine& gen, const T& min, const T& max, const T& step,
+            template <typename T, typename E>
+            static T pick_weighted(E& gen, const T& min, const T& max, const T& step,
                                    std::function<float(const T&)> weight) {
                 float ws = 0.0f;
                 for(T i = min; i < max; i += step) {
@@ -94,7 +129,7 @@ namespace autoplay {
                 }
                 trng::uniform_dist<float> U(0.0f, ws);
 
-                auto rw = gen.callOnMe<float>(U);
+                auto rw = draw<float>(gen, U);
                 for(T i = min; i < max; i += step) {
                     rw -= weight(i);
                     if(rw <= 0) {
@@ -109,14 +144,33 @@ namespace autoplay {
              * @tparam T        element type
              * @tparam C        container type
              * @tparam Ts       Other types
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param elements  Container of elements
              * @param weight    A weight function that can be used to determine the weight
              *                  of each element in the container
              * @return One randomly selected element
              */
+            template <typename E, template <typename...> class C, typename T, typename... Ts, typename F = float>
+            static T pick_weighted(E& gen, const C<T, Ts...>& elements, std::function<F(const T&)> weight) {
+                trng::uniform_dist<F> U(0, 1);
+                return pick_weighted(elements, weight, draw<F>(gen, U));
+            }
+
+            /**
+             * Picks a weighted element from a series of elements, for a uniform number that has already been drawn
+             * (e.g. from a UniformBlock).
+             * @tparam T        element type
+             * @tparam C        container type
+             * @tparam Ts       Other types
+             * @param elements  Container of elements
+             * @param weight    A weight function that can be used to determine the weight
+             *                  of each element in the container
+             * @param u         A uniformly distributed number in [0, 1)
+             * @return The selected element
+             */
             template <template <typename...> class C, typename T, typename... Ts, typename F = float>
-            static T pick_weighted(RNEngine& gen, const C<T, Ts...>& elements, std::function<F(const T&)> weight) {
+            static T pick_weighted(const C<T, Ts...>& elements, std::function<F(const T&)> weight, F u) {
                 C<T, Ts...> sorted{elements};
                 std::sort(sorted.begin(), sorted.end(),
                           [&weight](const T& a, const T& b) -> bool { return weight(a) > weight(b); });
@@ -125,9 +179,8 @@ namespace autoplay {
                 for(const auto& w : sorted) {
                     ws += weight(w);
                 }
-                trng::uniform_dist<F> U(0, ws);
 
-                auto rw = gen.callOnMe<F>(U);
+                auto rw = ws * u;
                 for(const auto& w : sorted) {
                     rw -= weight(w);
                     if(rw <= 0) {
@@ -137,9 +190,23 @@ namespace autoplay {
                 return elements.back();
             }
 
+            /**
+             * Picks a weighted element from a precomputed table of weights.
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
+             * @param gen       A random engine generator
+             * @param table     The running sums of the weights
+             * @return The index of the selected element, or table.size() if none is found.
+             */
+            template <typename E>
+            static std::size_t pick_cumulative(E& gen, const CumulativeTable& table) {
+                trng::uniform_dist<float> U(0, table.total());
+                return table.find(draw<float>(gen, U));
+            }
+
             /**
              * Picks a weighted element from a range, with a ranged/skewed
              * weight/distribution function.
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param min       The minimum of the range
              * @param max       The maximum of the range (exclusive)
@@ -159,7 +226,8 @@ namespace autoplay {
              *
              * @return One randomly selected element from a range. If none is found, returns the max.
              */
-            static float pick_distributed(RNEngine& gen, const float& min, const float& max, const float& step,
+            template <typename E>
+            static float pick_distributed(E& gen, const float& min, const float& max, const float& step,
                                           std::function<float(const float&)> dist, float a, float b,
                                           bool fix_zero = false) {
                 float ws     = 0.0f;
@@ -175,7 +243,7 @@ namespace autoplay {
                 }
                 trng::uniform_dist<float> U(0, ws);
 
-                auto rw = gen.callOnMe<float>(U);
+                auto rw = draw<float>(gen, U);
                 for(float i = min; i < max; i += step) {
                     rw -= probability(i);
                     if(rw <= 0) {
@@ -190,6 +258,7 @@ namespace autoplay {
              * weight/distribution function.
              * @tparam C        container type
              * @tparam Ts       other template values
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param elements  Container of elements
              * @param weight    A weight function that can be used to determine the weight
@@ -207,8 +276,8 @@ namespace autoplay {
              *
              * @return One randomly selected element
              */
-            template <template <typename...> class C, typename... Ts>
-            static float pick_distributed(RNEngine& gen, const C<float, Ts...>& elements,
+            template <typename E, template <typename...> class C, typename... Ts>
+            static float pick_distributed(E& gen, const C<float, Ts...>& elements,
                                           std::function<float(const float&)> dist, float a, float b,
                                           bool fix_zero = false) {
                 float ws     = 0.0f;
@@ -228,7 +297,7 @@ namespace autoplay {
                 }
                 trng::uniform_dist<float> U(0, ws);
 
-                auto rw = gen.callOnMe<float>(U);
+                auto rw = draw<float>(gen, U);
                 for(long i = 0; i < (signed)elements.size(); ++i) {
                     rw -= probability(i);
                     if(rw <= 0) {
@@ -251,11 +320,46 @@ namespace autoplay {
                 return res;
             }
 
+            /**
+             * Compute the weights of Randomizer::gaussian for a series of elements once, so they can be reused by
+             * pick_cumulative for each pick.
+             * @tparam C        container type
+             * @tparam Ts       other template values
+             * @param elements  Container of elements
+             * @param a         The minimal value of the skewed domain
+             * @param b         The maximal value of the skewed domain
+             * @param fix_zero  If the zero-value should remain fixed in the computation or not.
+             *
+             * @return The running sums of the weights of all elements, in order.
+             */
+            template <template <typename...> class C, typename... Ts>
+            static CumulativeTable gaussian_table(const C<float, Ts...>& elements, float a = -3.0f, float b = 3.0f,
+                                                  bool fix_zero = false) {
+                auto  _min   = std::min_element(std::begin(elements), std::end(elements));
+                auto  _max   = std::max_element(std::begin(elements), std::end(elements));
+                float min    = std::distance(std::begin(elements), _min);
+                float max    = std::distance(std::begin(elements), _max);
+                float factor = (b - a) / (max - min);
+                if(fix_zero) {
+                    factor = (b - a) / (std::min(min, max) * 2);
+                }
+
+                // A plain loop over contiguous floats without calls through std::function, so it can be vectorized
+                const float        scale = 1.0f / std::sqrt(2.0f * (float)M_PI);
+                std::vector<float> weights(elements.size());
+                for(std::size_t i = 0; i < weights.size(); ++i) {
+                    float x    = a + ((float)i - min) * factor;
+                    weights[i] = scale * std::exp(-(x * x) / 2.0f);
+                }
+                return CumulativeTable(weights);
+            }
+
             /**
              * Picks a weighted element from a range, with respect to a standard normal
              * (Gaussian) distribution.
              * Each element has a bigger chance of being chosen if it's in the middle of
              * the range.
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param min       The minimum of the range
              * @param max       The maximum of the range (exclusive)
@@ -268,7 +372,8 @@ namespace autoplay {
              *
              * @return One randomly selected element from range. If none is found, it returns max.
              */
-            static float gaussian(RNEngine& gen, const float& min, const float& max, const float& step, float a = -3.0f,
+            template <typename E>
+            static float gaussian(E& gen, const float& min, const float& max, const float& step, float a = -3.0f,
                                   float b = 3.0f, bool fix_zero = false) {
                 auto dst = [&](const float& f) -> float { return gauss_curve(f); };
                 return pick_distributed(gen, min, max, step, dst, a, b, fix_zero);
@@ -281,6 +386,7 @@ namespace autoplay {
              * the container.
              * @tparam C        container type
              * @tparam Ts       other template values
+             * @tparam E        engine type; an RNEngine or a concrete TRNG engine
              * @param gen       A random engine generator
              * @param elements  Container of elements
              * @param a         The minimal value of the skewed domain
@@ -290,12 +396,15 @@ namespace autoplay {
              *                  instead of the width of the container.
              *
              * @return One randomly selected element.
+             *
+             * @note    When picking from the same elements repeatedly, compute gaussian_table once and use
+             *          pick_cumulative instead.
              */
-            template <template <typename...> class C, typename... Ts>
-            static float gaussian(RNEngine& gen, const C<float, Ts...>& elements, float a = -3.0f, float b = 3.0f,
+            template <typename E, template <typename...> class C, typename... Ts>
+            static float gaussian(E& gen, const C<float, Ts...>& elements, float a = -3.0f, float b = 3.0f,
                                   bool fix_zero = false) {
-                auto dst = [&](const float& f) -> float { return gauss_curve(f); };
-                return pick_distributed(gen, elements, dst, a, b, fix_zero);
+                auto idx = pick_cumulative(gen, gaussian_table(elements, a, b, fix_zero));
+                return idx < elements.size() ? elements.at(idx) : elements.back();
             };
         };
     }
@@ -0,0 +1,159 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_THREADPOOL_H
+#define AUTOPLAY_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace autoplay {
+    namespace util {
+        /**
+         * The ThreadPool class is a fixed set of worker threads that execute tasks from a shared queue.
+         * Tasks may enqueue new tasks themselves.
+         */
+        class ThreadPool
+        {
+        public:
+            using Task = std::function<void()>;
+
+            /**
+             * Constructor
+             * @param threads The amount of worker threads. When 0, the amount of hardware threads is used.
+             */
+            explicit ThreadPool(unsigned int threads = 0) : m_active(0), m_stop(false), m_error(nullptr) {
+                if(threads == 0) {
+                    threads = hardware();
+                }
+                for(unsigned int i = 0; i < threads; ++i) {
+                    m_workers.emplace_back([this]() { work(); });
+                }
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /**
+             * Destructor, finishes all remaining tasks and joins the worker threads.
+             */
+            ~ThreadPool() {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+                m_task_cv.notify_all();
+                for(auto& w : m_workers) {
+                    w.join();
+                }
+            }
+
+            /**
+             * Add a task to the queue.
+             * @param task The task to execute.
+             */
+            void enqueue(Task task) {
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_tasks.emplace_back(std::move(task));
+                }
+                m_task_cv.notify_one();
+            }
+
+            /**
+             * Block until all tasks (including tasks that were added by other tasks) have finished.
+             *
+             * @throws The first exception that was thrown by a task, if any.
+             */
+            void wait() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done_cv.wait(lock, [this]() { return m_tasks.empty() && m_active == 0; });
+                if(m_error) {
+                    auto error = m_error;
+                    m_error    = nullptr;
+                    std::rethrow_exception(error);
+                }
+            }
+
+            /**
+             * Get the amount of worker threads.
+             * @return The size of the pool.
+             */
+            inline std::size_t size() const { return m_workers.size(); }
+
+            /**
+             * Get the amount of hardware threads, or 1 if it cannot be detected.
+             * @return The amount of hardware threads.
+             */
+            static unsigned int hardware() {
+                unsigned int n = std::thread::hardware_concurrency();
+                return n == 0 ? 1 : n;
+            }
+
+        private:
+            /**
+             * The loop of a worker thread.
+             */
+            void work() {
+                while(true) {
+                    Task task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_task_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+                        if(m_tasks.empty()) {
+                            return;
+                        }
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                        ++m_active;
+                    }
+
+                    std::exception_ptr error = nullptr;
+                    try {
+                        task();
+                    } catch(...) { error = std::current_exception(); }
+
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        if(error && !m_error) {
+                            m_error = error;
+                        }
+                        --m_active;
+                    }
+                    m_done_cv.notify_all();
+                }
+            }
+
+        private:
+            std::vector<std::thread> m_workers; ///< The worker threads
+            std::deque<Task>         m_tasks;   ///< The queue of tasks that still have to be executed
+            std::mutex               m_mutex;   ///< The mutex that guards the queue and the counters
+            std::condition_variable  m_task_cv; ///< Notified when a task has been added
+            std::condition_variable  m_done_cv; ///< Notified when a task has finished
+            unsigned int             m_active;  ///< The amount of tasks that are being executed
+            bool                     m_stop;    ///< True when the pool is being destroyed
+            std::exception_ptr       m_error;   ///< The first exception that was thrown by a task
+        };
+    }
+}
+
+#endif // AUTOPLAY_THREADPOOL_H
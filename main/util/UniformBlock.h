@@ -0,0 +1,72 @@
+/*
+ *  This is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *  The software is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with the software. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  Copyright 2019, Randy Paredis
+ *
+ *  Created on 05/01/2019
+ */
+
+#ifndef AUTOPLAY_UNIFORMBLOCK_H
+#define AUTOPLAY_UNIFORMBLOCK_H
+
+#include "RNEngine.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace autoplay {
+    namespace util {
+        /**
+         * The UniformBlock class prefetches uniformly distributed numbers in [0, 1) from an RNEngine, a block at a
+         * time (see RNEngine::fill). The numbers are the same as when they would be drawn one by one, but the engine
+         * type is only resolved once per block.
+         *
+         * @note The engine is ahead of the block by unused() numbers, so it should only be used through the block.
+         */
+        class UniformBlock
+        {
+        public:
+            /**
+             * Constructor
+             * @param size  The amount of numbers to prefetch at once.
+             */
+            explicit UniformBlock(std::size_t size = 256) : m_block(std::max<std::size_t>(size, 1)), m_pos(0) {
+                m_pos = m_block.size();
+            }
+
+            /**
+             * Get the next number. When all prefetched numbers have been used, a new block is drawn.
+             * @param gen   The engine to draw from.
+             * @return A uniformly distributed number in [0, 1).
+             */
+            inline double next(RNEngine& gen) {
+                if(m_pos == m_block.size()) {
+                    gen.fill(m_block.data(), m_block.size(), 0.0, 1.0);
+                    m_pos = 0;
+                }
+                return m_block[m_pos++];
+            }
+
+            /**
+             * Get the amount of numbers that have been prefetched, but not used yet.
+             * @return The amount of unused numbers.
+             */
+            inline std::size_t unused() const { return m_block.size() - m_pos; }
+
+        private:
+            std::vector<double> m_block; ///< The prefetched numbers
+            std::size_t         m_pos;   ///< The index of the next number in m_block
+        };
+    }
+}
+
+#endif // AUTOPLAY_UNIFORMBLOCK_H
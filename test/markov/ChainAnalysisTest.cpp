@@ -0,0 +1,109 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/ChainAnalysis.h"
+#include <gtest/gtest.h>
+
+using namespace autoplay;
+
+/**
+ * Create a chain with two States: A goes to B with chance a, B goes to A with chance b.
+ */
+markov::TransitionTable two_states(double a, double b) {
+    markov::NamedMatrix m{{"begin", "A", "B"}, {"A", "B"}};
+    m.at("begin", "A") = 1.0;
+    m.at("A", "A")     = 1.0 - a;
+    m.at("A", "B")     = a;
+    m.at("B", "A")     = b;
+    m.at("B", "B")     = 1.0 - b;
+    return markov::TransitionTable{m};
+}
+
+TEST(ChainAnalysisStandard, ChainAnalysisStationary) {
+    markov::ChainAnalysis analysis{two_states(0.3, 0.1)};
+    ASSERT_EQ(analysis.size(), 2u);
+    EXPECT_EQ(analysis.states(), (std::vector<std::string>{"A", "B"}));
+    EXPECT_THROW(analysis.index("begin"), std::out_of_range);
+
+    auto pi = analysis.stationary();
+    EXPECT_NEAR(pi.at(analysis.index("A")), 0.25, 1e-9);
+    EXPECT_NEAR(pi.at(analysis.index("B")), 0.75, 1e-9);
+
+    // A periodic chain converges as well
+    markov::ChainAnalysis periodic{two_states(1.0, 1.0)};
+    pi = periodic.stationary();
+    EXPECT_NEAR(pi.at(0), 0.5, 1e-9);
+    EXPECT_NEAR(pi.at(1), 0.5, 1e-9);
+    EXPECT_THROW(analysis.stationary(0.0, 3), std::runtime_error);
+}
+
+TEST(ChainAnalysisStandard, ChainAnalysisPower) {
+    markov::NamedMatrix m{{"begin", "A", "B", "C"}, {"A", "B", "C"}};
+    m.at("begin", "C") = 1.0;
+    m.at("A", "B")     = 2.0;
+    m.at("A", "C")     = 1.0;
+    m.at("B", "A")     = 1.0;
+    m.at("C", "A")     = 1.0;
+    m.at("C", "C")     = 3.0;
+    markov::TransitionTable table{m};
+    markov::ChainAnalysis   analysis{table};
+
+    // Repeated squaring agrees with repeated multiplication, also with multiple threads
+    auto naive = analysis.power(0);
+    for(unsigned long k = 0; k <= 9; ++k) {
+        auto p = analysis.power(k);
+        ASSERT_EQ(p.size(), 9u);
+        for(std::size_t i = 0; i < p.size(); ++i) {
+            EXPECT_NEAR(p.at(i), naive.at(i), 1e-12) << k;
+        }
+        for(std::size_t r = 0; r < 3; ++r) {
+            EXPECT_NEAR(p.at(3 * r) + p.at(3 * r + 1) + p.at(3 * r + 2), 1.0, 1e-12);
+        }
+        naive = analysis.multiply(naive, analysis.transitions());
+    }
+    EXPECT_DOUBLE_EQ(analysis.power(1).at(analysis.index("A") * 3 + analysis.index("B")), 2.0 / 3.0);
+
+    // The rows of a larger product are split over the threads, with the same result
+    std::vector<std::string> states;
+    for(int i = 0; i < 100; ++i) {
+        states.emplace_back("S" + std::to_string(i));
+    }
+    markov::NamedMatrix large{states, states};
+    for(int r = 0; r < 100; ++r) {
+        for(int c = r % 3; c < 100; c += 3) {
+            large.at(states[r], states[c]) = (double)((r * 7 + c * 11) % 5);
+        }
+    }
+    markov::TransitionTable large_table{large};
+    EXPECT_EQ(markov::ChainAnalysis(large_table, 4).power(37), markov::ChainAnalysis(large_table).power(37));
+
+    // The distribution after k steps from a State is its row of the k-th power
+    std::vector<double> at_c(3, 0.0);
+    at_c.at(analysis.index("C")) = 1.0;
+    auto after                   = analysis.step(at_c, 5);
+    auto p5                      = analysis.power(5);
+    for(std::size_t j = 0; j < 3; ++j) {
+        EXPECT_NEAR(after.at(j), p5.at(analysis.index("C") * 3 + j), 1e-12);
+    }
+
+    // initial() has already taken the first step
+    auto first = analysis.step(analysis.initial("C"), 5);
+    auto p6    = analysis.power(6);
+    for(std::size_t j = 0; j < 3; ++j) {
+        EXPECT_NEAR(first.at(j), p6.at(analysis.index("C") * 3 + j), 1e-12);
+    }
+}
+
+TEST(ChainAnalysisStandard, ChainAnalysisHistogram) {
+    markov::ChainAnalysis analysis{two_states(0.5, 1.0)};
+    EXPECT_THROW(analysis.histogram("X", 3), std::out_of_range);
+
+    // begin -> A, then A or B, and B always goes back to A
+    auto h = analysis.histogram("begin", 3);
+    EXPECT_NEAR(h.at(analysis.index("A")), 1.0 + 0.5 + 0.75, 1e-12);
+    EXPECT_NEAR(h.at(analysis.index("B")), 0.0 + 0.5 + 0.25, 1e-12);
+
+    auto empty = analysis.histogram("begin", 0);
+    EXPECT_EQ(empty, (std::vector<double>{0.0, 0.0}));
+}
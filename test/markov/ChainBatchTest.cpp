@@ -0,0 +1,128 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/ChainBatch.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace autoplay;
+
+/**
+ * Create a transition matrix of order 2 with rows of 1 up to 40 targets. The weights of some rows add up to a power
+ * of 2, so their cumulative chances can be hit exactly.
+ */
+markov::NamedMatrix wide_rows() {
+    std::vector<std::string> states;
+    for(int i = 0; i < 40; ++i) {
+        states.emplace_back("S" + std::to_string(i));
+    }
+    auto rows = states;
+    rows.emplace_back("begin");
+    rows.emplace_back("S0|S1");
+    rows.emplace_back("S1|S0");
+    markov::NamedMatrix m{rows, states};
+    for(std::size_t r = 0; r < rows.size(); ++r) {
+        auto degree = r % 40 + 1;
+        for(std::size_t c = 0; c < degree; ++c) {
+            m.at(rows[r], states[(r * 7 + c) % 40]) = r % 2 == 0 ? 1.0 : (double)(c % 5 + 1);
+        }
+    }
+    return m;
+}
+
+TEST(ChainBatchStandard, ChainBatchSearch) {
+    auto m = wide_rows();
+    m.normalizeRows();
+    markov::TransitionTable table{m};
+    auto                    view = table.filter({"S0", "S1", "S2", "S3", "S5", "S8", "S13", "S21", "S34"});
+
+    std::vector<double> us = {0.0, 0.03125, 0.1, 0.125, 0.25, 0.3, 0.5, 0.6, 0.75, 0.875, 0.9, 0.96875, 0.9999999};
+    for(const auto* t : {&table, &view}) {
+        std::vector<markov::TransitionTable::Row> rows;
+        std::vector<double>                       u;
+        for(markov::TransitionTable::Row r = 0; r < t->rows(); ++r) {
+            for(double x : us) {
+                if(!(t->filtered() && t->degree(r) == 0)) {
+                    rows.emplace_back(r);
+                    u.emplace_back(x);
+                }
+            }
+        }
+        ASSERT_GT(rows.size(), 64u);
+
+        // The same States as the scalar search, over several chunks of lanes
+        std::vector<markov::TransitionTable::Id> out(rows.size(), markov::TransitionTable::NONE);
+        t->next(rows.data(), u.data(), out.data(), rows.size());
+        for(std::size_t i = 0; i < rows.size(); ++i) {
+            EXPECT_EQ(out[i], t->next(rows[i], u[i])) << rows[i] << " " << u[i];
+        }
+    }
+
+    markov::TransitionTable::Row unknown = table.rows();
+    double                       half    = 0.5;
+    markov::TransitionTable::Id  id;
+    EXPECT_THROW(table.next(&unknown, &half, &id, 1), std::out_of_range);
+    table.next(&unknown, &half, &id, 0);
+}
+
+TEST(ChainBatchStandard, ChainBatchSingle) {
+    util::RNEngine gen;
+    gen("lcg64", 3);
+    markov::MarkovChain chain{wide_rows(), gen};
+    markov::ChainBatch  batch{chain, 1, gen};
+    EXPECT_EQ(batch.order(), 2u);
+    EXPECT_EQ(batch.getState(0), "begin");
+
+    // A batch of one chain goes to the same States as the chain itself
+    for(int i = 0; i < 1000; ++i) {
+        auto id = chain.next();
+        ASSERT_EQ(batch.next().front(), id) << i;
+        EXPECT_EQ(batch.getState(0), chain.state(id));
+    }
+}
+
+TEST(ChainBatchStandard, ChainBatchLanes) {
+    util::RNEngine gen;
+    gen("lcg64", 9);
+    markov::MarkovChain chain{wide_rows(), gen};
+    markov::ChainBatch  batch{chain, 5, gen};
+    ASSERT_EQ(batch.size(), 5u);
+
+    // Chain i takes every 5th number of the engine
+    const auto&                                           table = chain.table();
+    auto                                                  begin = table.find("begin");
+    std::vector<std::vector<markov::TransitionTable::Id>> history(5, {begin, begin});
+    std::vector<double>                                   u(5);
+    for(int step = 0; step < 200; ++step) {
+        if(step == 100) {
+            batch.reset(3);
+            history[3] = {begin, begin};
+            EXPECT_EQ(batch.getState(3), "begin");
+        }
+        gen.fill(u.data(), u.size(), 0.0, 1.0);
+        const auto& next = batch.next();
+        ASSERT_EQ(next.size(), 5u);
+        for(std::size_t c = 0; c < 5; ++c) {
+            auto id = table.next(table.row(history[c].data(), 2), u[c]);
+            ASSERT_EQ(next[c], id) << step << " " << c;
+            history[c] = {history[c][1], id};
+            EXPECT_EQ(batch.getState(c), table.name(id));
+        }
+    }
+
+    batch.reset();
+    for(std::size_t c = 0; c < 5; ++c) {
+        EXPECT_EQ(batch.getState(c), "begin");
+    }
+    EXPECT_THROW(batch.reset(5), std::out_of_range);
+    EXPECT_THROW(batch.getState(5), std::out_of_range);
+
+    // A chain without a known initial State cannot move
+    markov::MarkovChain nowhere{wide_rows(), gen, "S40"};
+    markov::ChainBatch  stuck{nowhere, 3, gen};
+    EXPECT_EQ(stuck.getState(0), "S40");
+    EXPECT_THROW(stuck.next(), std::out_of_range);
+    EXPECT_TRUE(markov::ChainBatch(chain, 0, gen).next().empty());
+}
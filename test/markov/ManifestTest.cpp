@@ -0,0 +1,61 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/Manifest.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace autoplay;
+
+TEST(ManifestStandard, ManifestRoundTrip) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    auto file = (dir / "manifest").string();
+
+    markov::Manifest manifest{3};
+    manifest.add("a.xml", {12, 1546300800});
+    manifest.add("sub dir/b c.xml", {0, 1});
+    manifest.save(file);
+
+    auto loaded = markov::Manifest::load(file);
+    EXPECT_EQ(loaded.order(), 3u);
+    EXPECT_EQ(loaded.size(), 2u);
+    ASSERT_NE(loaded.find("a.xml"), nullptr);
+    EXPECT_EQ(loaded.find("a.xml")->size, 12u);
+    EXPECT_EQ(loaded.find("a.xml")->mtime, 1546300800);
+    EXPECT_TRUE(loaded.contains("sub dir/b c.xml"));
+    EXPECT_FALSE(loaded.contains("b.xml"));
+    EXPECT_EQ(loaded.find("b.xml"), nullptr);
+
+    // Saving replaces the file
+    manifest.add("a.xml", {13, 1546300800});
+    manifest.save(file);
+    EXPECT_EQ(markov::Manifest::load(file).find("a.xml")->size, 13u);
+
+    auto entry = markov::Manifest::stat(file);
+    EXPECT_EQ(entry.size, boost::filesystem::file_size(file));
+
+    // The hashes of the tables are kept; a manifest of version 1 has none
+    manifest.setTables({0x0123456789abcdefull, 0, 42});
+    manifest.save(file);
+    EXPECT_EQ(markov::Manifest::load(file).tables(), (std::vector<uint64_t>{0x0123456789abcdefull, 0, 42}));
+    EXPECT_EQ(markov::Manifest::load(file).find("a.xml")->size, 13u);
+    std::ofstream(file) << "autoplay-manifest 1\norder 1\n12 1 a.xml\n";
+    EXPECT_TRUE(markov::Manifest::load(file).tables().empty());
+    EXPECT_TRUE(markov::Manifest::load(file).contains("a.xml"));
+
+    std::ofstream(file) << "autoplay-manifest 3\norder 1\n";
+    EXPECT_THROW(markov::Manifest::load(file), std::runtime_error);
+    std::ofstream(file) << "autoplay-manifest 2\norder 1\n12 1 a.xml\n";
+    EXPECT_THROW(markov::Manifest::load(file), std::runtime_error);
+    std::ofstream(file) << "autoplay-manifest 2\norder 1\ntables 12 x\n";
+    EXPECT_THROW(markov::Manifest::load(file), std::runtime_error);
+    std::ofstream(file) << "autoplay-manifest 1\norder 1\n12 a.xml\n";
+    EXPECT_THROW(markov::Manifest::load(file), std::runtime_error);
+    EXPECT_THROW(markov::Manifest::load((dir / "none").string()), std::runtime_error);
+
+    boost::filesystem::remove_all(dir);
+}
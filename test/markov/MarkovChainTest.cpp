@@ -0,0 +1,140 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/MarkovChain.h"
+#include <gtest/gtest.h>
+
+#include <map>
+
+using namespace autoplay;
+
+/**
+ * Create a first-order chain that can only reach C through B.
+ */
+markov::NamedMatrix through_b() {
+    markov::NamedMatrix m{{"begin", "A", "B", "C"}, {"A", "B", "C"}};
+    m.at("begin", "A") = 1.0;
+    m.at("begin", "B") = 1.0;
+    m.at("A", "A")     = 1.0;
+    m.at("A", "B")     = 1.0;
+    m.at("B", "A")     = 3.0;
+    m.at("B", "B")     = 2.0;
+    m.at("B", "C")     = 5.0;
+    m.at("C", "A")     = 1.0;
+    return m;
+}
+
+TEST(MarkovChainStandard, MarkovChainConstrained) {
+    auto                    m = through_b();
+    markov::TransitionTable table{m};
+    util::RNEngine          gen;
+    gen("lcg64", 7);
+    markov::MarkovChain chain{m, gen};
+
+    // The exact chances of the first State, given that the third one is C
+    auto p = [&table](const std::string& from, const std::string& to) {
+        auto id = table.find(from);
+        return table.chance(table.row(&id, 1), table.find(to));
+    };
+    std::map<std::string, double> expected;
+    double                        total = 0.0;
+    for(const auto& x1 : {"A", "B", "C"}) {
+        for(const auto& x2 : {"A", "B", "C"}) {
+            auto chance = p("begin", x1) * p(x1, x2) * p(x2, "C");
+            expected[x1] += chance;
+            total += chance;
+        }
+    }
+
+    const std::vector<std::vector<std::string>> allowed = {{}, {}, {"C"}};
+    std::map<std::string, double>               counts;
+    const int                                   samples = 20000;
+    for(int i = 0; i < samples; ++i) {
+        chain.reset();
+        chain.constrain(allowed);
+        EXPECT_EQ(chain.constrained(), 3u);
+        auto x1 = chain.state(chain.next());
+        chain.next();
+        ASSERT_EQ(chain.state(chain.next()), "C");
+        EXPECT_EQ(chain.constrained(), 0u);
+        counts[x1] += 1.0;
+    }
+    for(const auto& kv : expected) {
+        EXPECT_NEAR(counts[kv.first] / samples, kv.second / total, 0.015) << kv.first;
+    }
+
+    // An unconstrained chain goes on as usual
+    bool a = false;
+    for(int i = 0; i < 50; ++i) {
+        a = a || chain.state(chain.next()) == "A";
+    }
+    EXPECT_TRUE(a);
+}
+
+TEST(MarkovChainStandard, MarkovChainUnsatisfiable) {
+    util::RNEngine gen;
+    gen("lcg64", 7);
+    markov::MarkovChain chain{through_b(), gen};
+
+    // A cannot go to C, and begin cannot go to C directly
+    EXPECT_THROW(chain.constrain({{"A"}, {"C"}}), std::invalid_argument);
+    EXPECT_EQ(chain.constrained(), 0u);
+    EXPECT_THROW(chain.constrain({{"C"}}), std::invalid_argument);
+    EXPECT_EQ(chain.constrained(), 0u);
+    EXPECT_THROW(chain.constrain({{"unknown"}}), std::invalid_argument);
+
+    // Constraining a restricted chain only uses the States that are kept
+    chain.keep({"A", "C"});
+    EXPECT_THROW(chain.constrain({{}, {}, {"C"}}), std::invalid_argument);
+    EXPECT_NO_THROW(chain.constrain({{}, {"A"}}));
+    EXPECT_EQ(chain.state(chain.next()), "A");
+    EXPECT_EQ(chain.state(chain.next()), "A");
+}
+
+TEST(MarkovChainStandard, MarkovChainAvoid) {
+    util::RNEngine gen;
+    gen("lcg64", 11);
+    markov::MarkovChain chain{through_b(), gen};
+    const auto&         table = chain.table();
+
+    for(int i = 0; i < 100; ++i) {
+        chain.reset();
+        EXPECT_EQ(chain.state(chain.next({table.find("A")})), "B");
+        EXPECT_NE(chain.state(chain.next({table.find("A"), table.find("B")})), "A");
+    }
+
+    // When all States are avoided, they are allowed again
+    chain.reset();
+    auto s = chain.state(chain.next({table.find("A"), table.find("B")}));
+    EXPECT_TRUE(s == "A" || s == "B") << s;
+
+    // The constraints win over the avoided States
+    chain.reset();
+    chain.constrain({{"A"}});
+    EXPECT_EQ(chain.state(chain.next({table.find("A")})), "A");
+}
+
+TEST(MarkovChainStandard, MarkovChainConstrainedOrder) {
+    // After A, A the longest context can only go to A again, so C is reached through the first-order rows
+    auto m = through_b();
+    m.addRow("A|A");
+    m.at("A|A", "A") = 1.0;
+    m.addRow("A|B");
+    m.at("A|B", "A") = 1.0;
+
+    util::RNEngine gen;
+    gen("lcg64", 5);
+    markov::MarkovChain chain{m, gen};
+    ASSERT_EQ(chain.order(), 2u);
+
+    for(int i = 0; i < 200; ++i) {
+        chain.reset();
+        chain.constrain({{"A"}, {"A"}, {}, {"C"}});
+        std::vector<std::string> states;
+        for(int t = 0; t < 4; ++t) {
+            states.emplace_back(chain.state(chain.next()));
+        }
+        EXPECT_EQ(states, (std::vector<std::string>{"A", "A", "B", "C"}));
+    }
+}
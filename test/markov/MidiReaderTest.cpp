@@ -0,0 +1,174 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/MarkovChain.h"
+#include "../../main/markov/MidiReader.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace autoplay;
+
+using Bytes = std::vector<uint8_t>;
+
+/**
+ * Create a chunk of a Standard MIDI File.
+ * @param type  The type of the chunk.
+ * @param data  The content of the chunk.
+ * @return The bytes of the chunk.
+ */
+Bytes chunk(const std::string& type, const Bytes& data) {
+    Bytes res(type.begin(), type.end());
+    auto  size = (uint32_t)data.size();
+    res.insert(res.end(), {(uint8_t)(size >> 24), (uint8_t)(size >> 16), (uint8_t)(size >> 8), (uint8_t)size});
+    res.insert(res.end(), data.begin(), data.end());
+    return res;
+}
+
+/**
+ * Write a Standard MIDI File to a temporary file. The caller removes it.
+ * @param format    The format of the file.
+ * @param division  The time division of the file.
+ * @param tracks    The contents of the track chunks.
+ * @return The name of the file.
+ */
+std::string midi(uint16_t format, uint16_t division, const std::vector<Bytes>& tracks) {
+    Bytes data = chunk("MThd", {0, (uint8_t)format, 0, (uint8_t)tracks.size(), (uint8_t)(division >> 8),
+                                (uint8_t)division});
+    for(const auto& track : tracks) {
+        auto c = chunk("MTrk", track);
+        data.insert(data.end(), c.begin(), c.end());
+    }
+    auto filename = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%%%%%.mid");
+    std::ofstream file{filename.string(), std::ios::binary};
+    file.write((const char*)data.data(), data.size());
+    return filename.string();
+}
+
+/// A conductor track in 3/4, with a tempo change
+const Bytes CONDUCTOR = {0x00, 0xFF, 0x58, 0x04, 0x03, 0x02, 0x18, 0x08, 0x00, 0xFF,
+                         0x51, 0x03, 0x07, 0xA1, 0x20, 0x00, 0xFF, 0x2F, 0x00};
+
+/// A chord of C4 and E4, a rest and a D4 that crosses the barline, with running status and a system exclusive event
+const Bytes MELODY = {0x00, 0x90, 0x3C, 0x64, 0x00, 0x40, 0x64, 0x60, 0x80, 0x3C, 0x40, 0x00, 0x40,
+                      0x40, 0x30, 0x90, 0x3E, 0x64, 0x81, 0x40, 0x3E, 0x00, 0x00, 0xF0, 0x03, 0x01,
+                      0x02, 0xF7, 0x00, 0xFF, 0x2F, 0x00};
+
+/// A bass drum on channel 10
+const Bytes DRUMS = {0x00, 0x99, 0x24, 0x64, 0x60, 0x89, 0x24, 0x00, 0x00, 0xFF, 0x2F, 0x00};
+
+TEST(MidiReaderStandard, MidiReaderMeasures) {
+    auto filename = midi(1, 96, {CONDUCTOR, MELODY, DRUMS});
+
+    markov::MidiReader reader{filename};
+    ASSERT_TRUE(reader.isScore());
+
+    markov::ScoreReader::Measure measure;
+    ASSERT_TRUE(reader.next(measure));
+    EXPECT_EQ(measure.part, 0u);
+    EXPECT_EQ(measure.divisions, 64);
+    ASSERT_EQ(measure.notes.size(), 4u);
+    const auto& notes = measure.notes;
+    EXPECT_EQ(notes[0].step, "C");
+    EXPECT_EQ(notes[0].octave, "4");
+    EXPECT_EQ(notes[0].duration, 64);
+    EXPECT_FALSE(notes[0].chord);
+    EXPECT_EQ(notes[1].step, "E");
+    EXPECT_EQ(notes[1].duration, 64);
+    EXPECT_TRUE(notes[1].chord);
+    EXPECT_TRUE(notes[2].rest);
+    EXPECT_EQ(notes[2].duration, 32);
+    EXPECT_EQ(notes[3].step, "D");
+    EXPECT_EQ(notes[3].alter, 0);
+    EXPECT_EQ(notes[3].duration, 96);
+
+    // The D4 is split at the barline of the 3/4 measure
+    ASSERT_TRUE(reader.next(measure));
+    EXPECT_EQ(measure.part, 0u);
+    EXPECT_EQ(measure.divisions, 0);
+    ASSERT_EQ(measure.notes.size(), 1u);
+    EXPECT_EQ(measure.notes[0].step, "D");
+    EXPECT_EQ(measure.notes[0].duration, 32);
+
+    ASSERT_TRUE(reader.next(measure));
+    EXPECT_EQ(measure.part, 1u);
+    ASSERT_EQ(measure.notes.size(), 1u);
+    EXPECT_TRUE(measure.notes[0].unpitched);
+    EXPECT_EQ(measure.notes[0].duration, 64);
+
+    EXPECT_FALSE(reader.next(measure));
+    boost::filesystem::remove(filename);
+}
+
+TEST(MidiReaderStandard, MidiReaderQuantize) {
+    // At 480 ticks per quarter, an F#3 of 250 ticks and a Bb3 of 7 ticks are 33 and 1 divisions
+    auto filename = midi(0, 480, {{0x00, 0x90, 0x36, 0x64, 0x81, 0x7A, 0x36, 0x00, 0x00, 0x3A, 0x64, 0x07, 0x3A,
+                                   0x00, 0x00, 0xFF, 0x2F, 0x00}});
+
+    markov::MidiReader reader{filename};
+    ASSERT_TRUE(reader.isScore());
+    markov::ScoreReader::Measure measure;
+    ASSERT_TRUE(reader.next(measure));
+    ASSERT_EQ(measure.notes.size(), 2u);
+    EXPECT_EQ(measure.notes[0].step, "G");
+    EXPECT_EQ(measure.notes[0].alter, -1);
+    EXPECT_EQ(measure.notes[0].octave, "3");
+    EXPECT_EQ(measure.notes[0].duration, 33);
+    EXPECT_EQ(measure.notes[1].step, "B");
+    EXPECT_EQ(measure.notes[1].alter, -1);
+    EXPECT_EQ(measure.notes[1].duration, 1);
+    EXPECT_FALSE(reader.next(measure));
+    boost::filesystem::remove(filename);
+}
+
+TEST(MidiReaderStandard, MidiReaderErrors) {
+    EXPECT_TRUE(markov::MidiReader::isMidi("a/b.MID"));
+    EXPECT_TRUE(markov::MidiReader::isMidi("b.midi"));
+    EXPECT_FALSE(markov::MidiReader::isMidi("b.xml"));
+    EXPECT_FALSE(markov::MidiReader::isMidi("a.mid/b"));
+
+    EXPECT_THROW(markov::MidiReader("/nonexistent.mid").isScore(), markov::MidiReader::ParseError);
+    auto format = midi(2, 96, {MELODY});
+    EXPECT_FALSE(markov::MidiReader(format).isScore());
+    boost::filesystem::remove(format);
+
+    // A data byte before any status byte
+    auto running = midi(0, 96, {{0x00, 0x3C, 0x64}});
+    EXPECT_THROW(markov::MidiReader(running).isScore(), markov::MidiReader::ParseError);
+    boost::filesystem::remove(running);
+
+    // A track that ends in the middle of an event
+    auto truncated = midi(0, 96, {{0x00, 0x90, 0x3C}});
+    EXPECT_THROW(markov::MidiReader(truncated).isScore(), markov::MidiReader::ParseError);
+    boost::filesystem::remove(truncated);
+
+    // SMPTE time divisions
+    auto smpte = midi(0, 0xE728, {MELODY});
+    try {
+        markov::MidiReader(smpte).isScore();
+        FAIL() << "Expected a ParseError";
+    } catch(const markov::MidiReader::ParseError& e) { EXPECT_EQ(e.offset(), 14u); }
+    boost::filesystem::remove(smpte);
+}
+
+TEST(MidiReaderStandard, MidiReaderTraining) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    boost::filesystem::rename(midi(1, 96, {CONDUCTOR, MELODY, DRUMS}), dir / "song.mid");
+
+    ASSERT_EQ(markov::MarkovChain::findScores(dir).size(), 1u);
+    auto matrices = markov::MarkovChain::generateMatrices(dir);
+    ASSERT_EQ(matrices.size(), 3u);
+    const auto& pitch  = matrices[0];
+    const auto& rhythm = matrices[1];
+    EXPECT_EQ(pitch.at("begin", "C4"), 1.0);
+    EXPECT_EQ(pitch.at("C4", "E4"), 1.0);
+    EXPECT_EQ(pitch.at("C4", "rest"), 1.0);
+    EXPECT_EQ(pitch.at("rest", "D4"), 1.0);
+    EXPECT_EQ(pitch.at("D4", "D4"), 1.0);
+    EXPECT_EQ(rhythm.at("64", "32"), 1.0);
+    EXPECT_EQ(rhythm.at("96", "32"), 1.0);
+    boost::filesystem::remove_all(dir);
+}
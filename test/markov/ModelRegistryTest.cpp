@@ -0,0 +1,67 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/ModelRegistry.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <thread>
+
+using namespace autoplay;
+
+TEST(ModelRegistryStandard, ModelRegistryShared) {
+    markov::NamedMatrix m{{"begin", "A", "B", "C"}, {"A", "B", "C"}};
+    m.at("begin", "A") = 1.0;
+    m.at("begin", "C") = 3.0;
+    m.at("A", "B")     = 1.0;
+    m.at("B", "C")     = 1.0;
+    m.at("C", "A")     = 1.0;
+    auto filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    markov::TransitionTable{m}.save(filename);
+
+    auto& registry = markov::ModelRegistry::instance();
+    registry.clear();
+
+    // All threads get the same model
+    std::vector<std::shared_ptr<const markov::MarkovChain>> models(4);
+    std::vector<std::thread>                                threads;
+    for(std::size_t i = 0; i < models.size(); ++i) {
+        threads.emplace_back([&, i]() { models.at(i) = registry.model(filename); });
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    for(const auto& model : models) {
+        EXPECT_EQ(model, models.front());
+    }
+    EXPECT_EQ(registry.size(), 1u);
+
+    // A restricted model is shared for the same set of States, in any order
+    auto view = registry.model(filename, {"B", "A"});
+    EXPECT_EQ(registry.model(filename, {"A", "B", "A"}), view);
+    EXPECT_NE(registry.model(filename, {"A", "C"}), view);
+    EXPECT_EQ(registry.size(), 1u);
+
+    util::RNEngine gen;
+    gen("lcg64", 3);
+    markov::MarkovChain chain{*view, gen};
+    for(int i = 0; i < 50; ++i) {
+        auto s = chain.state(chain.next());
+        EXPECT_TRUE(s == "A" || s == "B") << s;
+    }
+
+    // The full model is not changed by its views
+    markov::MarkovChain full{*registry.model(filename), gen};
+    bool                c = false;
+    for(int i = 0; i < 50; ++i) {
+        c = c || full.state(full.next()) == "C";
+    }
+    EXPECT_TRUE(c);
+
+    registry.clear();
+    EXPECT_EQ(registry.size(), 0u);
+    EXPECT_NE(registry.model(filename), models.front());
+    registry.clear();
+    boost::filesystem::remove(filename);
+}
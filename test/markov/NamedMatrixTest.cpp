@@ -0,0 +1,153 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/MarkovChain.h"
+#include "TrainingFixtures.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace autoplay;
+
+TEST(NamedMatrixStandard, NamedMatrixAdd) {
+    markov::NamedMatrix a{{"begin", "A"}, {"A", "B"}};
+    a.at("begin", "A") = 1.0;
+    a.at("A", "B")     = 2.0;
+
+    markov::NamedMatrix b{{"A", "C"}, {"B", "C"}};
+    b.at("A", "B") = 3.0;
+    b.at("C", "C") = 4.0;
+
+    a.add(b);
+    EXPECT_EQ(a.getRows(), (std::vector<std::string>{"A", "C", "begin"}));
+    EXPECT_EQ(a.getColumns(), (std::vector<std::string>{"A", "B", "C"}));
+    EXPECT_EQ(a.at("begin", "A"), 1.0);
+    EXPECT_EQ(a.at("A", "B"), 5.0);
+    EXPECT_EQ(a.at("A", "C"), 0.0);
+    EXPECT_EQ(a.at("C", "C"), 4.0);
+    EXPECT_EQ(a.at("C", "A"), 0.0);
+
+    // Adding an empty matrix changes nothing
+    markov::NamedMatrix c = a;
+    c.add(markov::NamedMatrix{});
+    expect_equal(a, c);
+}
+
+TEST(NamedMatrixStandard, NamedMatrixProject) {
+    std::vector<std::string> names = {"D", "begin", "A", "C", "B", "E"};
+    markov::NamedMatrix      m{names, names};
+    double                   v = 0.0;
+    for(const auto& r : names) {
+        for(const auto& c : names) {
+            m.at(r, c) = v++;
+        }
+    }
+
+    markov::NamedMatrix dropped = m;
+    for(const auto& s : {"A", "E"}) {
+        dropped.dropRow(s);
+    }
+    for(const auto& s : {"begin", "C", "E"}) {
+        dropped.dropColumn(s);
+    }
+
+    auto projected = m.project({"begin", "B", "C", "D", "X", "B"}, {"A", "D", "B", "Y"});
+    expect_equal(dropped, projected);
+
+    // The indexes of the projection are consistent
+    projected.addRow("F", 1.0);
+    projected.addColumn("G", 2.0);
+    EXPECT_EQ(projected.at("F", "A"), 1.0);
+    EXPECT_EQ(projected.at("F", "G"), 2.0);
+    EXPECT_EQ(projected.at("D", "G"), 2.0);
+    EXPECT_EQ(projected.at("C", "B"), m.at("C", "B"));
+
+    EXPECT_TRUE(m.project({}, {}).getRows().empty());
+    EXPECT_EQ(m.project(names, names).getRows(), m.getRows());
+}
+
+TEST(NamedMatrixStandard, NamedMatrixTrainingThreads) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir / "sub");
+    write_score((dir / "a.xml").string(), {{'C', 4, 64}, {'E', 4, 64}, {'G', 4, 128}});
+    write_score((dir / "b.xml").string(), {{'E', 4, 32}, {'C', 4, 64}, {'C', 4, 64}, {'D', 5, 32}});
+    write_score((dir / "sub" / "c.xml").string(), {{'G', 4, 64}, {'E', 4, 128}, {'C', 4, 64}});
+    write_score((dir / "sub" / "d.xml").string(), {{'C', 4, 16}, {'G', 4, 16}});
+
+    for(unsigned int order = 1; order <= 2; ++order) {
+        auto single = markov::MarkovChain::generateMatrices(dir, true, order, 1);
+        ASSERT_EQ(single.size(), 3u);
+        EXPECT_EQ(single.at(0).at("begin", "C4"), 2.0);
+        for(unsigned int threads : {2u, 3u, 8u}) {
+            auto multi = markov::MarkovChain::generateMatrices(dir, true, order, threads);
+            ASSERT_EQ(multi.size(), 3u);
+            for(unsigned int m = 0; m < 3; ++m) {
+                expect_equal(single.at(m), multi.at(m));
+            }
+        }
+    }
+
+    boost::filesystem::remove_all(dir);
+}
+
+TEST(NamedMatrixStandard, NamedMatrixCSV) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    auto file = (dir / "m.csv").string();
+
+    markov::NamedMatrix a{{"A", "B"}, {"A", "B", "C"}};
+    a.at("A", "C") = 1234567.0;
+    a.at("B", "A") = 1.0 / 3.0;
+    a.at("B", "C") = 2.0;
+    a.toCSV(file);
+    expect_equal(a, markov::NamedMatrix::fromCSV(file));
+
+    // An existing file is only replaced when asked
+    EXPECT_THROW(a.toCSV(file), std::runtime_error);
+    a.at("A", "A") = 5.0;
+    a.toCSV(file, ',', true);
+    expect_equal(a, markov::NamedMatrix::fromCSV(file));
+    EXPECT_EQ(std::distance(boost::filesystem::directory_iterator(dir), {}), 1);
+
+    boost::filesystem::remove_all(dir);
+}
+
+TEST(NamedMatrixStandard, NamedMatrixTrainingUpdate) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    auto out = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir / "sub");
+    boost::filesystem::create_directories(out);
+    std::vector<std::string> tables   = {(out / "p.csv").string(), (out / "r.csv").string(), (out / "c.csv").string()};
+    std::string              manifest = (out / "manifest").string();
+
+    write_score((dir / "a.xml").string(), {{'C', 4, 64}, {'E', 4, 64}, {'G', 4, 128}});
+    write_score((dir / "sub" / "c.xml").string(), {{'G', 4, 64}, {'E', 4, 128}, {'C', 4, 64}});
+    EXPECT_EQ(markov::MarkovChain::updateMatrices(dir, tables, manifest, true, 2, 2), 2u);
+    EXPECT_EQ(markov::MarkovChain::updateMatrices(dir, tables, manifest, true, 2, 2), 0u);
+    EXPECT_THROW(markov::MarkovChain::updateMatrices(dir, tables, manifest, true, 1, 2), std::invalid_argument);
+
+    write_score((dir / "b.xml").string(), {{'E', 4, 32}, {'C', 4, 64}, {'C', 4, 64}, {'D', 5, 32}});
+    write_score((dir / "sub" / "d.xml").string(), {{'C', 4, 16}, {'G', 4, 16}});
+    EXPECT_EQ(markov::MarkovChain::updateMatrices(dir, tables, manifest, true, 2, 1), 2u);
+
+    auto full = markov::MarkovChain::generateMatrices(dir, true, 2, 1);
+    for(unsigned int m = 0; m < 3; ++m) {
+        expect_equal(full.at(m), markov::NamedMatrix::fromCSV(tables.at(m)));
+    }
+
+    // An update that is interrupted before its manifest is written is detected, instead of counted twice
+    boost::filesystem::copy_file(manifest, manifest + ".old");
+    write_score((dir / "e.xml").string(), {{'D', 4, 64}, {'F', 4, 64}});
+    EXPECT_EQ(markov::MarkovChain::updateMatrices(dir, tables, manifest, true, 2, 1), 1u);
+    boost::filesystem::rename(manifest + ".old", manifest);
+    EXPECT_THROW(markov::MarkovChain::updateMatrices(dir, tables, manifest, true, 2, 1), std::runtime_error);
+
+    // Tables without a manifest cannot be updated
+    boost::filesystem::remove(manifest);
+    EXPECT_THROW(markov::MarkovChain::updateMatrices(dir, tables, manifest, true, 2, 1), std::runtime_error);
+
+    boost::filesystem::remove_all(dir);
+    boost::filesystem::remove_all(out);
+}
@@ -0,0 +1,117 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/ScoreReader.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace autoplay;
+
+/**
+ * Write a string to a temporary file.
+ * @param content   The content of the file.
+ * @return The name of the file.
+ */
+std::string temporary(const std::string& content) {
+    auto          filename = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%%%%%.xml");
+    std::ofstream file{filename.string()};
+    file << content;
+    return filename.string();
+}
+
+TEST(ScoreReaderStandard, ScoreReaderMeasures) {
+    auto filename = temporary(R"(<?xml version="1.0" encoding="UTF-8"?>
+<!DOCTYPE score-partwise PUBLIC "-//Recordare//DTD MusicXML 3.0 Partwise//EN" "partwise.dtd" [ <!ENTITY x "y"> ]>
+<!-- a comment -- with dashes --->
+<score-partwise version='3.0'>
+  <part-list><score-part id="P1"><part-name>A &amp; B</part-name></score-part></part-list>
+  <part id="P1">
+    <measure number="1" width='1"2'>
+      <note default-x="1"><pitch><step>C</step><alter> 1 </alter><octave>4</octave></pitch><duration>32</duration></note>
+      <attributes><divisions>32</divisions></attributes>
+      <attributes><divisions>16</divisions></attributes>
+      <note><chord/><pitch><step>E</step><alter>1.0</alter><octave>4</octave></pitch><duration>16</duration></note>
+      <note><chord/><chord/><pitch><step>G</step><octave>4</octave></pitch><duration>16</duration></note>
+      <!-- <note><pitch><step>B</step><octave>9</octave></pitch><duration>1</duration></note> -->
+      <note><rest/><duration><![CDATA[32]]></duration></note>
+      <backup><duration>64</duration></backup>
+      <note><unpitched><display-step>C</display-step></unpitched><duration>8</duration></note>
+      <note><pitch><step>D</step><octave>5</octave></pitch><pitch><step>F</step></pitch><duration>4</duration></note>
+    </measure>
+  </part>
+  <part id="P2">
+    <measure number="1"><attributes/><note><pitch><step>F</step><alter>-1</alter><octave>2</octave></pitch>
+      <duration>64</duration></note></measure>
+  </part>
+</score-partwise>
+)");
+
+    markov::ScoreReader reader{filename};
+    ASSERT_TRUE(reader.isScore());
+
+    markov::ScoreReader::Measure measure;
+    ASSERT_TRUE(reader.next(measure));
+    EXPECT_EQ(measure.part, 0u);
+    EXPECT_EQ(measure.divisions, 32);
+    ASSERT_EQ(measure.notes.size(), 6u);
+
+    const auto& c = measure.notes.at(0);
+    EXPECT_EQ(c.step, "C");
+    EXPECT_EQ(c.alter, 1);
+    EXPECT_EQ(c.octave, "4");
+    EXPECT_EQ(c.duration, 32);
+    EXPECT_FALSE(c.rest || c.unpitched || c.chord);
+
+    EXPECT_TRUE(measure.notes.at(1).chord);
+    EXPECT_EQ(measure.notes.at(1).alter, 0);
+    EXPECT_FALSE(measure.notes.at(2).chord);
+    EXPECT_TRUE(measure.notes.at(3).rest);
+    EXPECT_EQ(measure.notes.at(3).duration, 32);
+    EXPECT_TRUE(measure.notes.at(4).unpitched);
+    EXPECT_EQ(measure.notes.at(5).step, "D");
+    EXPECT_EQ(measure.notes.at(5).octave, "5");
+
+    ASSERT_TRUE(reader.next(measure));
+    EXPECT_EQ(measure.part, 1u);
+    EXPECT_EQ(measure.divisions, 0);
+    ASSERT_EQ(measure.notes.size(), 1u);
+    EXPECT_EQ(measure.notes.at(0).step, "F");
+    EXPECT_EQ(measure.notes.at(0).alter, -1);
+    EXPECT_EQ(measure.notes.at(0).duration, 64);
+
+    EXPECT_FALSE(reader.next(measure));
+    boost::filesystem::remove(filename);
+}
+
+TEST(ScoreReaderStandard, ScoreReaderErrors) {
+    auto timewise = temporary("<score-timewise><measure/></score-timewise>");
+    EXPECT_FALSE(markov::ScoreReader{timewise}.isScore());
+    boost::filesystem::remove(timewise);
+
+    EXPECT_THROW(markov::ScoreReader{"this/file/does/not/exist.xml"}.isScore(), markov::ScoreReader::ParseError);
+
+    auto empty = temporary("<?xml version=\"1.0\"?>\n");
+    EXPECT_THROW(markov::ScoreReader{empty}.isScore(), markov::ScoreReader::ParseError);
+    boost::filesystem::remove(empty);
+
+    markov::ScoreReader::Measure measure;
+
+    auto unclosed = temporary("<score-partwise><part><measure></measure>\n<measure></part></score-partwise>");
+    markov::ScoreReader reader{unclosed};
+    ASSERT_TRUE(reader.isScore());
+    ASSERT_TRUE(reader.next(measure));
+    try {
+        reader.next(measure);
+        FAIL() << "Expected a ParseError";
+    } catch(const markov::ScoreReader::ParseError& e) { EXPECT_EQ(e.line(), 2u); }
+    boost::filesystem::remove(unclosed);
+
+    auto duration = temporary("<score-partwise><part><measure><note><rest/></note></measure></part></score-partwise>");
+    markov::ScoreReader no_duration{duration};
+    ASSERT_TRUE(no_duration.isScore());
+    EXPECT_THROW(no_duration.next(measure), std::runtime_error);
+    boost::filesystem::remove(duration);
+}
@@ -0,0 +1,124 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/MarkovChain.h"
+#include "../../main/markov/TrainingCache.h"
+#include "TrainingFixtures.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace autoplay;
+
+TEST(TrainingCacheStandard, TrainingCacheKey) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    auto a = (dir / "a.xml").string();
+    auto b = (dir / "b.xml").string();
+    write_score(a, {{'C', 4, 64}, {'E', 4, 64}});
+    write_score(b, {{'C', 4, 64}, {'E', 4, 64}});
+
+    // 64-bit FNV-1a of "a"
+    std::ofstream((dir / "x").string()) << "a";
+    EXPECT_EQ(markov::TrainingCache::hash((dir / "x").string()), 0xaf63dc4c8601ec8cull);
+
+    // The key depends on the content and the order, not on the name of the file
+    auto key = markov::TrainingCache::key(a, 1);
+    EXPECT_EQ(key.size(), 16u);
+    EXPECT_EQ(key, markov::TrainingCache::key(b, 1));
+    EXPECT_NE(key, markov::TrainingCache::key(a, 2));
+    write_score(b, {{'C', 4, 64}, {'E', 4, 32}});
+    EXPECT_NE(key, markov::TrainingCache::key(b, 1));
+
+    EXPECT_THROW(markov::TrainingCache::hash((dir / "none").string()), std::runtime_error);
+    boost::filesystem::remove_all(dir);
+}
+
+TEST(TrainingCacheStandard, TrainingCacheRoundTrip) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    markov::TrainingCache cache{(dir / "cache").string()};
+    EXPECT_TRUE(boost::filesystem::is_directory(cache.directory()));
+
+    std::vector<markov::NamedMatrix> counts(3);
+    counts.at(0) = markov::NamedMatrix{{"begin", "C4 E4", "empty"}, {"C4", "E4", "unused"}};
+    counts.at(0).at("begin", "C4") = 3.0;
+    counts.at(0).at("C4 E4", "E4") = 1.0 / 3.0;
+    counts.at(1) = markov::NamedMatrix{{"begin"}, {"64"}};
+    counts.at(1).at("begin", "64") = 1.0;
+
+    std::vector<markov::NamedMatrix> loaded;
+    EXPECT_FALSE(cache.load("0123456789abcdef", loaded));
+    cache.store("0123456789abcdef", counts);
+    ASSERT_TRUE(cache.load("0123456789abcdef", loaded));
+    expect_equal(counts, loaded);
+
+    // An invalid entry is treated as missing
+    std::ofstream((dir / "cache" / "fedcba9876543210.counts").string())
+        << "autoplay-counts 1\nmatrix 1 1 2\nA\nB\n0 0 1\n";
+    EXPECT_FALSE(cache.load("fedcba9876543210", loaded));
+    expect_equal(counts, loaded);
+
+    boost::filesystem::remove_all(dir);
+}
+
+TEST(TrainingCacheStandard, TrainingCacheRetrain) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir / "scores");
+    auto scores = dir / "scores";
+    auto cache  = (dir / "cache").string();
+    write_score((scores / "a.xml").string(), {{'C', 4, 64}, {'E', 4, 64}, {'G', 4, 128}});
+    write_score((scores / "b.xml").string(), {{'E', 4, 32}, {'C', 4, 64}, {'C', 4, 64}, {'D', 5, 32}});
+    write_score((scores / "c.xml").string(), {{'G', 4, 64}, {'E', 4, 128}, {'C', 4, 64}});
+
+    for(unsigned int order = 1; order <= 2; ++order) {
+        auto fresh = markov::MarkovChain::generateMatrices(scores, true, order, 1);
+        expect_equal(fresh, markov::MarkovChain::generateMatrices(scores, true, order, 2, cache));
+        EXPECT_EQ(std::distance(boost::filesystem::directory_iterator(cache), {}), 3 * order);
+
+        // The second training only reads from the cache
+        expect_equal(fresh, markov::MarkovChain::generateMatrices(scores, true, order, 3, cache));
+        EXPECT_EQ(std::distance(boost::filesystem::directory_iterator(cache), {}), 3 * order);
+    }
+
+    // A changed file is read again
+    write_score((scores / "b.xml").string(), {{'E', 4, 32}, {'F', 4, 64}});
+    auto fresh = markov::MarkovChain::generateMatrices(scores, true, 2, 1);
+    expect_equal(fresh, markov::MarkovChain::generateMatrices(scores, true, 2, 2, cache));
+    EXPECT_EQ(std::distance(boost::filesystem::directory_iterator(cache), {}), 7);
+    EXPECT_EQ(fresh.at(0).at("begin", "F4"), 0.0);
+    EXPECT_EQ(fresh.at(0).at("E4", "F4"), 1.0);
+
+    boost::filesystem::remove_all(dir);
+}
+
+TEST(TrainingCacheStandard, TrainingCacheParseError) {
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir / "scores");
+    auto scores = dir / "scores";
+    auto cache  = (dir / "cache").string();
+    write_score((scores / "a.xml").string(), {{'C', 4, 64}, {'E', 4, 64}, {'G', 4, 128}});
+
+    // A score that breaks off in the middle of its second measure
+    auto broken = (scores / "broken.xml").string();
+    {
+        std::ofstream file{broken};
+        file << "<?xml version=\"1.0\"?>\n<score-partwise version=\"3.0\">\n<part id=\"P1\">\n<measure number=\"1\">\n"
+             << "<attributes><divisions>64</divisions></attributes>\n"
+             << "<note><pitch><step>D</step><octave>4</octave></pitch><duration>64</duration></note>\n"
+             << "</measure>\n<measure number=\"2\">\n<note><pitch><step>F</step><oct";
+    }
+
+    // The counts before the error are used, but only the complete file is cached
+    auto fresh = markov::MarkovChain::generateMatrices(scores, true, 1, 1);
+    EXPECT_EQ(fresh.at(0).at("begin", "D4"), 1.0);
+    auto entry = dir / "cache" / (markov::TrainingCache::key((scores / "a.xml").string(), 1) + ".counts");
+    for(int run = 0; run < 2; ++run) {
+        expect_equal(fresh, markov::MarkovChain::generateMatrices(scores, true, 1, 1, cache));
+        EXPECT_EQ(std::distance(boost::filesystem::directory_iterator(cache), {}), 1);
+        EXPECT_TRUE(boost::filesystem::exists(entry));
+    }
+
+    boost::filesystem::remove_all(dir);
+}
@@ -0,0 +1,57 @@
+//
+// Created by red on 05/01/19.
+//
+
+#ifndef AUTOPLAY_TRAININGFIXTURES_H
+#define AUTOPLAY_TRAININGFIXTURES_H
+
+#include "../../main/markov/NamedMatrix.h"
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * Write a MusicXML file with a single Part that plays a list of pitches.
+ * @param filename  The file to write.
+ * @param notes     The steps, octaves and durations of the Notes.
+ */
+inline void write_score(const std::string& filename, const std::vector<std::tuple<char, int, int>>& notes) {
+    std::ofstream file{filename};
+    file << "<?xml version=\"1.0\"?>\n<score-partwise version=\"3.0\">\n<part id=\"P1\">\n<measure number=\"1\">\n"
+         << "<attributes><divisions>64</divisions></attributes>\n";
+    for(const auto& n : notes) {
+        file << "<note><pitch><step>" << std::get<0>(n) << "</step><octave>" << std::get<1>(n)
+             << "</octave></pitch><duration>" << std::get<2>(n) << "</duration></note>\n";
+    }
+    file << "</measure>\n</part>\n</score-partwise>\n";
+}
+
+/**
+ * Check that two matrices have the same rows, columns and elements.
+ */
+inline void expect_equal(const autoplay::markov::NamedMatrix& a, const autoplay::markov::NamedMatrix& b) {
+    ASSERT_EQ(a.getRows(), b.getRows());
+    ASSERT_EQ(a.getColumns(), b.getColumns());
+    for(const auto& r : a.getRows()) {
+        for(const auto& c : a.getColumns()) {
+            EXPECT_EQ(a.at(r, c), b.at(r, c)) << r << " -> " << c;
+        }
+    }
+}
+
+/**
+ * Check that two lists of matrices, such as the results of two trainings, are the same.
+ */
+inline void expect_equal(const std::vector<autoplay::markov::NamedMatrix>& a,
+                         const std::vector<autoplay::markov::NamedMatrix>& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for(std::size_t m = 0; m < a.size(); ++m) {
+        SCOPED_TRACE("matrix " + std::to_string(m));
+        expect_equal(a.at(m), b.at(m));
+    }
+}
+
+#endif // AUTOPLAY_TRAININGFIXTURES_H
@@ -0,0 +1,334 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/markov/MarkovChain.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <stdexcept>
+
+using namespace autoplay;
+
+/**
+ * Create a small transition matrix.
+ */
+markov::NamedMatrix matrix() {
+    markov::NamedMatrix m{{"begin", "A", "B", "C"}, {"A", "B", "C"}};
+    m.at("begin", "A") = 1.0;
+    m.at("begin", "C") = 3.0;
+    m.at("A", "B")     = 1.0;
+    m.at("B", "A")     = 1.0;
+    m.at("B", "B")     = 1.0;
+    return m;
+}
+
+TEST(TransitionTableStandard, TransitionTableIds) {
+    markov::TransitionTable table{matrix()};
+    ASSERT_EQ(table.size(), 4u);
+    EXPECT_EQ(table.find("A"), 0u);
+    EXPECT_EQ(table.find("C"), 2u);
+    EXPECT_EQ(table.find("begin"), 3u);
+    EXPECT_EQ(table.find("D"), markov::TransitionTable::NONE);
+    for(markov::TransitionTable::Id id = 0; id < table.size(); ++id) {
+        EXPECT_EQ(table.find(table.name(id)), id);
+    }
+}
+
+TEST(TransitionTableStandard, TransitionTableNext) {
+    markov::TransitionTable table{matrix()};
+    EXPECT_EQ(table.order(), 1u);
+    EXPECT_EQ(table.rows(), 4u);
+
+    auto a      = table.find("A");
+    auto b      = table.find("B");
+    auto c      = table.find("C");
+    auto begin  = table.find("begin");
+    auto rbegin = table.row(&begin, 1);
+    auto ra     = table.row(&a, 1);
+    auto rb     = table.row(&b, 1);
+    auto rc     = table.row(&c, 1);
+    ASSERT_NE(rbegin, markov::TransitionTable::NO_ROW);
+
+    // Only the non-zero transitions are stored
+    EXPECT_EQ(table.degree(rbegin), 2u);
+    EXPECT_EQ(table.degree(ra), 1u);
+    EXPECT_DOUBLE_EQ(table.chance(rbegin, a), 0.25);
+    EXPECT_DOUBLE_EQ(table.chance(rbegin, b), 0.0);
+    EXPECT_DOUBLE_EQ(table.chance(rbegin, c), 0.75);
+
+    EXPECT_EQ(table.next(rbegin, 0.0), a);
+    EXPECT_EQ(table.next(rbegin, 0.2), a);
+    EXPECT_EQ(table.next(rbegin, 0.25), c);
+    EXPECT_EQ(table.next(rbegin, 0.9999), c);
+    EXPECT_EQ(table.next(ra, 0.5), b);
+    EXPECT_EQ(table.next(rb, 0.4), a);
+    EXPECT_EQ(table.next(rb, 0.6), b);
+
+    // A row without transitions goes anywhere
+    EXPECT_EQ(table.degree(rc), 3u);
+    EXPECT_DOUBLE_EQ(table.chance(rc, b), 1.0 / 3.0);
+
+    markov::TransitionTable empty;
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT_EQ(empty.row(&a, 1), markov::TransitionTable::NO_ROW);
+}
+
+TEST(TransitionTableStandard, TransitionTableContexts) {
+    // After A, B follows; but after B, it depends on what came before B
+    markov::NamedMatrix m{{"begin", "A", "B", "A|B", "B|B", "begin|begin", "begin|A"}, {"A", "B"}};
+    m.at("begin", "A")       = 1.0;
+    m.at("begin|begin", "A") = 1.0;
+    m.at("A", "B")           = 1.0;
+    m.at("begin|A", "B")     = 1.0;
+    m.at("B", "A")           = 1.0;
+    m.at("B", "B")           = 1.0;
+    m.at("A|B", "B")         = 1.0;
+    m.at("B|B", "A")         = 1.0;
+
+    markov::TransitionTable table{m};
+    EXPECT_EQ(table.order(), 2u);
+    EXPECT_EQ(table.rows(), 7u);
+
+    auto a = table.find("A");
+    auto b = table.find("B");
+
+    std::vector<markov::TransitionTable::Id> ab = {a, b};
+    std::vector<markov::TransitionTable::Id> bb = {b, b};
+    std::vector<markov::TransitionTable::Id> ba = {b, a};
+    EXPECT_EQ(table.next(table.row(ab.data(), 2), 0.9), b);
+    EXPECT_EQ(table.next(table.row(bb.data(), 2), 0.1), a);
+
+    // "B|A" is unknown, so the chain falls back to "A"
+    EXPECT_EQ(table.row(ba.data(), 2), table.row(&a, 1));
+
+    // A longer context only looks at its last States
+    std::vector<markov::TransitionTable::Id> aab = {a, a, b};
+    EXPECT_EQ(table.row(aab.data(), 3), table.row(ab.data(), 2));
+
+    util::RNEngine gen;
+    gen("lcg64", 5);
+    markov::MarkovChain chain{m, gen};
+    EXPECT_EQ(chain.order(), 2u);
+    std::string sequence;
+    for(int i = 0; i < 9; ++i) {
+        sequence += chain.state(chain.next());
+    }
+    EXPECT_EQ(sequence, "ABBABBABB");
+}
+
+TEST(TransitionTableStandard, TransitionTableChain) {
+    util::RNEngine gen;
+    gen("lcg64", 5);
+    markov::MarkovChain chain{matrix(), gen};
+    EXPECT_EQ(chain.getState(), "begin");
+
+    chain.keep({"A", "B"});
+    for(int i = 0; i < 100; ++i) {
+        auto s = chain.state(chain.next());
+        EXPECT_TRUE(s == "A" || s == "B") << s;
+        EXPECT_EQ(chain.getState(), s);
+    }
+    chain.reset();
+    EXPECT_EQ(chain.getState(), "begin");
+    EXPECT_EQ(chain.state(chain.next()), "A");
+}
+
+TEST(TransitionTableStandard, TransitionTableFilter) {
+    markov::NamedMatrix m{{"begin", "A", "B", "C", "A|B", "C|A", "begin|A"}, {"A", "B", "C"}};
+    m.at("begin", "A")   = 1.0;
+    m.at("begin", "C")   = 3.0;
+    m.at("A", "B")       = 1.0;
+    m.at("A", "C")       = 1.0;
+    m.at("B", "A")       = 2.0;
+    m.at("B", "B")       = 1.0;
+    m.at("C", "C")       = 2.0;
+    m.at("A|B", "C")     = 1.0;
+    m.at("C|A", "A")     = 1.0;
+    m.at("begin|A", "A") = 1.0;
+    markov::TransitionTable table{m};
+    auto                    view = table.filter({"A", "B", "D"});
+    EXPECT_FALSE(table.filtered());
+    EXPECT_TRUE(view.filtered());
+    EXPECT_EQ(view.size(), table.size());
+
+    // The view goes to the same States as a table without the column of C (and the rows that contain it)
+    markov::NamedMatrix r = m;
+    r.dropColumn("C");
+    r.dropRow("C");
+    r.dropRow("C|A");
+    markov::TransitionTable reference{r};
+    auto                    back = view.matrix();
+    EXPECT_EQ(back.getRows(), r.getRows());
+    EXPECT_EQ(back.getColumns(), r.getColumns());
+    for(const auto& row : r.getRows()) {
+        std::vector<markov::TransitionTable::Id> ctx, ref;
+        for(const auto& s : markov::TransitionTable::context(row)) {
+            ctx.emplace_back(view.find(s));
+            ref.emplace_back(reference.find(s));
+        }
+        auto vr = view.row(ctx.data(), ctx.size());
+        auto rr = reference.row(ref.data(), ref.size());
+        EXPECT_EQ(view.degree(vr), reference.degree(rr)) << row;
+        for(const auto& to : {"A", "B", "C"}) {
+            EXPECT_DOUBLE_EQ(view.chance(vr, view.find(to)), reference.chance(rr, reference.find(to))) << row;
+        }
+        for(double u : {0.0, 0.1, 0.3, 0.5, 0.6, 0.7, 0.9, 0.9999}) {
+            EXPECT_EQ(view.name(view.next(vr, u)), reference.name(reference.next(rr, u))) << row << " " << u;
+        }
+    }
+
+    // "C|A" is hidden, so the view falls back to "A"
+    std::vector<markov::TransitionTable::Id> ca = {view.find("C"), view.find("A")};
+    EXPECT_EQ(view.row(ca.data(), 2), view.row(&ca.back(), 1));
+    EXPECT_NE(table.row(ca.data(), 2), table.row(&ca.back(), 1));
+
+    // A filter of a view keeps the States that are in both
+    auto only_b = view.filter({"B", "C"});
+    auto begin  = only_b.find("begin");
+    for(double u : {0.0, 0.5, 0.9999}) {
+        EXPECT_EQ(only_b.name(only_b.next(only_b.row(&begin, 1), u)), "B");
+    }
+
+    // A view is saved as the table it represents
+    auto filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    view.save(filename);
+    auto loaded = markov::TransitionTable::load(filename);
+    EXPECT_FALSE(loaded.filtered());
+    EXPECT_EQ(loaded.matrix().getRows(), r.getRows());
+    EXPECT_EQ(loaded.matrix().getColumns(), r.getColumns());
+    boost::filesystem::remove(filename);
+}
+
+TEST(TransitionTableStandard, TransitionTableModel) {
+    markov::NamedMatrix m{{"begin", "A", "B", "C", "A|B", "begin|A"}, {"A", "B", "C"}};
+    m.at("begin", "A")   = 1.0;
+    m.at("begin", "C")   = 3.0;
+    m.at("A", "B")       = 1.0;
+    m.at("B", "A")       = 2.0;
+    m.at("B", "B")       = 1.0;
+    m.at("A|B", "C")     = 1.0;
+    m.at("begin|A", "A") = 1.0;
+    markov::TransitionTable table{m};
+
+    auto filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    EXPECT_FALSE(markov::TransitionTable::isModel(filename));
+    table.save(filename);
+    EXPECT_TRUE(markov::TransitionTable::isModel(filename));
+
+    auto loaded = markov::TransitionTable::load(filename);
+    ASSERT_EQ(loaded.size(), table.size());
+    EXPECT_EQ(loaded.columns(), 3u);
+    EXPECT_EQ(loaded.rows(), table.rows());
+    EXPECT_EQ(loaded.order(), 2u);
+    for(markov::TransitionTable::Id id = 0; id < table.size(); ++id) {
+        EXPECT_EQ(loaded.name(id), table.name(id));
+        EXPECT_EQ(loaded.find(table.name(id)), id);
+    }
+    EXPECT_EQ(loaded.find("D"), markov::TransitionTable::NONE);
+    EXPECT_THROW(loaded.name((markov::TransitionTable::Id)table.size()), std::out_of_range);
+
+    for(markov::TransitionTable::Row r = 0; r < table.rows(); ++r) {
+        EXPECT_EQ(loaded.degree(r), table.degree(r));
+        for(markov::TransitionTable::Id to = 0; to < table.columns(); ++to) {
+            EXPECT_EQ(loaded.chance(r, to), table.chance(r, to));
+        }
+        for(double u : {0.0, 0.2, 0.5, 0.7, 0.9999}) {
+            EXPECT_EQ(loaded.next(r, u), table.next(r, u));
+        }
+    }
+    std::vector<markov::TransitionTable::Id> ab = {loaded.find("A"), loaded.find("B")};
+    EXPECT_EQ(loaded.row(ab.data(), 2), table.row(ab.data(), 2));
+
+    // The chances can be turned back into a matrix
+    auto back = loaded.matrix();
+    EXPECT_EQ(back.getRows(), m.getRows());
+    EXPECT_EQ(back.getColumns(), m.getColumns());
+    EXPECT_DOUBLE_EQ(back.at("begin", "C"), 0.75);
+    EXPECT_DOUBLE_EQ(back.at("B", "A"), 2.0 / 3.0);
+    EXPECT_DOUBLE_EQ(back.at("C", "B"), 1.0 / 3.0);
+
+    // A chain walks a loaded model in the same way, and can still be restricted
+    util::RNEngine gen;
+    gen("lcg64", 7);
+    markov::MarkovChain from_matrix{m, gen};
+    markov::MarkovChain from_model{filename, gen};
+    markov::MarkovChain copy{from_model, gen};
+    for(int i = 0; i < 50; ++i) {
+        auto s = from_matrix.state(from_matrix.next());
+        EXPECT_EQ(from_model.state(from_model.next()), s);
+        EXPECT_EQ(copy.state(copy.next()), s);
+    }
+    from_model.keep({"A", "B"});
+    for(int i = 0; i < 50; ++i) {
+        auto s = from_model.state(from_model.next());
+        EXPECT_TRUE(s == "A" || s == "B") << s;
+    }
+
+    boost::filesystem::remove(filename);
+}
+
+TEST(TransitionTableStandard, TransitionTableInvalidModel) {
+    EXPECT_THROW(markov::TransitionTable::load("this/file/does/not/exist.apm"), std::runtime_error);
+
+    auto filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    {
+        std::ofstream file{filename, std::ios::binary};
+        file << "x, \"A\"\n\"A\", 1";
+    }
+    EXPECT_FALSE(markov::TransitionTable::isModel(filename));
+    EXPECT_THROW(markov::TransitionTable::load(filename), std::runtime_error);
+
+    // A truncated model
+    markov::TransitionTable{matrix()}.save(filename);
+    auto size = boost::filesystem::file_size(filename);
+    boost::filesystem::resize_file(filename, size - 8);
+    EXPECT_TRUE(markov::TransitionTable::isModel(filename));
+    EXPECT_THROW(markov::TransitionTable::load(filename), std::runtime_error);
+
+    // A corrupted model is rejected when it is loaded, instead of being read out of bounds later
+    auto patch = [&filename](uint64_t offset, uint64_t value, std::size_t size) {
+        std::fstream file{filename, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp((std::streamoff)offset);
+        file.write(reinterpret_cast<const char*>(&value), (std::streamsize)size);
+    };
+    auto header = [&filename](uint64_t offset) {
+        uint64_t      value = 0;
+        std::ifstream file{filename, std::ios::binary};
+        file.seekg((std::streamoff)offset);
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    };
+    auto align = [](uint64_t pos) { return (pos + 7) & ~(uint64_t)7; };
+    auto save  = [&filename]() {
+        markov::TransitionTable{matrix()}.save(filename);
+        ASSERT_NO_THROW(markov::TransitionTable::load(filename));
+    };
+    save();
+    uint64_t states = header(16), rows = header(40), transitions = header(48), slots = header(64), names = header(72);
+    auto     offsets = 80 + align((states + 1) * 8) + align(names) + align(states * 4);
+    auto     targets = offsets + align((rows + 1) * 8);
+    auto     table   = boost::filesystem::file_size(filename) - slots * 16;
+
+    patch(64, rows, 8); // A full hash table
+    EXPECT_THROW(markov::TransitionTable::load(filename), std::runtime_error);
+    save();
+    for(uint64_t s = 0; s < slots; ++s) {
+        patch(table + s * 16 + 8, 0, 4); // No slot is empty
+    }
+    EXPECT_THROW(markov::TransitionTable::load(filename), std::runtime_error);
+    for(uint64_t s = 0; s < slots; ++s) {
+        save();
+        patch(table + s * 16 + 8, rows, 4); // An unknown row
+        EXPECT_THROW(markov::TransitionTable::load(filename), std::runtime_error) << s;
+    }
+    save();
+    patch(targets, states, 4); // An unknown State
+    EXPECT_THROW(markov::TransitionTable::load(filename), std::runtime_error);
+    save();
+    patch(offsets + 8, transitions, 8); // The first row ends after the second one
+    EXPECT_THROW(markov::TransitionTable::load(filename), std::runtime_error);
+
+    boost::filesystem::remove(filename);
+}
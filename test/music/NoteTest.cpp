@@ -217,4 +217,26 @@ TEST(NoteComparisons, NoteComparisons) {
     EXPECT_GE(n1, n3);
     EXPECT_GT(n1, n4);
     EXPECT_GE(n1, n4);
-}
\ No newline at end of file
+}
+
+TEST(NoteChords, ChordName) {
+    music::Chord single{music::Note{(uint8_t)62, 16}};
+    EXPECT_EQ(single.getName(), "D");
+
+    music::Chord major;
+    major.append(music::Note{(uint8_t)60, 16});
+    major.append(music::Note{(uint8_t)64, 16});
+    major.append(music::Note{(uint8_t)67, 16});
+    EXPECT_EQ(major.getName(), "C");
+
+    music::Chord minor;
+    minor.append(music::Note{(uint8_t)57, 16});
+    minor.append(music::Note{(uint8_t)60, 16});
+    minor.append(music::Note{(uint8_t)64, 16});
+    EXPECT_EQ(minor.getName(), "Am");
+
+    music::Chord octave;
+    octave.append(music::Note{(uint8_t)60, 16});
+    octave.append(music::Note{(uint8_t)72, 16});
+    EXPECT_EQ(octave.getName(), "C");
+}
@@ -52,4 +52,48 @@ TEST(PartStandard, PartSetters) {
     EXPECT_EQ(p.getMeasures().size(), 2);
 
     EXPECT_EQ(p.at(36)->bottom()->getPitch(), 13);
-}
\ No newline at end of file
+}
+
+TEST(PartStandard, PartTimeIndex) {
+    auto        i = std::make_shared<music::Instrument>("", 1, 1, 0);
+    music::Part p{i};
+
+    EXPECT_EQ(p.at(0), nullptr);
+    EXPECT_EQ(p.chordCount(), 0);
+
+    // 3/4 with 12 divisions: each Measure takes 36 ticks
+    music::Measure m{music::Clef::Treble(), {3, 4}, 12};
+    m.append(music::Note{(uint8_t)60, 12});
+    m.append(music::Note{(uint8_t)62, 24});
+    m.append(music::Note{(uint8_t)64, 12});
+    m.append(music::Note{(uint8_t)65, 24});
+    m.append(music::Note{(uint8_t)67, 24});
+    p.setMeasures(m);
+
+    ASSERT_EQ(p.getMeasures().size(), 3);
+    EXPECT_EQ(p.chordCount(), 5);
+
+    EXPECT_EQ(p.at(0)->bottom()->getPitch(), 60);
+    EXPECT_EQ(p.at(12)->bottom()->getPitch(), 60);
+    EXPECT_EQ(p.at(13)->bottom()->getPitch(), 62);
+    EXPECT_EQ(p.at(36)->bottom()->getPitch(), 62);
+    EXPECT_EQ(p.at(37)->bottom()->getPitch(), 64);
+    EXPECT_EQ(p.at(49)->bottom()->getPitch(), 65);
+    EXPECT_EQ(p.at(96)->bottom()->getPitch(), 67);
+    EXPECT_EQ(p.at(97), nullptr);
+    EXPECT_EQ(p.at(109), nullptr);
+
+    EXPECT_EQ(p.noteAt(0)->bottom()->getPitch(), 60);
+    EXPECT_EQ(p.noteAt(2)->bottom()->getPitch(), 64);
+    EXPECT_EQ(p.noteAt(4)->bottom()->getPitch(), 67);
+    EXPECT_THROW(p.noteAt(5), std::out_of_range);
+
+    EXPECT_TRUE(p.toPause(3));
+    EXPECT_TRUE(p.at(60)->isPause());
+
+    // Changing the Chords of a Measure requires a reindex
+    p.getMeasures().at(2)->getNotes().at(0).setDuration(12);
+    p.reindex();
+    EXPECT_EQ(p.at(84)->bottom()->getPitch(), 67);
+    EXPECT_EQ(p.at(85), nullptr);
+}
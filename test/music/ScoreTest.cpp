@@ -0,0 +1,36 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/music/Score.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+using namespace autoplay;
+
+TEST(ScoreStandard, ScoreConcurrent) {
+    music::Score score{pt::ptree{}};
+
+    auto i = std::make_shared<music::Instrument>("", 1, 1, 0);
+    for(uint8_t k = 0; k < 3; ++k) {
+        music::Measure m{music::Clef::Treble(), {4, 4}, 4};
+        m.append(music::Note{(uint8_t)(60 + k), (unsigned int)(4 * (k + 1))});
+        auto part = std::make_shared<music::Part>(i);
+        part->setMeasures(m);
+        score.addPart(part);
+    }
+
+    EXPECT_EQ(score.getParts().size(), 3);
+    EXPECT_EQ(score.concurrent(0, 0).size(), 0);
+
+    auto conc = score.concurrent(0, 2);
+    ASSERT_EQ(conc.size(), 2);
+    EXPECT_EQ(conc.at(0)->bottom()->getPitch(), 60);
+    EXPECT_EQ(conc.at(1)->bottom()->getPitch(), 61);
+
+    // The first Part stops playing after 4 ticks
+    conc = score.concurrent(5, 10);
+    ASSERT_EQ(conc.size(), 2);
+    EXPECT_EQ(conc.at(0)->bottom()->getPitch(), 61);
+    EXPECT_EQ(conc.at(1)->bottom()->getPitch(), 62);
+}
@@ -0,0 +1,47 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/Randomizer.h"
+#include <gtest/gtest.h>
+
+using namespace autoplay;
+
+TEST(CumulativeTableStandard, CumulativeTableFind) {
+    util::CumulativeTable table{{1.0f, 0.0f, 2.0f, 1.0f}};
+    ASSERT_EQ(table.size(), 4u);
+    EXPECT_FLOAT_EQ(table.total(), 4.0f);
+    EXPECT_EQ(table.find(0.0f), 0u);
+    EXPECT_EQ(table.find(1.0f), 0u);
+    EXPECT_EQ(table.find(1.5f), 2u);
+    EXPECT_EQ(table.find(3.5f), 3u);
+    EXPECT_EQ(table.find(4.5f), 4u);
+    EXPECT_EQ(table.find(std::nanf("")), 4u);
+
+    util::CumulativeTable empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.find(0.0f), 0u);
+}
+
+TEST(CumulativeTableStandard, CumulativeTableGaussian) {
+    std::vector<float> elements;
+    for(int p = 40; p < 80; p += 2) {
+        elements.emplace_back((float)p);
+    }
+    auto dst = [](const float& f) -> float { return util::Randomizer::gauss_curve(f); };
+
+    // The cached table picks the same elements as evaluating the curve on each pick
+    for(bool fix_zero : {false, true}) {
+        util::RNEngine gen;
+        gen("lcg64", 3);
+        util::RNEngine copy{gen};
+
+        auto table = util::Randomizer::gaussian_table(elements, -3.0f, 3.0f, fix_zero);
+        ASSERT_EQ(table.size(), elements.size());
+        for(int i = 0; i < 1000; ++i) {
+            auto idx      = util::Randomizer::pick_cumulative(gen, table);
+            auto expected = util::Randomizer::pick_distributed(copy, elements, dst, -3.0f, 3.0f, fix_zero);
+            EXPECT_EQ(idx < elements.size() ? elements.at(idx) : elements.back(), expected) << i;
+        }
+    }
+}
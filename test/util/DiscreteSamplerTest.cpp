@@ -0,0 +1,61 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/DiscreteSampler.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace autoplay;
+
+TEST(DiscreteSamplerStandard, DiscreteSamplerProbability) {
+    std::vector<double>   weights = {1.0, 0.0, 3.0, 0.5, 0.5, 5.0};
+    util::DiscreteSampler sampler{weights};
+    ASSERT_EQ(sampler.size(), weights.size());
+    for(std::size_t i = 0; i < weights.size(); ++i) {
+        EXPECT_NEAR(sampler.probability(i), weights[i] / 10.0, 1e-12) << i;
+    }
+}
+
+TEST(DiscreteSamplerStandard, DiscreteSamplerSample) {
+    std::vector<double>   weights = {2.0, 0.0, 1.0, 1.0};
+    util::DiscreteSampler sampler{weights};
+
+    // Sweeping u over [0, 1) picks each index as often as its weight asks for
+    const int        steps = 40000;
+    std::vector<int> count(weights.size(), 0);
+    for(int s = 0; s < steps; ++s) {
+        ++count.at(sampler.sample((s + 0.5) / steps));
+    }
+    EXPECT_EQ(count[0], steps / 2);
+    EXPECT_EQ(count[1], 0);
+    EXPECT_EQ(count[2], steps / 4);
+    EXPECT_EQ(count[3], steps / 4);
+
+    EXPECT_LT(sampler.sample(0.0), weights.size());
+    EXPECT_LT(sampler.sample(0.9999999999), weights.size());
+
+    util::RNEngine gen;
+    gen("lcg64", 7);
+    for(int s = 0; s < 1000; ++s) {
+        EXPECT_NE(sampler.sample(gen), 1u);
+    }
+}
+
+TEST(DiscreteSamplerStandard, DiscreteSamplerEdgeCases) {
+    util::DiscreteSampler single{{4.0}};
+    EXPECT_EQ(single.sample(0.3), 0u);
+    EXPECT_DOUBLE_EQ(single.probability(0), 1.0);
+
+    util::DiscreteSampler zeros{{0.0, 0.0}};
+    EXPECT_DOUBLE_EQ(zeros.probability(0), 0.5);
+    EXPECT_EQ(zeros.sample(0.25), 0u);
+    EXPECT_EQ(zeros.sample(0.75), 1u);
+
+    util::DiscreteSampler empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_THROW(empty.sample(0.5), std::out_of_range);
+
+    EXPECT_THROW(util::DiscreteSampler({1.0, -1.0}), std::invalid_argument);
+}
@@ -0,0 +1,15 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/FileHandler.h"
+#include <gtest/gtest.h>
+
+using namespace autoplay;
+
+TEST(FileHandlerStandard, FileHandlerSuffixed) {
+    EXPECT_EQ(util::FileHandler::suffixed("music.xml", "12"), "music-12.xml");
+    EXPECT_EQ(util::FileHandler::suffixed("out/music.v2.xml", "0"), "out/music.v2-0.xml");
+    EXPECT_EQ(util::FileHandler::suffixed("music", "3"), "music-3");
+    EXPECT_EQ(util::FileHandler::suffixed("out.d/music", "3"), "out.d/music-3");
+}
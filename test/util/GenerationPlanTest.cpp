@@ -0,0 +1,87 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/GenerationPlan.h"
+#include <gtest/gtest.h>
+
+using namespace autoplay;
+
+TEST(GenerationPlanStandard, GenerationPlanDefaults) {
+    pt::ptree generation;
+    auto      logger = zz::log::get_logger("test_logger");
+
+    util::GenerationPlan plan{generation, 1, {40, 80}, 64, "C", logger};
+
+    EXPECT_EQ(plan.stave, 1);
+    EXPECT_EQ(plan.range.first, 40);
+    EXPECT_EQ(plan.range.second, 80);
+    EXPECT_EQ(plan.pitch.algorithm, "random");
+    EXPECT_EQ(plan.pitch.min, -3);
+    EXPECT_EQ(plan.pitch.max, 3);
+    EXPECT_FALSE(plan.pitch.constrained);
+    EXPECT_EQ(plan.rhythm.algorithm, "constant");
+    EXPECT_EQ(plan.rhythm.smallest, -8);
+    EXPECT_EQ(plan.rhythm.largest, 2);
+    EXPECT_EQ(plan.rhythm.duration, 64);
+    EXPECT_EQ(plan.chord.algorithm, "constant");
+    EXPECT_EQ(plan.chord.amount, 1);
+    EXPECT_FLOAT_EQ(plan.rest_ratio, 0.0f);
+    EXPECT_FLOAT_EQ(plan.chance, 0.0f);
+}
+
+TEST(GenerationPlanStandard, GenerationPlanOptions) {
+    pt::ptree generation;
+    auto      logger = zz::log::get_logger("test_logger");
+    generation.put("rhythm", "random");
+    generation.put("chord", "weighted");
+    generation.put("rest-ratio", -0.5f);
+    generation.put("options.rhythm.smallest", "eighth");
+    generation.put("options.rhythm.largest", "half");
+    generation.put("options.rhythm.duration", "16th");
+    generation.put("options.chord.2", 0.2f);
+    generation.put("options.chord.3", 0.1f);
+
+    util::GenerationPlan plan{generation, 0, {40, 80}, 64, "C", logger};
+
+    EXPECT_EQ(plan.rhythm.smallest, -3);
+    EXPECT_EQ(plan.rhythm.largest, -1);
+    EXPECT_EQ(plan.rhythm.duration, 16);
+    EXPECT_EQ(plan.rhythm.ticks(plan.rhythm.smallest), 32);
+    EXPECT_FLOAT_EQ(plan.rest_ratio, 0.5f);
+
+    ASSERT_EQ(plan.chord.weights.size(), 3);
+    EXPECT_FLOAT_EQ(plan.chord.weights.at(1), 0.7f);
+    EXPECT_FLOAT_EQ(plan.chord.weights.at(2), 0.2f);
+    EXPECT_FLOAT_EQ(plan.chord.weights.at(3), 0.1f);
+}
+
+TEST(GenerationPlanStandard, GenerationPlanValidation) {
+    auto logger = zz::log::get_logger("test_logger");
+
+    pt::ptree duration;
+    duration.put("options.rhythm.smallest", "tiny");
+    EXPECT_THROW(util::GenerationPlan(duration, 0, {40, 80}, 64, "C", logger), std::invalid_argument);
+
+    pt::ptree order;
+    order.put("options.rhythm.smallest", "whole");
+    order.put("options.rhythm.largest", "quarter");
+    EXPECT_THROW(util::GenerationPlan(order, 0, {40, 80}, 64, "C", logger), std::invalid_argument);
+
+    pt::ptree schematic;
+    schematic.put("pitch", "accompaniment");
+    schematic.put("options.pitch.schematic", "ABC");
+    EXPECT_THROW(util::GenerationPlan(schematic, 0, {40, 80}, 64, "C", logger), std::invalid_argument);
+
+    pt::ptree chain;
+    chain.put("pitch", "markov-chain");
+    EXPECT_THROW(util::GenerationPlan(chain, 0, {40, 80}, 64, "C", logger), std::invalid_argument);
+
+    // Only a pitch Markov Chain can be constrained
+    pt::ptree constrained;
+    constrained.put("options.pitch.constrained", true);
+    EXPECT_FALSE(util::GenerationPlan(constrained, 0, {40, 80}, 64, "C", logger).pitch.constrained);
+    constrained.put("pitch", "markov-chain");
+    constrained.put("options.pitch.chain", "pitch.csv");
+    EXPECT_TRUE(util::GenerationPlan(constrained, 0, {40, 80}, 64, "C", logger).pitch.constrained);
+}
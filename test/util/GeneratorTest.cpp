@@ -0,0 +1,203 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/Generator.h"
+#include "../../main/util/PartGenerator.h"
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+using namespace autoplay;
+
+namespace {
+    /**
+     * Create a Config from a JSON config file. The config folder is found next to the folder of the program, so the
+     * program is said to live in the config folder itself.
+     * @param json  The contents of the config file.
+     * @return The Config.
+     */
+    util::Config config(const std::string& json) {
+        auto file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.json");
+        {
+            std::ofstream out{file.string()};
+            out << json;
+        }
+
+        std::vector<std::string> args = {std::string(AUTOPLAY_CONFIG_DIR) + "/tests", "-c", file.string()};
+        std::vector<char*>       argv;
+        for(auto& arg : args) {
+            argv.emplace_back(&arg[0]);
+        }
+        util::Config res{(int)argv.size(), argv.data()};
+        boost::filesystem::remove(file);
+        return res;
+    }
+
+    /**
+     * Create the config of a Score with a certain length, with two accompaniment Parts that look at the Parts before
+     * them, in between Parts that do not look at the other Parts.
+     * @param length    The amount of Measures.
+     * @param rhythm    The rhythm algorithm of all Parts, and its options.
+     * @return The contents of the config file.
+     */
+    std::string accompanied(unsigned int length, const std::string& rhythm = "\"1/f-noise\"") {
+        std::stringstream ss;
+        ss << "{\"engine\": \"lcg64\", \"seed\": 7, \"length\": " << length << ",\n"
+           << "\"generation\": {\"pitch\": \"brownian-motion\", \"rhythm\": " << rhythm << ",\n"
+           << "\"chord\": \"weighted\", \"rest-ratio\": 0.01},\n"
+           << "\"style\": {\"from\": \"C-major\", \"chord-progression\": \"C-F-C-G-F-C\"},\n"
+           << "\"parts\": [\n"
+           << "{\"instrument\": \"Acoustic Grand Piano\", \"clef\": \"Treble\"},\n"
+           << "{\"instrument\": \"Acoustic Grand Piano\", \"clef\": \"Bass\", \"generation\": {\"pitch\": "
+           << "\"accompaniment\", \"options\": {\"pitch\": {\"schematic\": \"ABCBABCB\"}}}},\n"
+           << "{\"instrument\": \"Acoustic Grand Piano\", \"clef\": \"Treble\", \"generation\": {\"pitch\": "
+           << "\"accompaniment\"}},\n"
+           << "{\"instrument\": \"Acoustic Grand Piano\", \"clef\": \"Bass\", \"generation\": {\"pitch\": "
+           << "\"1/f-noise\"}},\n"
+           << "{\"instrument\": \"Acoustic Grand Piano\", \"clef\": \"Treble\", \"generation\": {\"pitch\": "
+           << "\"accompaniment\"}}\n"
+           << "]}\n";
+        return ss.str();
+    }
+
+    /**
+     * Describe the Measures of some Parts, so they can be compared.
+     * @param parts The Measures of each Part.
+     * @return For each Part, a line with all Notes of its Measures.
+     */
+    std::vector<std::string> describe(const std::vector<music::MeasureList>& parts) {
+        std::vector<std::string> res;
+        for(const auto& measures : parts) {
+            std::stringstream ss;
+            for(const auto& measure : measures) {
+                for(const auto& chord : measure->getNotes()) {
+                    for(const auto& note : chord.getNotes()) {
+                        ss << (int)note->getPitch() << ":" << note->getDuration() << (note->isPause() ? "r" : "")
+                           << (note->getTieStart() ? "(" : "") << (note->getTieEnd() ? ")" : "") << " ";
+                    }
+                    ss << ", ";
+                }
+                ss << "| ";
+            }
+            res.emplace_back(ss.str());
+        }
+        return res;
+    }
+
+    /**
+     * Describe the Measures of a Score.
+     * @param score The Score.
+     * @return For each Part, a line with all Notes of its Measures.
+     */
+    std::vector<std::string> describe(const music::Score& score) {
+        std::vector<music::MeasureList> parts;
+        for(const auto& part : score.getParts()) {
+            parts.emplace_back(part->getMeasures());
+        }
+        return describe(parts);
+    }
+}
+
+TEST(GeneratorStandard, GeneratorDependencies) {
+    auto            cfg = config(accompanied(4));
+    util::Generator generator{cfg, cfg.getLogger()};
+
+    // Only the accompaniment without a schematic looks at the Parts before it
+    std::vector<std::vector<unsigned int>> expected = {{}, {}, {0, 1}, {}, {0, 1, 2, 3}};
+    EXPECT_EQ(generator.dependencies(), expected);
+}
+
+TEST(GeneratorStandard, GeneratorThreads) {
+    auto            cfg = config(accompanied(40));
+    util::Generator generator{cfg, cfg.getLogger()};
+
+    auto expected = describe(generator.generate(3, 1));
+    ASSERT_EQ(expected.size(), 5);
+    for(const auto& part : expected) {
+        EXPECT_EQ(std::count(part.begin(), part.end(), '|'), 40);
+    }
+
+    // The Parts are generated in a different order, but each Part has its own random stream
+    for(unsigned int threads : {2, 8}) {
+        for(int run = 0; run < 5; ++run) {
+            EXPECT_EQ(describe(generator.generate(3, threads)), expected) << threads << " threads, run " << run;
+        }
+    }
+    EXPECT_NE(describe(generator.generate(4, 1)), expected);
+}
+
+TEST(GeneratorStandard, GeneratorStream) {
+    auto            cfg = config(accompanied(30));
+    util::Generator generator{cfg, cfg.getLogger()};
+
+    std::vector<music::MeasureList> parts;
+    unsigned int                    count = 0;
+    generator.stream(3, [&](const music::Score& score, unsigned int index, const music::MeasureList& measures) {
+        EXPECT_EQ(index, count++);
+        EXPECT_EQ(score.getParts().size(), 5);
+        parts.resize(measures.size());
+        for(unsigned int i = 0; i < measures.size(); ++i) {
+            parts.at(i).emplace_back(measures.at(i));
+        }
+    });
+    EXPECT_EQ(count, 30);
+    EXPECT_EQ(describe(parts), describe(generator.generate(3, 1)));
+}
+
+TEST(GeneratorStandard, GeneratorWindow) {
+    // Each Part plays eighth notes, so no Chord crosses a barline
+    auto cfg = config(accompanied(200, "\"constant\", \"options\": {\"rhythm\": {\"duration\": \"eighth\"}}"));
+    util::Generator generator{cfg, cfg.getLogger()};
+
+    music::Score                         score{cfg.conf_child("export")};
+    std::vector<util::GenerationContext> contexts;
+    auto                                 generators = generator.start(3, score, contexts);
+    ASSERT_EQ(generators.size(), 5);
+
+    // Nothing looks at the last Part, so it does not keep its Chords
+    std::vector<bool> observed;
+    for(const auto& g : generators) {
+        observed.emplace_back(g.isObserved());
+    }
+    EXPECT_EQ(observed, std::vector<bool>({true, true, true, true, false}));
+
+    std::vector<util::PartGenerator::Concurrent> conc;
+    for(unsigned int i = 0; i < generators.size(); ++i) {
+        conc.emplace_back([&generators, i](unsigned int tick) {
+            std::vector<music::Chord*> res;
+            for(unsigned int p = 0; p < i; ++p) {
+                if(auto c = generators.at(p).at(tick)) {
+                    res.emplace_back(c);
+                }
+            }
+            return res;
+        });
+    }
+
+    // Once the Measures before a barline have been forgotten, only the Chord that ends on the barline is kept
+    std::size_t chords = 0;
+    for(unsigned int m = 0; m < 200; ++m) {
+        for(unsigned int i = 0; i < generators.size(); ++i) {
+            auto measure = generators.at(i).next(conc.at(i));
+            ASSERT_TRUE(measure);
+            chords += measure->getNotes().size();
+        }
+        for(auto& g : generators) {
+            if(g.isObserved()) {
+                EXPECT_GE(g.windowSize(), 8);
+                g.forget((m + 1) * g.measureLength());
+                EXPECT_LE(g.windowSize(), 1);
+            } else {
+                EXPECT_EQ(g.windowSize(), 0);
+            }
+        }
+    }
+    EXPECT_EQ(chords, 5 * 200 * 8);
+    for(unsigned int i = 0; i < generators.size(); ++i) {
+        EXPECT_FALSE(generators.at(i).next(conc.at(i)));
+    }
+}
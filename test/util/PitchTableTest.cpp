@@ -0,0 +1,40 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/PitchTable.h"
+#include <gtest/gtest.h>
+
+using namespace autoplay;
+
+TEST(PitchTableStandard, PitchTableEmpty) {
+    util::PitchTable table;
+
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.size(), 0);
+    EXPECT_FALSE(table.contains(60));
+    EXPECT_EQ(table.index(60), -1);
+    EXPECT_EQ(table.lowest(0), -1);
+}
+
+TEST(PitchTableStandard, PitchTableLookup) {
+    util::PitchTable table{{64, 60, 67, 72, 60, 200}};
+
+    ASSERT_EQ(table.size(), 4);
+    EXPECT_EQ(table.pitches(), std::vector<uint8_t>({60, 64, 67, 72}));
+    EXPECT_EQ(table.at(2), 67);
+
+    EXPECT_TRUE(table.contains(64));
+    EXPECT_FALSE(table.contains(65));
+    EXPECT_FALSE(table.contains(200));
+    EXPECT_TRUE(table.bits().test(72));
+
+    EXPECT_EQ(table.index(60), 0);
+    EXPECT_EQ(table.index(72), 3);
+    EXPECT_EQ(table.index(61), -1);
+
+    EXPECT_EQ(table.lowest(0), 0);
+    EXPECT_EQ(table.lowest(7), 2);
+    EXPECT_EQ(table.lowest(19), 2);
+    EXPECT_EQ(table.lowest(1), -1);
+}
@@ -0,0 +1,120 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/Randomizer.h"
+#include "../../main/util/UniformBlock.h"
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace autoplay;
+
+/**
+ * Draw a series of numbers from an engine.
+ */
+std::vector<int> draw(util::RNEngine& gen, int n = 16) {
+    std::vector<int> res;
+    for(int i = 0; i < n; ++i) {
+        res.emplace_back(util::Randomizer::pick_uniform(gen, 0, 1000000));
+    }
+    return res;
+}
+
+TEST(RNEngineStandard, RNEngineSubstream) {
+    for(const auto& type : {"lcg64", "yarn4", "mt19937"}) {
+        util::RNEngine gen;
+        gen(type, 42);
+        util::RNEngine copy{gen};
+
+        auto a  = gen.substream(4, 1);
+        auto b  = gen.substream(4, 1);
+        auto c  = gen.substream(4, 2);
+        auto da = draw(a);
+        EXPECT_EQ(da, draw(b)) << type;
+        EXPECT_NE(da, draw(c)) << type;
+
+        // The engine itself does not change
+        EXPECT_EQ(draw(gen), draw(copy)) << type;
+    }
+}
+
+TEST(RNEngineStandard, RNEngineNested) {
+    util::RNEngine gen;
+    gen("mt19937", 7);
+    EXPECT_FALSE(gen.parallel());
+
+    auto a = gen.substream(3, 0).substream(5, 1);
+    auto b = gen.substream(3, 0).substream(5, 1);
+    auto c = gen.substream(3, 1).substream(5, 1);
+    auto d = draw(a);
+    EXPECT_EQ(d, draw(b));
+    EXPECT_NE(d, draw(c));
+
+    util::RNEngine lcg;
+    lcg("lcg64", 7);
+    EXPECT_TRUE(lcg.parallel());
+}
+
+TEST(RNEngineStandard, RNEngineSplitValidation) {
+    util::RNEngine gen;
+    gen("lcg64", 1);
+    EXPECT_THROW(gen.split(2, 2), std::invalid_argument);
+    EXPECT_THROW(gen.substream(0, 0), std::invalid_argument);
+
+    // A single stream is the stream itself
+    util::RNEngine copy{gen};
+    gen.split(1, 0);
+    EXPECT_EQ(draw(gen), draw(copy));
+}
+
+TEST(RNEngineStandard, RNEngineJumpFallback) {
+    util::RNEngine gen;
+    gen("mt19937_64", 3);
+    util::RNEngine copy{gen};
+
+    gen.jump(10);
+    draw(copy, 10);
+    EXPECT_EQ(draw(gen), draw(copy));
+}
+
+TEST(RNEngineStandard, RNEngineFill) {
+    for(const auto& type : {"lcg64", "mrg3", "yarn5s", "mt19937"}) {
+        util::RNEngine gen;
+        gen(type, 11);
+        util::RNEngine copy{gen};
+
+        std::vector<int> ints(100);
+        gen.fill(ints.data(), ints.size(), -5, 20);
+        for(const auto& i : ints) {
+            EXPECT_EQ(i, util::Randomizer::pick_uniform(copy, -5, 20)) << type;
+        }
+
+        std::vector<float> floats(100);
+        gen.fill(floats.data(), floats.size(), 0.0f, 2.0f);
+        for(const auto& f : floats) {
+            EXPECT_FLOAT_EQ(f, util::Randomizer::pick_uniform<float>(copy, 0.0f, 2.0f)) << type;
+        }
+    }
+}
+
+TEST(RNEngineStandard, RNEngineUniformBlock) {
+    util::RNEngine gen;
+    gen("yarn3", 5);
+    util::RNEngine copy{gen};
+
+    util::UniformBlock block{16};
+    EXPECT_EQ(block.unused(), 0);
+    for(int i = 0; i < 40; ++i) {
+        EXPECT_DOUBLE_EQ(block.next(gen), util::Randomizer::pick_uniform<double>(copy, 0.0, 1.0));
+    }
+    EXPECT_EQ(block.unused(), 8);
+
+    // A weighted pick for a drawn number is the same as a weighted pick that draws itself
+    std::vector<std::string>                  elements = {"a", "b", "c", "d"};
+    std::function<double(const std::string&)> weight   = [](const std::string& s) { return s == "c" ? 4.0 : 1.0; };
+    for(int i = 0; i < 40; ++i) {
+        EXPECT_EQ(util::Randomizer::pick_weighted(elements, weight, block.next(gen)),
+                  util::Randomizer::pick_weighted(copy, elements, weight));
+    }
+}
@@ -0,0 +1,42 @@
+//
+// Created by red on 05/01/19.
+//
+
+#include "../../main/util/ThreadPool.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace autoplay;
+
+TEST(ThreadPoolStandard, ThreadPoolTasks) {
+    util::ThreadPool pool{4};
+    EXPECT_EQ(pool.size(), 4);
+
+    std::atomic<int> count{0};
+    for(int i = 0; i < 100; ++i) {
+        pool.enqueue([&count, &pool]() {
+            ++count;
+            // Tasks may add new tasks
+            pool.enqueue([&count]() { ++count; });
+        });
+    }
+    pool.wait();
+    EXPECT_EQ(count, 200);
+}
+
+TEST(ThreadPoolStandard, ThreadPoolExceptions) {
+    util::ThreadPool pool{2};
+
+    std::atomic<int> count{0};
+    pool.enqueue([]() { throw std::runtime_error("failure"); });
+    for(int i = 0; i < 10; ++i) {
+        pool.enqueue([&count]() { ++count; });
+    }
+    EXPECT_THROW(pool.wait(), std::runtime_error);
+    EXPECT_EQ(count, 10);
+
+    // The exception is only thrown once
+    EXPECT_NO_THROW(pool.wait());
+}